@@ -0,0 +1,284 @@
+/**
+ * @file acervo.c
+ *
+ * @brief Acervo compacto de partidas gravadas.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "acervo.h"
+
+// maior tamanho de uma partida codificada: identificador, número de jogadas e 6 bits por jogada
+#define MAX_BYTES_PARTIDA (TAM_ID_DISTRIBUICAO + 8 + MAX_JOGADAS_ACERVO)
+
+// escreve bits em um vetor de bytes, do bit menos significativo para o mais
+typedef struct {
+  uint8_t *bytes;
+  int n_bytes;
+  uint64_t acumulado;
+  int n_bits;
+} escritor_bits_t;
+
+// lê bits na mesma ordem em que o escritor gravou
+typedef struct {
+  const uint8_t *bytes;
+  int n_bytes;
+  int posicao;
+  uint64_t acumulado;
+  int n_bits;
+} leitor_bits_t;
+
+// bits necessários para escrever um número de 0 a n - 1
+static int bits_para(int n)
+{
+  return n <= 1 ? 0 : 64 - __builtin_clzll(n - 1);
+}
+
+static void escreve_bits(escritor_bits_t *e, uint64_t valor, int n_bits)
+{
+  e->acumulado |= valor << e->n_bits;
+  e->n_bits += n_bits;
+  while (e->n_bits >= 8) {
+    e->bytes[e->n_bytes++] = e->acumulado;
+    e->acumulado >>= 8;
+    e->n_bits -= 8;
+  }
+}
+
+// completa o último byte com zeros
+static void termina_bits(escritor_bits_t *e)
+{
+  if (e->n_bits > 0)
+    e->bytes[e->n_bytes++] = e->acumulado;
+  e->acumulado = 0;
+  e->n_bits = 0;
+}
+
+static bool le_bits(leitor_bits_t *l, int n_bits, uint64_t *valor)
+{
+  while (l->n_bits < n_bits) {
+    if (l->posicao >= l->n_bytes) return false;
+    l->acumulado |= (uint64_t)l->bytes[l->posicao++] << l->n_bits;
+    l->n_bits += 8;
+  }
+  *valor = l->acumulado & ((1ULL << n_bits) - 1);
+  l->acumulado >>= n_bits;
+  l->n_bits -= n_bits;
+  return true;
+}
+
+// número inteiro em 7 bits por byte, com o bit alto indicando que há mais bytes
+static void escreve_numero(escritor_bits_t *e, uint64_t valor)
+{
+  while (valor >= 0x80) {
+    escreve_bits(e, (valor & 0x7f) | 0x80, 8);
+    valor >>= 7;
+  }
+  escreve_bits(e, valor, 8);
+}
+
+static bool le_numero(leitor_bits_t *l, uint64_t *valor)
+{
+  *valor = 0;
+  for (int deslocamento = 0; deslocamento < 64; deslocamento += 7) {
+    uint64_t byte;
+    if (!le_bits(l, 8, &byte)) return false;
+    *valor |= (byte & 0x7f) << deslocamento;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+// o mesmo número, direto do arquivo
+static bool le_numero_arquivo(acervo_t *a, uint64_t *valor)
+{
+  *valor = 0;
+  for (int deslocamento = 0; deslocamento < 64; deslocamento += 7) {
+    int byte = fgetc(a->arq);
+    if (byte == EOF) return false;
+    a->total_bytes++;
+    *valor |= (uint64_t)(byte & 0x7f) << deslocamento;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+// prepara os campos comuns à gravação e à leitura
+static bool inicia_acervo(acervo_t *a, FILE *arq, bool gravando)
+{
+  memset(a, 0, sizeof(*a));
+  a->arq = arq;
+  a->gravando = gravando;
+  a->jogo = malloc(sizeof(jogo_t));
+  if (a->jogo == NULL) return false;
+  a->jogo->relogio = NULL;
+  return true;
+}
+
+bool cria_acervo(acervo_t *a, const char *nome)
+{
+  FILE *arq = fopen(nome, "wb");
+  if (arq == NULL) return false;
+  if (!inicia_acervo(a, arq, true)) {
+    fclose(arq);
+    return false;
+  }
+  memcpy(a->cabecalho.marca, MARCA_ACERVO, sizeof(a->cabecalho.marca));
+  a->cabecalho.versao = VERSAO_ACERVO;
+  a->cabecalho.partidas_por_bloco = PARTIDAS_POR_BLOCO;
+  // o cabeçalho definitivo é gravado por fecha_acervo()
+  return fwrite(&a->cabecalho, sizeof(a->cabecalho), 1, arq) == 1;
+}
+
+bool grava_partida(acervo_t *a, const id_distribuicao_t *id, const jogada_t *jogadas, int n_jogadas)
+{
+  if (n_jogadas > MAX_JOGADAS_ACERVO || !inicia_pilhas_jogo_com_id(a->jogo, id))
+    return false;
+
+  uint8_t bytes[MAX_BYTES_PARTIDA];
+  escritor_bits_t e = {bytes, 0, 0, 0};
+  for (int i = 0; i < TAM_ID_DISTRIBUICAO; i++)
+    escreve_bits(&e, id->bytes[i], 8);
+  escreve_numero(&e, n_jogadas);
+
+  // cada jogada vira a sua posição na lista de jogadas possíveis
+  jogada_t possiveis[N_MAX_JOGADAS];
+  uint64_t bits_jogadas = 0;
+  for (int k = 0; k < n_jogadas; k++) {
+    int n = gera_jogadas(a->jogo, possiveis);
+    int i = 0;
+    while (i < n && (possiveis[i].origem != jogadas[k].origem || possiveis[i].destino != jogadas[k].destino
+                     || possiveis[i].n_cartas != jogadas[k].n_cartas))
+      i++;
+    if (i == n) return false;
+    escreve_bits(&e, i, bits_para(n));
+    bits_jogadas += bits_para(n);
+    aplica_jogada(a->jogo, possiveis[i]);
+  }
+  termina_bits(&e);
+
+  // um novo bloco começa a cada PARTIDAS_POR_BLOCO partidas
+  bool novo_bloco = a->cabecalho.n_partidas % PARTIDAS_POR_BLOCO == 0;
+  if (novo_bloco && a->n_blocos == a->capacidade_blocos) {
+    a->capacidade_blocos = a->capacidade_blocos * 2 + 16;
+    uint64_t *blocos = realloc(a->blocos, a->capacidade_blocos * sizeof(uint64_t));
+    if (blocos == NULL) return false;
+    a->blocos = blocos;
+  }
+  long posicao = ftell(a->arq);
+  if (posicao < 0) return false;
+
+  uint8_t tamanho[10];
+  escritor_bits_t et = {tamanho, 0, 0, 0};
+  escreve_numero(&et, e.n_bytes);
+  if (fwrite(tamanho, et.n_bytes, 1, a->arq) != 1 || fwrite(bytes, e.n_bytes, 1, a->arq) != 1) {
+    // a partida não entra no acervo: a próxima é escrita por cima do que sobrou desta
+    fseek(a->arq, posicao, SEEK_SET);
+    return false;
+  }
+
+  // o bloco só entra no índice depois que a sua primeira partida foi escrita
+  if (novo_bloco)
+    a->blocos[a->n_blocos++] = posicao;
+
+  a->cabecalho.n_partidas++;
+  a->total_jogadas += n_jogadas;
+  a->total_bits_jogadas += bits_jogadas;
+  a->total_bytes += et.n_bytes + e.n_bytes;
+  return true;
+}
+
+bool abre_acervo(acervo_t *a, const char *nome)
+{
+  FILE *arq = fopen(nome, "rb");
+  if (arq == NULL) return false;
+  if (!inicia_acervo(a, arq, false)) {
+    fclose(arq);
+    return false;
+  }
+
+  cabecalho_acervo_t *c = &a->cabecalho;
+  bool ok = fread(c, sizeof(*c), 1, arq) == 1 && memcmp(c->marca, MARCA_ACERVO, sizeof(c->marca)) == 0
+         && c->versao == VERSAO_ACERVO && c->partidas_por_bloco > 0;
+  if (ok) {
+    a->n_blocos = (c->n_partidas + c->partidas_por_bloco - 1) / c->partidas_por_bloco;
+    a->blocos = malloc((a->n_blocos + 1) * sizeof(uint64_t));
+    ok = a->blocos != NULL && fseek(arq, c->posicao_indice, SEEK_SET) == 0
+      && fread(a->blocos, sizeof(uint64_t), a->n_blocos, arq) == a->n_blocos
+      && fseek(arq, sizeof(*c), SEEK_SET) == 0;
+  }
+  if (!ok) {
+    a->gravando = false;
+    fecha_acervo(a);
+  }
+  return ok;
+}
+
+bool le_partida(acervo_t *a, id_distribuicao_t *id, jogada_t *jogadas, int *n_jogadas)
+{
+  uint64_t tamanho, n;
+  uint8_t bytes[MAX_BYTES_PARTIDA];
+  if (a->atual >= a->cabecalho.n_partidas || !le_numero_arquivo(a, &tamanho)
+      || tamanho > sizeof(bytes) || fread(bytes, tamanho, 1, a->arq) != 1)
+    return false;
+  a->atual++;
+  a->total_bytes += tamanho;
+
+  leitor_bits_t l = {bytes, tamanho, 0, 0, 0};
+  for (int i = 0; i < TAM_ID_DISTRIBUICAO; i++) {
+    uint64_t byte;
+    if (!le_bits(&l, 8, &byte)) return false;
+    id->bytes[i] = byte;
+  }
+  if (!le_numero(&l, &n) || n > MAX_JOGADAS_ACERVO || !inicia_pilhas_jogo_com_id(a->jogo, id))
+    return false;
+
+  // refaz a partida, trocando cada posição pela jogada da lista de possíveis
+  jogada_t possiveis[N_MAX_JOGADAS];
+  for (int k = 0; k < (int)n; k++) {
+    int n_possiveis = gera_jogadas(a->jogo, possiveis);
+    uint64_t i;
+    if (!le_bits(&l, bits_para(n_possiveis), &i) || (int)i >= n_possiveis)
+      return false;
+    jogadas[k] = possiveis[i];
+    aplica_jogada(a->jogo, possiveis[i]);
+    a->total_bits_jogadas += bits_para(n_possiveis);
+  }
+  *n_jogadas = n;
+  a->total_jogadas += n;
+  return true;
+}
+
+bool procura_partida(acervo_t *a, uint64_t indice)
+{
+  if (indice >= a->cabecalho.n_partidas) return false;
+  uint64_t bloco = indice / a->cabecalho.partidas_por_bloco;
+  if (fseek(a->arq, a->blocos[bloco], SEEK_SET) != 0) return false;
+  a->atual = bloco * a->cabecalho.partidas_por_bloco;
+  // pula as partidas anteriores do bloco sem decodificá-las
+  while (a->atual < indice) {
+    uint64_t tamanho;
+    if (!le_numero_arquivo(a, &tamanho) || fseek(a->arq, tamanho, SEEK_CUR) != 0)
+      return false;
+    a->atual++;
+  }
+  return true;
+}
+
+bool fecha_acervo(acervo_t *a)
+{
+  bool ok = true;
+  if (a->gravando) {
+    a->cabecalho.posicao_indice = ftell(a->arq);
+    ok = fwrite(a->blocos, sizeof(uint64_t), a->n_blocos, a->arq) == a->n_blocos
+      && fseek(a->arq, 0, SEEK_SET) == 0
+      && fwrite(&a->cabecalho, sizeof(a->cabecalho), 1, a->arq) == 1;
+  }
+  ok = (fclose(a->arq) == 0) && ok;
+  free(a->blocos);
+  free(a->jogo);
+  a->arq = NULL;
+  a->blocos = NULL;
+  a->jogo = NULL;
+  return ok;
+}
@@ -0,0 +1,117 @@
+#ifndef ACERVO_H
+#define ACERVO_H
+
+/**
+ * @file acervo.h
+ *
+ * @brief Acervo compacto de partidas gravadas.
+ *
+ * Cada jogada é guardada como a sua posição na lista de jogadas possíveis, na
+ * ordem de gera_jogadas(), usando só os bits necessários para aquela lista
+ * (com 20 jogadas possíveis, 5 bits; com uma só, nenhum). Os bits de uma partida
+ * são empacotados juntos, depois do identificador da distribuição e do número de
+ * jogadas. Para decodificar, a partida é refeita desde a distribuição.
+ *
+ * As partidas são agrupadas em blocos; um índice no fim do arquivo guarda onde
+ * cada bloco começa, e cada partida começa pelo seu tamanho em bytes, então para
+ * chegar a qualquer partida basta ir ao bloco dela e pular as anteriores.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+#include "permutacao.h"
+
+#define MARCA_ACERVO "KLACERV1"
+#define VERSAO_ACERVO 1
+#define PARTIDAS_POR_BLOCO 1024
+// número máximo de jogadas de uma partida gravada
+#define MAX_JOGADAS_ACERVO 4096
+
+// cabeçalho do arquivo (32 bytes)
+typedef struct {
+  char marca[8];
+  uint32_t versao;
+  uint32_t partidas_por_bloco;
+  uint64_t n_partidas;
+  // onde começa o índice dos blocos, no fim do arquivo
+  uint64_t posicao_indice;
+} cabecalho_acervo_t;
+
+// acervo aberto para gravar ou para ler
+typedef struct {
+  FILE *arq;
+  bool gravando;
+  cabecalho_acervo_t cabecalho;
+  // início de cada bloco no arquivo
+  uint64_t *blocos;
+  uint64_t n_blocos;
+  uint64_t capacidade_blocos;
+  // próxima partida a ler
+  uint64_t atual;
+  // jogo usado para refazer as partidas
+  jogo_t *jogo;
+  // totais das partidas gravadas ou lidas
+  uint64_t total_jogadas;
+  uint64_t total_bits_jogadas;
+  uint64_t total_bytes;
+} acervo_t;
+
+/**
+ * @brief Cria um acervo vazio para gravação.
+ *
+ * @param a Ponteiro para o acervo.
+ * @param nome Nome do arquivo.
+ * @return true se o arquivo foi criado, false caso contrário.
+ */
+bool cria_acervo(acervo_t *a, const char *nome);
+
+/**
+ * @brief Grava uma partida no fim do acervo.
+ *
+ * @param a Ponteiro para o acervo aberto por cria_acervo().
+ * @param id Identificador da distribuição inicial.
+ * @param jogadas As jogadas da partida, em ordem.
+ * @param n_jogadas Número de jogadas (no máximo MAX_JOGADAS_ACERVO).
+ * @return true se a partida foi gravada, false se alguma jogada não é possível ou houve erro de escrita.
+ */
+bool grava_partida(acervo_t *a, const id_distribuicao_t *id, const jogada_t *jogadas, int n_jogadas);
+
+/**
+ * @brief Abre um acervo existente para leitura, a partir da primeira partida.
+ *
+ * @param a Ponteiro para o acervo.
+ * @param nome Nome do arquivo.
+ * @return true se o arquivo é um acervo válido, false caso contrário.
+ */
+bool abre_acervo(acervo_t *a, const char *nome);
+
+/**
+ * @brief Lê a próxima partida do acervo.
+ *
+ * @param a Ponteiro para o acervo aberto por abre_acervo().
+ * @param id Ponteiro para o identificador da distribuição inicial.
+ * @param jogadas Vetor com espaço para MAX_JOGADAS_ACERVO jogadas.
+ * @param n_jogadas Ponteiro para o número de jogadas.
+ * @return true se leu uma partida, false no fim do acervo ou se o arquivo está corrompido.
+ */
+bool le_partida(acervo_t *a, id_distribuicao_t *id, jogada_t *jogadas, int *n_jogadas);
+
+/**
+ * @brief Posiciona a leitura na partida de número dado (a partir de 0).
+ *
+ * @param a Ponteiro para o acervo aberto por abre_acervo().
+ * @param indice Número da partida.
+ * @return true se a partida existe, false caso contrário.
+ */
+bool procura_partida(acervo_t *a, uint64_t indice);
+
+/**
+ * @brief Fecha o acervo; se estava gravando, grava o índice dos blocos e o cabeçalho.
+ *
+ * @param a Ponteiro para o acervo.
+ * @return true se tudo foi gravado, false caso contrário.
+ */
+bool fecha_acervo(acervo_t *a);
+
+#endif // ACERVO_H
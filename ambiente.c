@@ -0,0 +1,135 @@
+/**
+ * @file ambiente.c
+ *
+ * @brief Lotes de partidas para treinar agentes por reforço.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "ambiente.h"
+
+bool cria_ambientes(lote_ambientes_t *l, int n, int max_passos, int max_reciclagens)
+{
+  l->n = n;
+  l->max_passos = max_passos;
+  l->max_reciclagens = max_reciclagens;
+  l->jogos = malloc(n * sizeof(jogo_t));
+  l->cartas_acao = malloc(n * N_ACOES * sizeof(int8_t));
+  l->passos = malloc(n * sizeof(int));
+  l->reciclagens = malloc(n * sizeof(int));
+  l->fim = malloc(n * sizeof(uint8_t));
+  if (l->jogos == NULL || l->cartas_acao == NULL || l->passos == NULL || l->reciclagens == NULL || l->fim == NULL) {
+    termina_ambientes(l);
+    return false;
+  }
+  for (int i = 0; i < n; i++)
+    l->jogos[i].relogio = NULL;
+  return true;
+}
+
+// escreve a observação de uma partida
+static void observa(jogo_t *j, uint8_t *obs)
+{
+  memset(obs, 0, N_ESPACOS_OBSERVACAO * N_MAX_CARTAS);
+  for (int p = 0; p < N_PILHAS_PRINCIPAIS; p++) {
+    pilha_t *pilha = &j->pilhas_principais[p];
+    int abertas = pilha->n_cartas - pilha->n_cartas_fechadas;
+    if (abertas > ESPACOS_ABERTOS) abertas = ESPACOS_ABERTOS;
+    for (int s = 0; s < abertas; s++)
+      obs[(p * ESPACOS_ABERTOS + s) * N_MAX_CARTAS + indice_carta(pilha->cartas[pilha->n_cartas_fechadas + s])] = 1;
+  }
+  int espaco = N_PILHAS_PRINCIPAIS * ESPACOS_ABERTOS;
+  for (int i = 0; i < N_PILHAS_SAIDA; i++, espaco++)
+    if (j->derivados.topo[PILHA_SAIDA + i] >= 0)
+      obs[espaco * N_MAX_CARTAS + j->derivados.topo[PILHA_SAIDA + i]] = 1;
+  if (j->derivados.topo[PILHA_DESCARTE] >= 0)
+    obs[espaco * N_MAX_CARTAS + j->derivados.topo[PILHA_DESCARTE]] = 1;
+
+  uint8_t *contagens = obs + N_ESPACOS_OBSERVACAO * N_MAX_CARTAS;
+  for (int p = 0; p < N_PILHAS_PRINCIPAIS; p++)
+    contagens[p] = j->pilhas_principais[p].n_cartas_fechadas;
+  contagens[N_PILHAS_PRINCIPAIS] = j->monte.n_cartas;
+  contagens[N_PILHAS_PRINCIPAIS + 1] = j->descarte.n_cartas;
+}
+
+// calcula as ações possíveis de uma partida; retorna quantas são
+static int calcula_acoes(lote_ambientes_t *l, int i, uint8_t *mascara)
+{
+  jogada_t jogadas[N_MAX_JOGADAS];
+  int8_t *cartas = l->cartas_acao + (size_t)i * N_ACOES;
+  int n = gera_jogadas(&l->jogos[i], jogadas);
+  int possiveis = 0;
+
+  memset(cartas, -1, N_ACOES);
+  memset(mascara, 0, N_ACOES);
+  for (int k = 0; k < n; k++) {
+    if (jogadas[k].origem == PILHA_DESCARTE && jogadas[k].destino == PILHA_MONTE
+        && l->reciclagens[i] >= l->max_reciclagens)
+      continue;
+    int a = jogadas[k].origem * N_PILHAS + jogadas[k].destino;
+    cartas[a] = jogadas[k].n_cartas;
+    mascara[a] = 1;
+    possiveis++;
+  }
+  return possiveis;
+}
+
+void reinicia_ambiente(lote_ambientes_t *l, int i, uint64_t semente, uint8_t *observacoes, uint8_t *mascaras)
+{
+  jogo_t *j = &l->jogos[i];
+  inicia_pilhas_jogo_com_semente(j, semente);
+  l->passos[i] = 0;
+  l->reciclagens[i] = 0;
+  l->fim[i] = em_curso;
+  observa(j, observacoes + (size_t)i * TAM_OBSERVACAO);
+  if (calcula_acoes(l, i, mascaras + (size_t)i * N_ACOES) == 0)
+    l->fim[i] = interrompida;
+}
+
+void reinicia_ambientes(lote_ambientes_t *l, const uint64_t *sementes, uint8_t *observacoes, uint8_t *mascaras)
+{
+  for (int i = 0; i < l->n; i++)
+    reinicia_ambiente(l, i, sementes[i], observacoes, mascaras);
+}
+
+void passo_ambientes(lote_ambientes_t *l, const int *acoes, uint8_t *observacoes, uint8_t *mascaras,
+                     float *recompensas, uint8_t *fins)
+{
+  for (int i = 0; i < l->n; i++) {
+    jogo_t *j = &l->jogos[i];
+    recompensas[i] = 0;
+    if (l->fim[i] != em_curso) {
+      fins[i] = l->fim[i];
+      continue;
+    }
+
+    int a = acoes[i];
+    if (a >= 0 && a < N_ACOES && l->cartas_acao[(size_t)i * N_ACOES + a] >= 0) {
+      jogada_t jg = { a / N_PILHAS, a % N_PILHAS, l->cartas_acao[(size_t)i * N_ACOES + a] };
+      if (jg.origem == PILHA_DESCARTE && jg.destino == PILHA_MONTE)
+        l->reciclagens[i]++;
+      double antes = j->pontos;
+      aplica_jogada(j, jg);
+      recompensas[i] = j->pontos - antes;
+    }
+    l->passos[i]++;
+
+    observa(j, observacoes + (size_t)i * TAM_OBSERVACAO);
+    int possiveis = calcula_acoes(l, i, mascaras + (size_t)i * N_ACOES);
+    if (venceu_jogo(j))
+      l->fim[i] = vitoria;
+    else if (possiveis == 0 || l->passos[i] >= l->max_passos)
+      l->fim[i] = interrompida;
+    fins[i] = l->fim[i];
+  }
+}
+
+void termina_ambientes(lote_ambientes_t *l)
+{
+  free(l->jogos);
+  free(l->cartas_acao);
+  free(l->passos);
+  free(l->reciclagens);
+  free(l->fim);
+  memset(l, 0, sizeof(*l));
+}
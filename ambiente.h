@@ -0,0 +1,117 @@
+#ifndef AMBIENTE_H
+#define AMBIENTE_H
+
+/**
+ * @file ambiente.h
+ *
+ * @brief Lotes de partidas para treinar agentes por reforço.
+ *
+ * Um lote avança N partidas independentes a cada chamada. Os dados de cada
+ * partida ficam em vetores separados por campo (jogos, passos, reciclagens,
+ * jogadas possíveis), alocados uma vez em cria_ambientes(); reiniciar e avançar
+ * não alocam memória e escrevem as observações, as máscaras de ações possíveis,
+ * as recompensas e o fim das partidas em vetores do chamador.
+ *
+ * Observação (TAM_OBSERVACAO bytes por partida): um vetor one-hot de
+ * N_MAX_CARTAS posições para cada espaço visível (as ESPACOS_ABERTOS cartas
+ * abertas de cada pilha principal, do fundo para o topo, o topo de cada pilha de
+ * saída e o topo do descarte), seguido das contagens de cartas fechadas de cada
+ * pilha principal e das cartas do monte e do descarte.
+ *
+ * Ação: origem * N_PILHAS + destino, com os índices de pilha de pilha_do_jogo().
+ * Cada par origem/destino tem no máximo uma jogada em gera_jogadas(), então as
+ * N_ACOES ações cobrem todas as jogadas.
+ *
+ * O lote não usa threads; para usar vários núcleos, crie um lote por thread.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+
+// cartas abertas de uma pilha principal que cabem na observação (uma sequência de rei a ás)
+#define ESPACOS_ABERTOS 13
+// espaços visíveis da observação: cartas abertas das principais, topos das saídas e do descarte
+#define N_ESPACOS_OBSERVACAO (N_PILHAS_PRINCIPAIS * ESPACOS_ABERTOS + N_PILHAS_SAIDA + 1)
+// contagens da observação: fechadas de cada principal, monte e descarte
+#define N_CONTAGENS_OBSERVACAO (N_PILHAS_PRINCIPAIS + 2)
+#define TAM_OBSERVACAO (N_ESPACOS_OBSERVACAO * N_MAX_CARTAS + N_CONTAGENS_OBSERVACAO)
+#define N_ACOES (N_PILHAS * N_PILHAS)
+
+// como terminou a partida de um ambiente após um passo
+typedef enum {
+  em_curso,
+  vitoria,
+  // sem jogadas possíveis ou com o número máximo de passos
+  interrompida
+} fim_ambiente_t;
+
+// lote de partidas, com cada campo em um vetor de n posições
+typedef struct {
+  int n;
+  int max_passos;
+  int max_reciclagens;
+  jogo_t *jogos;
+  // quantas cartas a jogada de cada ação move, -1 se a ação não é possível (n * N_ACOES)
+  int8_t *cartas_acao;
+  int *passos;
+  int *reciclagens;
+  uint8_t *fim;
+} lote_ambientes_t;
+
+/**
+ * @brief Aloca um lote de partidas.
+ *
+ * @param l Ponteiro para o lote.
+ * @param n Número de partidas.
+ * @param max_passos Passos depois dos quais uma partida é interrompida.
+ * @param max_reciclagens Vezes que o descarte pode voltar ao monte em cada partida.
+ * @return true se o lote foi alocado, false caso contrário.
+ */
+bool cria_ambientes(lote_ambientes_t *l, int n, int max_passos, int max_reciclagens);
+
+/**
+ * @brief Reinicia todas as partidas do lote.
+ *
+ * @param l Ponteiro para o lote.
+ * @param sementes As n sementes das distribuições.
+ * @param observacoes Vetor com n * TAM_OBSERVACAO bytes.
+ * @param mascaras Vetor com n * N_ACOES bytes, 1 nas ações possíveis e 0 nas demais.
+ */
+void reinicia_ambientes(lote_ambientes_t *l, const uint64_t *sementes, uint8_t *observacoes, uint8_t *mascaras);
+
+/**
+ * @brief Reinicia uma partida do lote, por exemplo depois que ela terminou.
+ *
+ * @param l Ponteiro para o lote.
+ * @param i Índice da partida.
+ * @param semente Semente da distribuição.
+ * @param observacoes Vetor de observações do lote inteiro (só a posição i é escrita).
+ * @param mascaras Vetor de máscaras do lote inteiro (só a posição i é escrita).
+ */
+void reinicia_ambiente(lote_ambientes_t *l, int i, uint64_t semente, uint8_t *observacoes, uint8_t *mascaras);
+
+/**
+ * @brief Realiza uma ação em cada partida do lote.
+ *
+ * Ações não possíveis não mudam a partida (recompensa 0, mas contam como passo).
+ * Partidas já terminadas não mudam até serem reiniciadas.
+ *
+ * @param l Ponteiro para o lote.
+ * @param acoes As n ações.
+ * @param observacoes Vetor com n * TAM_OBSERVACAO bytes.
+ * @param mascaras Vetor com n * N_ACOES bytes.
+ * @param recompensas Vetor com n posições, com os pontos ganhos no passo.
+ * @param fins Vetor com n posições, com um fim_ambiente_t para cada partida.
+ */
+void passo_ambientes(lote_ambientes_t *l, const int *acoes, uint8_t *observacoes, uint8_t *mascaras,
+                     float *recompensas, uint8_t *fins);
+
+/**
+ * @brief Libera a memória do lote.
+ *
+ * @param l Ponteiro para o lote.
+ */
+void termina_ambientes(lote_ambientes_t *l);
+
+#endif // AMBIENTE_H
@@ -0,0 +1,285 @@
+/**
+ * @file arquiva.c
+ *
+ * @brief Grava e lê acervos compactos de partidas de klondike.
+ *
+ * Com -g joga partidas com a heurística gulosa, uma por semente, e grava todas no
+ * acervo, mostrando a taxa de compressão em relação aos comandos de texto (dois
+ * caracteres por jogada). Com -l lê o acervo inteiro, refazendo cada partida, e
+ * mostra a vazão da decodificação. Com -k mostra os comandos de uma partida,
+ * indo direto a ela pelo índice dos blocos. Com -r percorre uma partida pelos
+ * quadros-chave da reprodução, em saltos aleatórios, comparando cada posição com a
+ * partida refeita desde a distribuição. Sem opções, grava e depois lê.
+ *
+ * Uso: ./arquiva [-o arquivo] [-g partidas] [-s semente] [-l] [-k partida] [-r partida]
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "acervo.h"
+#include "reproducao.h"
+#include <unistd.h>
+
+#define MAX_RECICLAGENS_GRAVACAO 3
+// saltos aleatórios medidos por -r
+#define N_SALTOS 100000
+
+// relógio monotônico, em segundos
+static double agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// mistura as jogadas de uma partida em uma soma de conferência
+static uint64_t confere_jogadas(uint64_t soma, const jogada_t *jogadas, int n_jogadas)
+{
+  for (int i = 0; i < n_jogadas; i++)
+    soma = espalha_64(soma ^ ((uint64_t)jogadas[i].origem << 16 | (uint64_t)jogadas[i].destino << 8 | jogadas[i].n_cartas));
+  return soma;
+}
+
+// joga uma partida gulosa guardando as jogadas
+static int joga_partida(jogo_t *j, jogada_t *jogadas, gerador_t *g)
+{
+  jogada_t possiveis[N_MAX_JOGADAS];
+  int n = 0, reciclagens = 0;
+  while (n < MAX_JOGADAS_ACERVO && !venceu_jogo(j)) {
+    int n_possiveis = gera_jogadas(j, possiveis);
+    int i = escolhe_jogada_gulosa(j, possiveis, n_possiveis, MAX_RECICLAGENS_GRAVACAO - reciclagens, g);
+    if (i < 0) break;
+    if (possiveis[i].origem == PILHA_DESCARTE && possiveis[i].destino == PILHA_MONTE)
+      reciclagens++;
+    aplica_jogada(j, possiveis[i]);
+    jogadas[n++] = possiveis[i];
+  }
+  return n;
+}
+
+// grava partidas gulosas no acervo
+static bool grava(const char *nome, long n_partidas, uint64_t semente)
+{
+  acervo_t a;
+  if (!cria_acervo(&a, nome)) {
+    fprintf(stderr, "não foi possível criar o acervo %s\n", nome);
+    return false;
+  }
+  jogo_t *j = malloc(sizeof(jogo_t));
+  jogada_t *jogadas = malloc(MAX_JOGADAS_ACERVO * sizeof(jogada_t));
+  assert(j != NULL && jogadas != NULL);
+  j->relogio = NULL;
+  gerador_t g;
+  inicia_gerador(&g, semente);
+
+  uint64_t soma = 0;
+  double inicio = agora();
+  bool ok = true;
+  for (long k = 0; k < n_partidas && ok; k++) {
+    id_distribuicao_t id;
+    inicia_pilhas_jogo_com_semente(j, semente + k);
+    id_do_jogo(j, &id);
+    int n = joga_partida(j, jogadas, &g);
+    soma = confere_jogadas(soma, jogadas, n);
+    ok = grava_partida(&a, &id, jogadas, n);
+  }
+  double duracao = agora() - inicio;
+
+  uint64_t texto_jogadas = 2 * a.total_jogadas;
+  uint64_t texto_total = texto_jogadas + (uint64_t)TAM_ID_DISTRIBUICAO * a.cabecalho.n_partidas;
+  ok = fecha_acervo(&a) && ok;
+  printf("partidas gravadas: %llu (%llu jogadas)\n", (unsigned long long)a.cabecalho.n_partidas,
+         (unsigned long long)a.total_jogadas);
+  printf("bits/jogada:       %.2f\n", (double)a.total_bits_jogadas / a.total_jogadas);
+  printf("jogadas:           %.1f KiB, texto %.1f KiB (%.1fx menor)\n", a.total_bits_jogadas / 8192.0,
+         texto_jogadas / 1024.0, texto_jogadas * 8.0 / a.total_bits_jogadas);
+  printf("acervo:            %.1f KiB, texto %.1f KiB (%.1fx menor)\n", a.total_bytes / 1024.0,
+         texto_total / 1024.0, (double)texto_total / a.total_bytes);
+  printf("gravação:          %.3f s (%.0f partidas/s)\n", duracao, n_partidas / duracao);
+  printf("conferência:       %016llx\n", (unsigned long long)soma);
+
+  free(jogadas);
+  free(j);
+  return ok;
+}
+
+// lê o acervo inteiro, refazendo as partidas
+static bool le(const char *nome)
+{
+  acervo_t a;
+  if (!abre_acervo(&a, nome)) {
+    fprintf(stderr, "acervo inválido: %s\n", nome);
+    return false;
+  }
+  jogada_t *jogadas = malloc(MAX_JOGADAS_ACERVO * sizeof(jogada_t));
+  assert(jogadas != NULL);
+
+  id_distribuicao_t id;
+  int n;
+  uint64_t soma = 0, lidas = 0;
+  double inicio = agora();
+  while (le_partida(&a, &id, jogadas, &n)) {
+    soma = confere_jogadas(soma, jogadas, n);
+    lidas++;
+  }
+  double duracao = agora() - inicio;
+  bool ok = lidas == a.cabecalho.n_partidas;
+
+  printf("partidas lidas:    %llu de %llu\n", (unsigned long long)lidas, (unsigned long long)a.cabecalho.n_partidas);
+  printf("leitura:           %.3f s (%.0f partidas/s, %.0f jogadas/s, %.1f MiB/s)\n", duracao,
+         lidas / duracao, a.total_jogadas / duracao, a.total_bytes / duracao / (1024 * 1024));
+  printf("conferência:       %016llx\n", (unsigned long long)soma);
+
+  fecha_acervo(&a);
+  free(jogadas);
+  return ok;
+}
+
+// mostra os comandos de uma partida do acervo
+static bool mostra(const char *nome, uint64_t indice)
+{
+  acervo_t a;
+  if (!abre_acervo(&a, nome)) {
+    fprintf(stderr, "acervo inválido: %s\n", nome);
+    return false;
+  }
+  jogada_t *jogadas = malloc(MAX_JOGADAS_ACERVO * sizeof(jogada_t));
+  assert(jogadas != NULL);
+
+  id_distribuicao_t id;
+  int n;
+  bool ok = procura_partida(&a, indice) && le_partida(&a, &id, jogadas, &n);
+  if (ok) {
+    char texto[TAM_TEXTO_ID + 1], comando[MAX_CHAR_CMD+1];
+    id_para_texto(&id, texto);
+    printf("distribuição %s, %d jogadas%s\n", texto, n, venceu_jogo(a.jogo) ? ", vitória" : "");
+    for (int k = 0; k < n; k++) {
+      descricao_jogada(jogadas[k], comando);
+      printf("%s%c", comando, (k + 1) % 20 == 0 || k + 1 == n ? '\n' : ' ');
+    }
+  } else {
+    fprintf(stderr, "partida %llu não encontrada\n", (unsigned long long)indice);
+  }
+
+  fecha_acervo(&a);
+  free(jogadas);
+  return ok;
+}
+
+// salta para posições aleatórias de uma partida, comparando com a partida refeita desde o início
+static bool percorre(const char *nome, uint64_t indice)
+{
+  acervo_t a;
+  if (!abre_acervo(&a, nome)) {
+    fprintf(stderr, "acervo inválido: %s\n", nome);
+    return false;
+  }
+  jogada_t *jogadas = malloc(MAX_JOGADAS_ACERVO * sizeof(jogada_t));
+  jogo_t *inicial = malloc(sizeof(jogo_t));
+  jogo_t *refeito = malloc(sizeof(jogo_t));
+  assert(jogadas != NULL && inicial != NULL && refeito != NULL);
+  inicial->relogio = NULL;
+
+  id_distribuicao_t id;
+  int n;
+  reproducao_t r;
+  bool ok = procura_partida(&a, indice) && le_partida(&a, &id, jogadas, &n)
+            && inicia_pilhas_jogo_com_id(inicial, &id) && inicia_reproducao(&r, inicial, jogadas, n);
+  fecha_acervo(&a);
+  if (!ok) {
+    fprintf(stderr, "partida %llu não encontrada\n", (unsigned long long)indice);
+    free(refeito);
+    free(inicial);
+    free(jogadas);
+    return false;
+  }
+
+  // confere todas as posições contra a partida refeita jogada a jogada, de trás para a frente
+  int erros = 0;
+  jogo_compacto_t c1, c2;
+  for (int k = n; k >= 0; k--) {
+    *refeito = *inicial;
+    for (int i = 0; i < k; i++)
+      aplica_jogada(refeito, jogadas[i]);
+    vai_para_jogada(&r, k);
+    compacta_jogo(refeito, &c1);
+    compacta_jogo(r.jogo, &c2);
+    if (memcmp(&c1, &c2, sizeof(c1)) != 0 || refeito->pontos != r.jogo->pontos)
+      erros++;
+  }
+
+  // mede saltos aleatórios, como os de quem arrasta a reprodução para lá e para cá
+  gerador_t g;
+  inicia_gerador(&g, indice);
+  double pior = 0;
+  uint64_t soma = 0;
+  double inicio = agora();
+  for (int k = 0; k < N_SALTOS; k++) {
+    double t = agora();
+    vai_para_jogada(&r, sorteia_64(&g) % (n + 1));
+    t = agora() - t;
+    if (t > pior) pior = t;
+    soma += r.jogo->derivados.pilhas_vazias;
+  }
+  double duracao = agora() - inicio;
+
+  // o mesmo salto sem quadros-chave custa refazer a partida desde a distribuição
+  inicio = agora();
+  for (int k = 0; k < N_SALTOS / 100; k++) {
+    *refeito = *inicial;
+    int alvo = sorteia_64(&g) % (n + 1);
+    for (int i = 0; i < alvo; i++)
+      aplica_jogada(refeito, jogadas[i]);
+    soma += refeito->derivados.pilhas_vazias;
+  }
+  double sem_quadros = (agora() - inicio) / (N_SALTOS / 100);
+
+  printf("partida:           %llu (%d jogadas, %d quadros-chave a cada %d)\n", (unsigned long long)indice, n,
+         r.n_quadros, INTERVALO_QUADROS_CHAVE);
+  printf("posições erradas:  %d de %d\n", erros, n + 1);
+  printf("saltos:            %.0f/s (média %.2f us, pior %.2f us)\n", N_SALTOS / duracao,
+         duracao / N_SALTOS * 1e6, pior * 1e6);
+  printf("sem quadros-chave: %.2f us por salto\n", sem_quadros * 1e6);
+  printf("conferência:       %016llx\n", (unsigned long long)soma);
+
+  termina_reproducao(&r);
+  free(refeito);
+  free(inicial);
+  free(jogadas);
+  return erros == 0;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *nome = "partidas.acervo";
+  long n_partidas = 0;
+  uint64_t semente = 1;
+  bool le_tudo = false;
+  long long indice = -1, reproduz = -1;
+  int opcao;
+
+  while ((opcao = getopt(argc, argv, "o:g:s:lk:r:")) != -1) {
+    switch (opcao) {
+      case 'o': nome = optarg; break;
+      case 'g': n_partidas = atol(optarg); break;
+      case 's': semente = strtoull(optarg, NULL, 10); break;
+      case 'l': le_tudo = true; break;
+      case 'k': indice = atoll(optarg); break;
+      case 'r': reproduz = atoll(optarg); break;
+      default:
+        fprintf(stderr, "uso: %s [-o arquivo] [-g partidas] [-s semente] [-l] [-k partida] [-r partida]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (n_partidas == 0 && !le_tudo && indice < 0 && reproduz < 0) {
+    n_partidas = 100000;
+    le_tudo = true;
+  }
+
+  bool ok = true;
+  if (n_partidas > 0) ok = grava(nome, n_partidas, semente) && ok;
+  if (le_tudo) ok = le(nome) && ok;
+  if (indice >= 0) ok = mostra(nome, indice) && ok;
+  if (reproduz >= 0) ok = percorre(nome, reproduz) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file autojogo.c
+ *
+ * @brief Robô que joga partidas completas de klondike sem janela.
+ *
+ * Joga muitas partidas seguidas com a heurística gulosa (escolhe_jogada_gulosa) e
+ * informa partidas por segundo, taxa de vitória e média de jogadas. Serve como
+ * medida de desempenho das regras do jogo e como base de comparação para
+ * resolvedores.
+ *
+ * Uso: ./autojogo [-n partidas] [-s semente] [-r reciclagens] [-c]
+ *   -c faz as jogadas pelo comando de texto (realiza_jogada), como o jogador faria.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+#include <unistd.h>
+
+#define MAX_JOGADAS_PARTIDA 1000
+
+// relógio monotônico, em segundos
+static double agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// joga uma partida usando os comandos de texto, como partida_gulosa faz com aplica_jogada
+static int partida_gulosa_por_comandos(jogo_t *j, int max_jogadas, int max_reciclagens, gerador_t *g)
+{
+  jogada_t jogadas[N_MAX_JOGADAS];
+  char comando[MAX_CHAR_CMD+1];
+  int n_realizadas = 0;
+  int n_reciclagens = 0;
+
+  while (n_realizadas < max_jogadas && !venceu_jogo(j)) {
+    int n_jogadas = gera_jogadas(j, jogadas);
+    int i = escolhe_jogada_gulosa(j, jogadas, n_jogadas, max_reciclagens - n_reciclagens, g);
+    if (i < 0) break;
+    if (jogadas[i].origem == PILHA_DESCARTE && jogadas[i].destino == PILHA_MONTE)
+      n_reciclagens++;
+    descricao_jogada(jogadas[i], comando);
+    realiza_jogada(j, comando);
+    n_realizadas++;
+  }
+
+  return n_realizadas;
+}
+
+int main(int argc, char *argv[])
+{
+  int n_partidas = 100000;
+  uint64_t semente = 1;
+  int max_reciclagens = 3;
+  bool por_comandos = false;
+  int opcao;
+
+  while ((opcao = getopt(argc, argv, "n:s:r:c")) != -1) {
+    switch (opcao) {
+      case 'n': n_partidas = atoi(optarg); break;
+      case 's': semente = strtoull(optarg, NULL, 10); break;
+      case 'r': max_reciclagens = atoi(optarg); break;
+      case 'c': por_comandos = true; break;
+      default:
+        fprintf(stderr, "uso: %s [-n partidas] [-s semente] [-r reciclagens] [-c]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  jogo_t *j = malloc(sizeof(jogo_t));
+  assert(j != NULL);
+  j->relogio = NULL;
+  gerador_t g;
+  inicia_gerador(&g, semente);
+
+  int vitorias = 0;
+  long total_jogadas = 0;
+  double inicio = agora();
+
+  for (int i = 0; i < n_partidas; i++) {
+    inicia_pilhas_jogo_com_semente(j, semente + i);
+    if (por_comandos)
+      total_jogadas += partida_gulosa_por_comandos(j, MAX_JOGADAS_PARTIDA, max_reciclagens, &g);
+    else
+      total_jogadas += partida_gulosa(j, MAX_JOGADAS_PARTIDA, max_reciclagens, &g);
+    if (venceu_jogo(j))
+      vitorias++;
+  }
+
+  double duracao = agora() - inicio;
+  printf("partidas:          %d\n", n_partidas);
+  printf("vitórias:          %d (%.2f%%)\n", vitorias, 100.0 * vitorias / n_partidas);
+  printf("jogadas/partida:   %.1f\n", (double)total_jogadas / n_partidas);
+  printf("tempo:             %.3f s\n", duracao);
+  printf("partidas/s:        %.0f\n", n_partidas / duracao);
+  printf("jogadas/s:         %.0f\n", total_jogadas / duracao);
+
+  free(j);
+  return 0;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file banco.c
+ *
+ * @brief Banco de distribuições vencíveis, lido diretamente da memória mapeada.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "banco.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// gulosas: de 0 a 126 conforme as derrotas; resolvedor: de 128, somando o log2 dos estados
+uint8_t dificuldade_distribuicao(const registro_banco_t *r)
+{
+  if (r->vitorias_gulosas > 0)
+    return (N_PARTIDAS_DIFICULDADE - r->vitorias_gulosas) * 127 / N_PARTIDAS_DIFICULDADE;
+  int bits = r->estados > 0 ? 32 - __builtin_clz(r->estados) : 0;
+  return 128 + bits * 127 / 32;
+}
+
+bool abre_banco(banco_t *b, const char *nome)
+{
+  memset(b, 0, sizeof(*b));
+  int descritor = open(nome, O_RDONLY);
+  if (descritor < 0) return false;
+
+  struct stat info;
+  if (fstat(descritor, &info) != 0 || (size_t)info.st_size < sizeof(cabecalho_banco_t)) {
+    close(descritor);
+    return false;
+  }
+  void *mapa = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, descritor, 0);
+  // o mapeamento continua válido depois de fechar o descritor
+  close(descritor);
+  if (mapa == MAP_FAILED) return false;
+
+  const cabecalho_banco_t *c = mapa;
+  size_t cabem = (info.st_size - sizeof(cabecalho_banco_t)) / sizeof(registro_banco_t);
+  if (memcmp(c->marca, MARCA_BANCO, sizeof(c->marca)) != 0 || c->versao != VERSAO_BANCO
+      || c->tamanho_registro != sizeof(registro_banco_t) || c->n_registros > cabem) {
+    munmap(mapa, info.st_size);
+    return false;
+  }
+
+  b->cabecalho = c;
+  b->registros = (const registro_banco_t *)(c + 1);
+  b->n_registros = c->n_registros;
+  b->tamanho_mapeado = info.st_size;
+  return true;
+}
+
+void fecha_banco(banco_t *b)
+{
+  if (b->cabecalho != NULL)
+    munmap((void *)b->cabecalho, b->tamanho_mapeado);
+  memset(b, 0, sizeof(*b));
+}
+
+// sorteia um registro e distribui as cartas com a semente dele
+const registro_banco_t *inicia_pilhas_jogo_do_banco(jogo_t *j, banco_t *b, gerador_t *g)
+{
+  assert(b->n_registros > 0);
+  const registro_banco_t *r = &b->registros[sorteia_64(g) % b->n_registros];
+  inicia_pilhas_jogo_com_semente(j, r->semente);
+  return r;
+}
@@ -0,0 +1,95 @@
+#ifndef BANCO_H
+#define BANCO_H
+
+/**
+ * @file banco.h
+ *
+ * @brief Banco de distribuições vencíveis, lido diretamente da memória mapeada.
+ *
+ * O arquivo tem um cabeçalho seguido de registros de tamanho fixo, um por
+ * distribuição já resolvida pela ferramenta gerabanco. Como não há nada para
+ * interpretar, abrir o banco é só mapear o arquivo, e escolher uma distribuição
+ * é só sortear um índice, qualquer que seja o tamanho do banco.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+
+#define MARCA_BANCO "KLBANCO1"
+#define VERSAO_BANCO 1
+// partidas gulosas jogadas em cada distribuição para medir a dificuldade
+#define N_PARTIDAS_DIFICULDADE 64
+
+// cabeçalho do arquivo do banco (64 bytes)
+typedef struct {
+  char marca[8];
+  uint32_t versao;
+  uint32_t tamanho_registro;
+  uint64_t n_registros;
+  // primeira semente ainda não examinada, para continuar a geração
+  uint64_t proxima_semente;
+  uint64_t reservado[4];
+} cabecalho_banco_t;
+
+// uma distribuição vencível (16 bytes)
+typedef struct {
+  // semente de inicia_pilhas_jogo_com_semente()
+  uint64_t semente;
+  // estados expandidos pelo resolvedor; 0 se a heurística gulosa bastou
+  uint32_t estados;
+  // número de jogadas da solução encontrada
+  uint16_t n_jogadas;
+  // partidas vencidas pela heurística gulosa, de N_PARTIDAS_DIFICULDADE
+  uint8_t vitorias_gulosas;
+  // 0 (fácil) a 255 (difícil), calculada por dificuldade_distribuicao()
+  uint8_t dificuldade;
+} registro_banco_t;
+
+// banco aberto
+typedef struct {
+  const cabecalho_banco_t *cabecalho;
+  const registro_banco_t *registros;
+  uint64_t n_registros;
+  size_t tamanho_mapeado;
+} banco_t;
+
+/**
+ * @brief Calcula a dificuldade de uma distribuição a partir das medidas do registro.
+ *
+ * Distribuições que a heurística gulosa vence ficam abaixo de 128, tanto mais fáceis
+ * quanto mais partidas gulosas vencem; as que só o resolvedor vence ficam de 128 para
+ * cima, crescendo com o número de estados que ele precisou expandir.
+ *
+ * @param r Ponteiro para o registro.
+ * @return A dificuldade, de 0 a 255.
+ */
+uint8_t dificuldade_distribuicao(const registro_banco_t *r);
+
+/**
+ * @brief Mapeia o arquivo do banco na memória, só para leitura.
+ *
+ * @param b Ponteiro para o banco.
+ * @param nome Nome do arquivo.
+ * @return true se o arquivo foi mapeado e é um banco válido, false caso contrário.
+ */
+bool abre_banco(banco_t *b, const char *nome);
+
+/**
+ * @brief Desfaz o mapeamento do banco.
+ *
+ * @param b Ponteiro para o banco.
+ */
+void fecha_banco(banco_t *b);
+
+/**
+ * @brief Inicializa as pilhas do jogo com uma distribuição sorteada do banco.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param b Ponteiro para o banco aberto, com pelo menos um registro.
+ * @param g Ponteiro para o gerador usado no sorteio.
+ * @return Ponteiro para o registro da distribuição escolhida.
+ */
+const registro_banco_t *inicia_pilhas_jogo_do_banco(jogo_t *j, banco_t *b, gerador_t *g);
+
+#endif // BANCO_H
@@ -0,0 +1,138 @@
+/**
+ * @file estimador.c
+ *
+ * @brief Estimador de Monte Carlo da chance de vitória de cada jogada.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "estimador.h"
+#include <pthread.h>
+
+// trabalho de uma thread do estimador
+typedef struct {
+  jogo_t *original;
+  jogada_t *jogadas;
+  int n_jogadas;
+  gerador_t gerador;
+  double fim;
+  int max_amostras;
+  int amostras;
+  int vitorias[N_MAX_JOGADAS];
+} tarefa_estimativa_t;
+
+// relógio monotônico, em segundos
+static double agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// embaralha as cartas fechadas das pilhas principais junto com as do monte
+void sorteia_cartas_ocultas(jogo_t *j, gerador_t *g)
+{
+  carta_t ocultas[N_MAX_CARTAS];
+  int n_ocultas = 0;
+
+  // o monte está todo fechado
+  for (int i = 0; i < j->monte.n_cartas; i++)
+    ocultas[n_ocultas++] = j->monte.cartas[i];
+  for (int k = 0; k < N_PILHAS_PRINCIPAIS; k++) {
+    pilha_t *p = &j->pilhas_principais[k];
+    for (int i = 0; i < p->n_cartas_fechadas; i++)
+      ocultas[n_ocultas++] = p->cartas[i];
+  }
+
+  embaralha_cartas(ocultas, n_ocultas, g);
+
+  // devolve as cartas nas mesmas posições
+  n_ocultas = 0;
+  for (int i = 0; i < j->monte.n_cartas; i++)
+    j->monte.cartas[i] = ocultas[n_ocultas++];
+  recalcula_pilha(&j->monte);
+  for (int k = 0; k < N_PILHAS_PRINCIPAIS; k++) {
+    pilha_t *p = &j->pilhas_principais[k];
+    for (int i = 0; i < p->n_cartas_fechadas; i++)
+      p->cartas[i] = ocultas[n_ocultas++];
+    recalcula_pilha(p);
+  }
+  recalcula_derivados(j);
+}
+
+// laço de uma thread: sorteia distribuições e joga cada candidata até o fim
+static void *executa_tarefa(void *arg)
+{
+  tarefa_estimativa_t *t = arg;
+
+  while (t->amostras < t->max_amostras && agora() < t->fim) {
+    jogo_t amostra = *t->original;
+    // a pontuação não interessa nas simulações, então o relógio não é consultado
+    amostra.relogio = NULL;
+    sorteia_cartas_ocultas(&amostra, &t->gerador);
+
+    for (int k = 0; k < t->n_jogadas; k++) {
+      jogo_t simulacao = amostra;
+      aplica_jogada(&simulacao, t->jogadas[k]);
+      partida_gulosa(&simulacao, MAX_JOGADAS_SIMULACAO, MAX_RECICLAGENS_SIMULACAO, &t->gerador);
+      if (venceu_jogo(&simulacao))
+        t->vitorias[k]++;
+    }
+    t->amostras++;
+  }
+
+  return NULL;
+}
+
+// divide as amostras entre as threads e soma os resultados
+int estima_probabilidades(jogo_t *j, avaliacao_t *avaliacoes, int n_threads,
+                          double tempo_limite, int max_amostras, uint64_t semente)
+{
+  jogada_t jogadas[N_MAX_JOGADAS];
+  int n_jogadas = gera_jogadas(j, jogadas);
+  if (n_jogadas == 0) return 0;
+
+  if (n_threads < 1) n_threads = 1;
+  tarefa_estimativa_t *tarefas = calloc(n_threads, sizeof(tarefa_estimativa_t));
+  pthread_t *threads = malloc(n_threads * sizeof(pthread_t));
+  assert(tarefas != NULL && threads != NULL);
+
+  double fim = agora() + tempo_limite;
+  for (int i = 0; i < n_threads; i++) {
+    tarefas[i].original = j;
+    tarefas[i].jogadas = jogadas;
+    tarefas[i].n_jogadas = n_jogadas;
+    inicia_gerador(&tarefas[i].gerador, semente + i);
+    tarefas[i].fim = fim;
+    // as amostras são divididas igualmente, a primeira thread fica com o resto
+    if (max_amostras > 0)
+      tarefas[i].max_amostras = max_amostras / n_threads + (i == 0 ? max_amostras % n_threads : 0);
+    else
+      tarefas[i].max_amostras = 1 << 30;
+  }
+
+  // a thread atual também trabalha, como a tarefa 0
+  for (int i = 1; i < n_threads; i++)
+    pthread_create(&threads[i], NULL, executa_tarefa, &tarefas[i]);
+  executa_tarefa(&tarefas[0]);
+  for (int i = 1; i < n_threads; i++)
+    pthread_join(threads[i], NULL);
+
+  for (int k = 0; k < n_jogadas; k++) {
+    avaliacoes[k].jogada = jogadas[k];
+    avaliacoes[k].amostras = 0;
+    avaliacoes[k].vitorias = 0;
+    for (int i = 0; i < n_threads; i++) {
+      avaliacoes[k].amostras += tarefas[i].amostras;
+      avaliacoes[k].vitorias += tarefas[i].vitorias[k];
+    }
+    if (avaliacoes[k].amostras > 0)
+      avaliacoes[k].probabilidade = (double)avaliacoes[k].vitorias / avaliacoes[k].amostras;
+    else
+      avaliacoes[k].probabilidade = 0;
+  }
+
+  free(threads);
+  free(tarefas);
+  return n_jogadas;
+}
@@ -0,0 +1,62 @@
+#ifndef ESTIMADOR_H
+#define ESTIMADOR_H
+
+/**
+ * @file estimador.h
+ *
+ * @brief Estimador de Monte Carlo da chance de vitória de cada jogada.
+ *
+ * O jogador só conhece as cartas abertas. O estimador sorteia muitas distribuições
+ * das cartas fechadas (das pilhas principais e do monte) que sejam consistentes
+ * com o que está à vista, joga cada uma até o fim com a heurística gulosa e conta
+ * as vitórias de cada jogada candidata.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+
+// tempo padrão de uma estimativa, em segundos
+#define TEMPO_ESTIMATIVA 0.2
+// limites de cada partida simulada
+#define MAX_JOGADAS_SIMULACAO 500
+#define MAX_RECICLAGENS_SIMULACAO 3
+
+// resultado da estimativa para uma jogada
+typedef struct {
+  jogada_t jogada;
+  int amostras;
+  int vitorias;
+  double probabilidade;
+} avaliacao_t;
+
+/**
+ * @brief Sorteia novas posições para as cartas que o jogador não vê.
+ *
+ * As cartas fechadas das pilhas principais e as cartas do monte são embaralhadas
+ * entre si, mantendo as quantidades de cada pilha. As cartas abertas não mudam.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param g Ponteiro para o gerador.
+ */
+void sorteia_cartas_ocultas(jogo_t *j, gerador_t *g);
+
+/**
+ * @brief Estima a chance de vitória de cada jogada possível.
+ *
+ * Cada thread tem seu próprio gerador e sua própria contagem; as contagens só são
+ * somadas no final. Todas as jogadas candidatas são avaliadas na mesma distribuição
+ * sorteada, o que diminui a variância da comparação entre elas.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo (não é alterado).
+ * @param avaliacoes Vetor com espaço para N_MAX_JOGADAS avaliações.
+ * @param n_threads Número de threads a usar.
+ * @param tempo_limite Tempo máximo da estimativa, em segundos.
+ * @param max_amostras Número máximo de distribuições sorteadas (0 para não limitar).
+ * @param semente Semente dos geradores.
+ * @return O número de jogadas avaliadas.
+ */
+int estima_probabilidades(jogo_t *j, avaliacao_t *avaliacoes, int n_threads,
+                          double tempo_limite, int max_amostras, uint64_t semente);
+
+#endif // ESTIMADOR_H
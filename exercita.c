@@ -0,0 +1,168 @@
+/**
+ * @file exercita.c
+ *
+ * @brief Mede a vazão dos lotes de ambientes com um agente aleatório.
+ *
+ * Cada thread tem o seu lote e escolhe, em cada partida, uma ação sorteada entre
+ * as possíveis pela máscara. Partidas terminadas são reiniciadas com a próxima
+ * semente. Mostra os passos por segundo e quantas partidas terminaram e foram vencidas.
+ *
+ * Uso: ./exercita [-n partidas por thread] [-p threads] [-t segundos] [-s semente]
+ *                 [-m passos] [-r reciclagens]
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "ambiente.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// passos entre duas consultas ao relógio
+#define PASSOS_POR_MEDIDA 64
+
+typedef struct {
+  int n;
+  int max_passos;
+  int max_reciclagens;
+  double limite_tempo;
+  uint64_t semente;
+  // próxima semente a distribuir, comum às threads
+  _Atomic uint64_t *proxima_semente;
+  uint64_t passos;
+  uint64_t partidas;
+  uint64_t vitorias;
+} trabalho_t;
+
+// relógio monotônico, em segundos
+static double agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// sorteia uma ação entre as possíveis; -1 se não há nenhuma
+static int sorteia_acao(const uint8_t *mascara, gerador_t *g)
+{
+  // a máscara tem bytes 0 ou 1, então cada palavra de 8 bytes vira 8 bits de ações possíveis
+  uint64_t bits[(N_ACOES + 7) / 8] = { 0 };
+  int n = 0;
+  for (int w = 0; w < (N_ACOES + 7) / 8; w++) {
+    uint64_t palavra = 0;
+    memcpy(&palavra, mascara + 8 * w, w == N_ACOES / 8 ? N_ACOES % 8 : 8);
+    bits[w] = palavra;
+    n += __builtin_popcountll(palavra);
+  }
+  if (n == 0) return -1;
+  int r = sorteia_64(g) % n;
+  for (int w = 0; ; w++) {
+    int c = __builtin_popcountll(bits[w]);
+    if (r < c) {
+      uint64_t b = bits[w];
+      while (r-- > 0) b &= b - 1;
+      return 8 * w + __builtin_ctzll(b) / 8;
+    }
+    r -= c;
+  }
+}
+
+// laço de uma thread: avança o seu lote até o tempo acabar
+static void *exercita(void *arg)
+{
+  trabalho_t *t = arg;
+  int n = t->n;
+  lote_ambientes_t l;
+  uint8_t *observacoes = malloc((size_t)n * TAM_OBSERVACAO);
+  uint8_t *mascaras = malloc((size_t)n * N_ACOES);
+  uint64_t *sementes = malloc(n * sizeof(uint64_t));
+  int *acoes = malloc(n * sizeof(int));
+  float *recompensas = malloc(n * sizeof(float));
+  uint8_t *fins = malloc(n);
+  bool ok = cria_ambientes(&l, n, t->max_passos, t->max_reciclagens);
+  assert(ok && observacoes != NULL && mascaras != NULL && sementes != NULL && acoes != NULL
+         && recompensas != NULL && fins != NULL);
+  gerador_t g;
+  inicia_gerador(&g, t->semente);
+
+  for (int i = 0; i < n; i++)
+    sementes[i] = atomic_fetch_add(t->proxima_semente, 1);
+  reinicia_ambientes(&l, sementes, observacoes, mascaras);
+
+  double fim = agora() + t->limite_tempo;
+  while (agora() < fim) {
+    for (int k = 0; k < PASSOS_POR_MEDIDA; k++) {
+      for (int i = 0; i < n; i++)
+        acoes[i] = sorteia_acao(mascaras + (size_t)i * N_ACOES, &g);
+      passo_ambientes(&l, acoes, observacoes, mascaras, recompensas, fins);
+      t->passos += n;
+      for (int i = 0; i < n; i++) {
+        if (fins[i] == em_curso) continue;
+        t->partidas++;
+        if (fins[i] == vitoria) t->vitorias++;
+        reinicia_ambiente(&l, i, atomic_fetch_add(t->proxima_semente, 1), observacoes, mascaras);
+      }
+    }
+  }
+
+  termina_ambientes(&l);
+  free(fins);
+  free(recompensas);
+  free(acoes);
+  free(sementes);
+  free(mascaras);
+  free(observacoes);
+  return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+  int n = 256;
+  int n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  double limite_tempo = 5;
+  uint64_t semente = 1;
+  int max_passos = 500;
+  int max_reciclagens = 3;
+  int opcao;
+
+  while ((opcao = getopt(argc, argv, "n:p:t:s:m:r:")) != -1) {
+    switch (opcao) {
+      case 'n': n = atoi(optarg); break;
+      case 'p': n_threads = atoi(optarg); break;
+      case 't': limite_tempo = atof(optarg); break;
+      case 's': semente = strtoull(optarg, NULL, 10); break;
+      case 'm': max_passos = atoi(optarg); break;
+      case 'r': max_reciclagens = atoi(optarg); break;
+      default:
+        fprintf(stderr, "uso: %s [-n partidas por thread] [-p threads] [-t segundos] [-s semente] [-m passos] [-r reciclagens]\n",
+                argv[0]);
+        return 1;
+    }
+  }
+  if (n < 1) n = 1;
+  if (n_threads < 1) n_threads = 1;
+
+  _Atomic uint64_t proxima_semente = semente;
+  pthread_t threads[n_threads];
+  trabalho_t trabalhos[n_threads];
+  double inicio = agora();
+  for (int i = 0; i < n_threads; i++) {
+    trabalhos[i] = (trabalho_t){ n, max_passos, max_reciclagens, limite_tempo, semente * 1000003 + i, &proxima_semente };
+    pthread_create(&threads[i], NULL, exercita, &trabalhos[i]);
+  }
+  uint64_t passos = 0, partidas = 0, vitorias = 0;
+  for (int i = 0; i < n_threads; i++) {
+    pthread_join(threads[i], NULL);
+    passos += trabalhos[i].passos;
+    partidas += trabalhos[i].partidas;
+    vitorias += trabalhos[i].vitorias;
+  }
+  double duracao = agora() - inicio;
+
+  printf("ambientes:         %d por thread, %d threads\n", n, n_threads);
+  printf("observação:        %d bytes, %d ações\n", TAM_OBSERVACAO, N_ACOES);
+  printf("passos:            %llu (%.0f/s)\n", (unsigned long long)passos, passos / duracao);
+  printf("partidas:          %llu terminadas, %llu vitórias (%.2f%%)\n", (unsigned long long)partidas,
+         (unsigned long long)vitorias, partidas > 0 ? 100.0 * vitorias / partidas : 0.0);
+  return 0;
+}
@@ -16,19 +16,32 @@
 #include <assert.h>
 #include <time.h>
 #include <ctype.h>
+#include <stdint.h>
 #include "telag.h"
 
+// tamanho inicial da janela; os desenhos mantêm as proporções deste tamanho (ver disposicao_t)
 #define ALTURA 480
 #define LARGURA 720
-#define CARTA_ALTURA ALTURA/5
-#define CARTA_LARGURA LARGURA/11
-#define ESPACO_ENTRE_CARTAS LARGURA/36
+// lado, em pixels, de cada célula do mapa de toque
+#define LADO_TOQUE 4
 #define N_MAX_CARTAS 52
 #define N_PILHAS 13
 #define N_PILHAS_SAIDA 4
 #define N_PILHAS_PRINCIPAIS 7
 #define MAX_CHAR_CMD 2
 
+// índices das pilhas, na mesma ordem das coordenadas em disposicao_t
+#define PILHA_MONTE 0
+#define PILHA_DESCARTE 1
+#define PILHA_SAIDA 2
+#define PILHA_PRINCIPAL (PILHA_SAIDA + N_PILHAS_SAIDA)
+// limite folgado para o número de jogadas possíveis em um estado
+#define N_MAX_JOGADAS 64
+// bits das pilhas de saída e das pilhas principais, nas máscaras de pilhas
+#define MASCARA_SAIDA (((1u << N_PILHAS_SAIDA) - 1) << PILHA_SAIDA)
+#define MASCARA_PRINCIPAIS (((1u << N_PILHAS_PRINCIPAIS) - 1) << PILHA_PRINCIPAL)
+#define TAM_ANALISE 100
+
 // enums para dar nomes a valores constantes, de forma organizada
 typedef enum {
   ouros,
@@ -65,21 +78,191 @@ typedef struct {
 typedef struct {
   int n_cartas;
   int n_cartas_fechadas;
+  // chave de Zobrist das cartas da pilha, atualizada a cada alteração
+  uint64_t chave;
   carta_t cartas[N_MAX_CARTAS];
+  // tamanho da sequência válida (cores alternadas, valores decrescentes) que termina em cada posição
+  uint8_t sequencia[N_MAX_CARTAS];
 } pilha_t;
 
+// onde está uma carta: índice da pilha, posição na pilha e se está aberta
+typedef struct {
+  int8_t pilha;
+  int8_t posicao;
+  bool aberta;
+} localizacao_t;
+
+// valores derivados das pilhas, atualizados a cada jogada para consultas em tempo constante
+typedef struct {
+  int cartas_saida;
+  int cartas_fechadas;
+  int altura_naipe[N_PILHAS_SAIDA];
+  // localização de cada carta, pelo índice da carta
+  localizacao_t localizacao[N_MAX_CARTAS];
+  // cartas abertas nos topos das pilhas principais e de saída, um bit por índice de carta
+  uint64_t topos_principais;
+  uint64_t topos_saida;
+  // índice da carta aberta no topo de cada pilha (-1 se não houver)
+  int8_t topo[N_PILHAS];
+  // pilhas vazias, um bit por índice de pilha
+  uint16_t pilhas_vazias;
+} derivados_t;
+
 typedef struct {
   pilha_t monte;
   pilha_t descarte;
   pilha_t pilhas_saida[N_PILHAS_SAIDA];
   pilha_t pilhas_principais[N_PILHAS_PRINCIPAIS];
-  coordenadas_t coordenadas_pilhas[N_PILHAS];
+  derivados_t derivados;
   char comando[MAX_CHAR_CMD+1];
+  char analise[TAM_ANALISE];
   double pontos;
+  // parte dos pontos que veio de bonus()
+  double bonus_total;
+  // instante da última jogada que pontuou, usado no bônus
   double tempo_ultima_jogada;
+  // instante da última jogada de qualquer tipo (ou do início da partida), para a telemetria
+  double instante_ultima_jogada;
+  // relógio usado no bônus, deve ser definido antes de iniciar as pilhas (NULL: o tempo não passa)
+  double (*relogio)(void);
   bool sair;
 } jogo_t;
 
+// número máximo de partidas ao mesmo tempo em jogo_em_mesas()
+#define MAX_MESAS 9
+
+// uma partida de jogo_em_mesas() e onde ela aparece na janela
+typedef struct {
+  jogo_t *jogo;
+  // número da partida na telemetria
+  int partida;
+  int camada;
+  int lin;
+  int col;
+  // assinatura do tabuleiro da última vez que a camada foi desenhada
+  uint64_t assinatura;
+  bool terminada;
+} mesa_t;
+
+// o que há em uma célula do mapa de toque: a pilha (-1 se nenhuma) e a fileira
+// da pilha, contada de deslocamento_carta em deslocamento_carta a partir do alto da pilha
+typedef struct {
+  int8_t pilha;
+  uint8_t fileira;
+} toque_t;
+
+// para cada célula de LADO_TOQUE pixels, a pilha e a fileira que ocupam o lugar
+typedef struct {
+  int colunas;
+  int linhas;
+  // linha após linha
+  toque_t *celulas;
+} mapa_toque_t;
+
+// onde e em que tamanho as coisas são desenhadas em uma área (a janela, ou um tabuleiro
+// de jogo_em_mesas()); é calculada só quando a área muda de tamanho, e o desenho só lê
+typedef struct {
+  // tamanho da área
+  int largura_area;
+  int altura;
+  // os desenhos mantêm as proporções de LARGURA x ALTURA, nesta escala, em uma faixa
+  // de largura centrada na área; as pilhas principais podem crescer até o fim da altura
+  float escala;
+  int esquerda;
+  int largura;
+  int carta_largura;
+  int carta_altura;
+  int espaco_entre_cartas;
+  // distância vertical entre as cartas de uma pilha principal
+  int deslocamento_carta;
+  // canto superior esquerdo de cada pilha, pelo índice da pilha
+  coordenadas_t pilhas[N_PILHAS];
+  // tamanhos das letras
+  int letra_titulo;
+  int letra_texto;
+  int letra_pilha;
+  int letra_valor;
+  int letra_naipe;
+  int letra_verso;
+  int letra_contagem;
+  mapa_toque_t toque;
+  // camada com o fundo (a identificação das pilhas), redesenhada a cada mudança de tamanho
+  int camada_fundo;
+  // se o mapa e a camada já foram criados
+  bool iniciada;
+} disposicao_t;
+
+// estado do mouse entre um quadro e outro: o toque em andamento, o arrasto e a carta selecionada
+typedef struct {
+  bool apertado;
+  bool arrastando;
+  // onde o botão foi apertado e onde o mouse está
+  int x0, y0;
+  int x, y;
+  // pilha e carta tocadas quando o botão foi apertado (-1 se nenhuma)
+  int origem;
+  int carta;
+  // distância do mouse ao canto superior esquerdo da carta arrastada
+  int dx, dy;
+  // pilha e carta selecionadas por um clique, esperando o clique no destino (-1 se nenhuma)
+  int selecionada;
+  int carta_selecionada;
+} rato_t;
+
+// cartas de uma jogada indo da origem ao destino; o movimento é simulado em passos de
+// tempo fixos e desenhado entre a posição do passo anterior e a do atual
+typedef struct {
+  bool ativa;
+  // chave e número de cartas de cada pilha do último jogo visto, para perceber as jogadas
+  uint64_t chave;
+  int n_cartas[N_PILHAS];
+  // o jogo que é desenhado durante a animação: as cartas que estão no caminho ficam
+  // no destino, logo acima do topo
+  jogo_t jogo;
+  int destino;
+  int n_cartas_movidas;
+  // onde as cartas estavam no passo anterior, onde estão no atual e onde vão parar
+  float col_anterior, lin_anterior;
+  float col, lin;
+  float col_alvo, lin_alvo;
+  // tempo ainda não simulado, menor que um passo depois de cada simulação
+  double acumulado;
+  double instante;
+  // jogada pedida largando cartas com o mouse: se for ela a próxima jogada percebida,
+  // as cartas partem de onde foram largadas (origem -1 se nenhuma)
+  int origem_largada, destino_largada;
+  float col_largada, lin_largada;
+} animacao_t;
+
+// registro que representa uma jogada, pelos índices das pilhas de origem e destino
+typedef struct {
+  int8_t origem;
+  int8_t destino;
+  int8_t n_cartas;
+} jogada_t;
+
+// registro compacto das pilhas do jogo: os índices das cartas, pilha após pilha,
+// e quantas cartas e cartas fechadas cada pilha tem
+typedef struct {
+  uint8_t cartas[N_MAX_CARTAS];
+  uint8_t n_cartas[N_PILHAS];
+  uint8_t n_cartas_fechadas[N_PILHAS];
+} jogo_compacto_t;
+
+// o que é preciso guardar para desfazer uma jogada
+typedef struct {
+  double pontos;
+  // parte dos pontos que veio de bonus()
+  double bonus_total;
+  double tempo_ultima_jogada;
+  bool abriu_carta;
+} desfazer_t;
+
+// gerador de números pseudo-aleatórios, um por thread
+typedef struct {
+  uint64_t estado;
+} gerador_t;
+
 
 /**
  * @brief Cria uma carta com um determinado valor e naipe.
@@ -93,6 +276,17 @@ typedef struct {
 
 carta_t cria_carta(valor_t valor, naipe_t naipe);
 
+/**
+ * @brief Lê o relógio do jogo.
+ *
+ * O jogo com janela usa tela_relogio(); robôs e ferramentas sem janela podem usar
+ * outro relógio, ou nenhum (NULL), caso em que o tempo não passa.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @return O tempo, em segundos, medido pelo relógio do jogo.
+ */
+double relogio_do_jogo(jogo_t *j);
+
 /**
  * @brief Calcula o bônus com base no tempo da última jogada e pontos obtidos.
  *
@@ -107,6 +301,63 @@ carta_t cria_carta(valor_t valor, naipe_t naipe);
  */
 double bonus(jogo_t *j, int pontos_da_jogada);
 
+/**
+ * @brief Espalha os bits de um número de 64 bits.
+ *
+ * Números próximos resultam em valores sem relação aparente entre si.
+ *
+ * @param x Número a ser espalhado.
+ * @return O número espalhado.
+ */
+uint64_t espalha_64(uint64_t x);
+
+/**
+ * @brief Retorna o índice de uma carta no baralho.
+ *
+ * @param c Carta.
+ * @return O índice, entre 0 e N_MAX_CARTAS (exclusivo), ordenado por naipe e valor.
+ */
+int indice_carta(carta_t c);
+
+/**
+ * @brief Retorna a carta correspondente a um índice do baralho.
+ *
+ * @param indice Índice da carta, entre 0 e N_MAX_CARTAS (exclusivo).
+ * @return A carta, tal que indice_carta(carta) == indice.
+ */
+carta_t carta_do_indice(int indice);
+
+/**
+ * @brief Calcula do zero a chave de Zobrist de uma pilha.
+ *
+ * A chave combina, para cada carta, a carta, sua posição e se está aberta.
+ * As funções que alteram pilhas mantêm a chave atualizada incrementalmente, em
+ * tempo proporcional às cartas alteradas; compilando com -DCONFERE_CHAVES cada
+ * atualização é conferida com esta função.
+ *
+ * @param p Ponteiro para a pilha.
+ * @return A chave da pilha.
+ */
+uint64_t calcula_chave_pilha(pilha_t *p);
+
+/**
+ * @brief Recalcula a chave e as sequências de uma pilha cujas cartas foram alteradas diretamente.
+ *
+ * @param p Ponteiro para a pilha.
+ */
+void recalcula_pilha(pilha_t *p);
+
+/**
+ * @brief Retorna o tamanho da sequência válida de cartas abertas no topo da pilha.
+ *
+ * Uma sequência válida tem cores alternadas e valores decrescentes, e pode ser
+ * movida inteira. O tamanho é mantido pelas funções que alteram a pilha.
+ *
+ * @param p Ponteiro para a pilha.
+ * @return O número de cartas da sequência (0 se a pilha estiver vazia).
+ */
+int tamanho_sequencia_topo(pilha_t *p);
+
 /**
  * @brief Verifica se uma pilha de cartas está vazia.
  * 
@@ -337,6 +588,98 @@ void move_cartas_em_ordem(pilha_t *origem, pilha_t *destino, int n_cartas_a_move
  */
 void inicia_pilhas_jogo(jogo_t *j);
 
+/**
+ * @brief Inicializa as pilhas do jogo com cartas embaralhadas a partir de uma semente.
+ *
+ * A mesma semente sempre gera a mesma distribuição de cartas.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param semente Semente do embaralhamento.
+ */
+void inicia_pilhas_jogo_com_semente(jogo_t *j, uint64_t semente);
+
+/**
+ * @brief Inicializa as pilhas do jogo distribuindo as cartas de um monte na ordem dada.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param ordem Os N_MAX_CARTAS índices das cartas (como em indice_carta()), do fundo para o topo do monte.
+ */
+void inicia_pilhas_jogo_com_ordem(jogo_t *j, const uint8_t *ordem);
+
+/**
+ * @brief Obtém a ordem do monte que gerou a distribuição do jogo.
+ *
+ * Só vale para um jogo recém-distribuído, antes de qualquer jogada; é o inverso de
+ * inicia_pilhas_jogo_com_ordem().
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param ordem Vetor com espaço para N_MAX_CARTAS índices, do fundo para o topo do monte.
+ */
+void ordem_inicial_jogo(jogo_t *j, uint8_t *ordem);
+
+/**
+ * @brief Recalcula os valores derivados do jogo depois de alterar as pilhas diretamente.
+ *
+ * As jogadas mantêm j->derivados atualizado; só quem mexe nas cartas sem passar
+ * pelas funções de jogada precisa chamar esta função.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ */
+void recalcula_derivados(jogo_t *j);
+
+/**
+ * @brief Retorna onde está uma carta, sem procurar nas pilhas.
+ *
+ * Por exemplo, a próxima carta que a saída de copas precisa é
+ * cria_carta(j->derivados.altura_naipe[copas] + 1, copas).
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param c Carta a ser localizada.
+ * @return A pilha (índice como em pilha_do_jogo()), a posição e se a carta está aberta.
+ */
+localizacao_t localiza_carta(jogo_t *j, carta_t c);
+
+/**
+ * @brief Guarda as pilhas do jogo em um registro compacto.
+ *
+ * A pontuação e os demais campos do jogo não são guardados.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param c Ponteiro para o registro compacto.
+ */
+void compacta_jogo(jogo_t *j, jogo_compacto_t *c);
+
+/**
+ * @brief Recria as pilhas do jogo a partir de um registro compacto.
+ *
+ * As chaves, as sequências e os valores derivados são recalculados; os demais
+ * campos do jogo não são alterados.
+ *
+ * @param c Ponteiro para o registro compacto.
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ */
+void expande_jogo(jogo_compacto_t *c, jogo_t *j);
+
+/**
+ * @brief Retorna todas as pilhas de saída e principais que aceitam uma carta.
+ *
+ * Usa tabelas pré-calculadas das cartas sobre as quais cada carta pode ir e as
+ * máscaras dos topos das pilhas, respondendo para todos os destinos de uma vez.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param c Carta a ser movida.
+ * @return Máscara com um bit para cada índice de pilha (como em pilha_do_jogo()) que aceita a carta.
+ */
+uint16_t destinos_carta(jogo_t *j, carta_t c);
+
+/**
+ * @brief Confere os valores derivados e as sequências das pilhas com um cálculo do zero.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @return true se todos os valores estão corretos, false caso contrário.
+ */
+bool confere_derivados_jogo(jogo_t *j);
+
 /**
  * @brief Verifica se é possível mover uma carta para uma pilha de saída.
  *
@@ -446,6 +789,17 @@ bool move_carta_saida_para_jogo(jogo_t *j, int n_pilha_saida, int n_pilha_jogo);
  */
 bool move_cartas_entre_pilhas_jogo_com_qtde(jogo_t *j, int n_pilha1, int n_pilha2, int n_cartas_a_mover);
 
+/**
+ * @brief Calcula quantas cartas podem ser movidas de uma pilha principal para outra.
+ *
+ * Usa o tamanho da sequência do topo da origem, sem percorrer as cartas abertas.
+ *
+ * @param origem Pilha de origem.
+ * @param destino Pilha de destino.
+ * @return O número de cartas a mover, ou 0 se nenhuma puder ser movida.
+ */
+int cartas_a_mover_entre_pilhas(pilha_t *origem, pilha_t *destino);
+
 /**
  * @brief Move todas as cartas de uma pilha para outra pilha de jogo.
  *
@@ -470,6 +824,213 @@ bool move_cartas_entre_pilhas_jogo(jogo_t *j, int n_pilha1, int n_pilha2);
  */
 bool realiza_jogada(jogo_t *j, char *jogada);
 
+/**
+ * @brief Inicializa um gerador de números pseudo-aleatórios.
+ *
+ * Geradores diferentes são independentes entre si, permitindo que cada thread
+ * use o seu sem sincronização.
+ *
+ * @param g Ponteiro para o gerador.
+ * @param semente Semente do gerador.
+ */
+void inicia_gerador(gerador_t *g, uint64_t semente);
+
+/**
+ * @brief Sorteia um número de 64 bits.
+ *
+ * @param g Ponteiro para o gerador.
+ * @return O número sorteado.
+ */
+uint64_t sorteia_64(gerador_t *g);
+
+/**
+ * @brief Sorteia um número inteiro entre 0 e n (exclusivo).
+ *
+ * @param g Ponteiro para o gerador.
+ * @param n Limite superior (exclusivo), deve ser positivo.
+ * @return O número sorteado.
+ */
+int sorteia(gerador_t *g, int n);
+
+/**
+ * @brief Embaralha um vetor de cartas usando um gerador.
+ *
+ * @param cartas Vetor de cartas.
+ * @param n_cartas Número de cartas no vetor.
+ * @param g Ponteiro para o gerador.
+ */
+void embaralha_cartas(carta_t *cartas, int n_cartas, gerador_t *g);
+
+/**
+ * @brief Retorna a pilha do jogo correspondente a um índice.
+ *
+ * Os índices seguem a ordem em que as pilhas são desenhadas: monte, descarte,
+ * pilhas de saída (A-D) e pilhas principais (1-7).
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param indice Índice da pilha, entre 0 e N_PILHAS (exclusivo).
+ * @return Ponteiro para a pilha.
+ */
+pilha_t *pilha_do_jogo(jogo_t *j, int indice);
+
+/**
+ * @brief Gera todas as jogadas válidas em um estado do jogo.
+ *
+ * As jogadas são geradas sempre na mesma ordem, por pilha de origem e depois
+ * por pilha de destino. Jogadas entre pilhas principais movem a mesma quantidade
+ * de cartas que move_cartas_entre_pilhas_jogo() moveria.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param jogadas Vetor com espaço para N_MAX_JOGADAS jogadas.
+ * @return O número de jogadas geradas.
+ */
+int gera_jogadas(jogo_t *j, jogada_t *jogadas);
+
+/**
+ * @brief Realiza uma jogada gerada por gera_jogadas().
+ *
+ * Tem o mesmo efeito (inclusive na pontuação) que realiza_jogada() com o comando
+ * correspondente, sem precisar interpretar texto.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param jg Jogada a ser realizada.
+ * @return true se a jogada foi realizada, false caso contrário.
+ */
+bool aplica_jogada(jogo_t *j, jogada_t jg);
+
+/**
+ * @brief Realiza uma jogada guardando o necessário para desfazê-la.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param jg Jogada a ser realizada (gerada por gera_jogadas()).
+ * @param d Ponteiro para guardar as informações para desfazer a jogada.
+ * @return true se a jogada foi realizada, false caso contrário.
+ */
+bool faz_jogada(jogo_t *j, jogada_t jg, desfazer_t *d);
+
+/**
+ * @brief Desfaz uma jogada realizada por faz_jogada().
+ *
+ * O jogo volta exatamente ao estado anterior à jogada, inclusive na pontuação.
+ * As jogadas devem ser desfeitas na ordem inversa em que foram feitas.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param jg Jogada a ser desfeita.
+ * @param d Informações guardadas por faz_jogada().
+ */
+void desfaz_jogada(jogo_t *j, jogada_t jg, desfazer_t *d);
+
+/**
+ * @brief Gera o comando de teclado equivalente a uma jogada.
+ *
+ * @param jg Jogada a ser descrita.
+ * @param comando Ponteiro para armazenar o comando (pelo menos MAX_CHAR_CMD+1 caracteres).
+ */
+void descricao_jogada(jogada_t jg, char *comando);
+
+/**
+ * @brief Escolhe uma jogada usando heurísticas rápidas de prioridade.
+ *
+ * A ordem de preferência é: mover para as pilhas de saída, mover cartas que
+ * abrem cartas fechadas, levar reis para pilhas vazias, mover do descarte para
+ * o jogo e, por último, abrir cartas do monte. Empates são decididos pelo gerador.
+ * Reciclar o descarte só é escolhido enquanto reciclagens_restantes for positivo.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param jogadas Jogadas válidas no estado atual.
+ * @param n_jogadas Número de jogadas válidas.
+ * @param reciclagens_restantes Quantas vezes ainda se pode reciclar o descarte.
+ * @param g Ponteiro para o gerador usado nos desempates.
+ * @return O índice da jogada escolhida, ou -1 se nenhuma for interessante.
+ */
+int escolhe_jogada_gulosa(jogo_t *j, jogada_t *jogadas, int n_jogadas, int reciclagens_restantes, gerador_t *g);
+
+/**
+ * @brief Ordena as jogadas pela mesma nota usada por escolhe_jogada_gulosa(), da melhor para a pior.
+ *
+ * A ordenação é estável, então o resultado não depende de sorteio. Serve para os
+ * resolvedores tentarem primeiro as jogadas mais promissoras.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param jogadas Vetor de jogadas, ordenado no lugar.
+ * @param n_jogadas Número de jogadas no vetor.
+ * @param reciclagens_restantes Quantas vezes ainda se pode reciclar o descarte.
+ */
+void ordena_jogadas(jogo_t *j, jogada_t *jogadas, int n_jogadas, int reciclagens_restantes);
+
+/**
+ * @brief Joga uma partida até o fim usando escolhe_jogada_gulosa().
+ *
+ * A partida termina com vitória, quando não há jogada interessante, ou quando
+ * algum dos limites é atingido.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param max_jogadas Número máximo de jogadas.
+ * @param max_reciclagens Número máximo de reciclagens do descarte.
+ * @param g Ponteiro para o gerador usado nos desempates.
+ * @return O número de jogadas realizadas.
+ */
+int partida_gulosa(jogo_t *j, int max_jogadas, int max_reciclagens, gerador_t *g);
+
+/**
+ * @brief Retorna a chave de 64 bits do estado do jogo.
+ *
+ * Combina as chaves das 13 pilhas, que já são mantidas atualizadas pelas
+ * funções que movem cartas. Estados com as mesmas cartas nas mesmas posições
+ * têm a mesma chave; a pontuação não entra na chave.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @return A chave do jogo.
+ */
+uint64_t chave_jogo(jogo_t *j);
+
+/**
+ * @brief Retorna a chave canônica do estado do jogo.
+ *
+ * Como chave_jogo(), mas não depende da ordem das pilhas principais nem de qual
+ * pilha de saída recebeu cada naipe, juntando estados equivalentes.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @return A chave canônica do jogo.
+ */
+uint64_t chave_canonica_jogo(jogo_t *j);
+
+/**
+ * @brief Confere as chaves incrementais de todas as pilhas com um cálculo do zero.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @return true se todas as chaves estão corretas, false caso contrário.
+ */
+bool confere_chaves_jogo(jogo_t *j);
+
+/**
+ * @brief Verifica se o jogo já está ganho, faltando só levar as cartas às pilhas de saída.
+ *
+ * Isso acontece quando não há cartas fechadas nem no monte nem no descarte.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @return true se o jogo está garantidamente ganho, false caso contrário.
+ */
+bool vitoria_garantida(jogo_t *j);
+
+/**
+ * @brief Estima a chance de vitória de cada jogada possível e guarda o resultado em j->analise.
+ *
+ * Usa o estimador de Monte Carlo com todos os processadores disponíveis.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ */
+void analisa_jogadas(jogo_t *j);
+
+/**
+ * @brief Pede ao resolvedor a próxima jogada da melhor linha e guarda a dica em j->analise.
+ *
+ * Usa a busca em feixe com limites pequenos de tempo e memória, para não travar o jogo.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ */
+void mostra_dica(jogo_t *j);
+
 /**
  * @brief Processa as entradas do teclado para interação com o jogo.
  *
@@ -479,6 +1040,14 @@ bool realiza_jogada(jogo_t *j, char *jogada);
  */
 void processa_teclado(jogo_t * j);
 
+/**
+ * @brief Trata uma tecla digitada, acrescentando-a ao comando ou realizando a jogada no enter.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param tecla Tecla digitada ('\0' se nenhuma).
+ */
+void trata_tecla(jogo_t *j, char tecla);
+
 /**
  * @brief Desenha local onde a carta vai aparecer.
  * 
@@ -542,13 +1111,33 @@ void desenho_de_pilha_aberta(int lin, int col, pilha_t *p);
 void desenho_compacto_de_pilha_aberta(int lin, int col, pilha_t *p);
 
 /**
- * @brief Inicializa as coordenadas das pilhas no jogo.
+ * @brief Inicializa as coordenadas das pilhas na disposição.
  *
- * Esta função inicializa as coordenadas das pilhas no jogo.
+ * Usa a faixa de largura e os tamanhos das cartas já calculados na disposição.
  *
- * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param d Ponteiro para a disposição.
  */
-void inicializa_coordenadas(jogo_t *j);
+void inicializa_coordenadas(disposicao_t *d);
+
+/**
+ * @brief Calcula a disposição dos desenhos em uma área de um tamanho.
+ *
+ * Refaz também o que depende do tamanho: o mapa de toque e a camada com o fundo.
+ * Deve ser chamada de novo só quando a área muda de tamanho; desenhar não recalcula nada.
+ * Na primeira chamada a disposição deve estar zerada.
+ *
+ * @param d Ponteiro para a disposição.
+ * @param largura Largura da área, em pixels.
+ * @param altura Altura da área, em pixels.
+ */
+void calcula_disposicao(disposicao_t *d, int largura, int altura);
+
+/**
+ * @brief Passa a usar uma disposição nos desenhos e no mouse.
+ *
+ * @param d Ponteiro para a disposição, calculada por calcula_disposicao().
+ */
+void usa_disposicao(disposicao_t *d);
 
 /**
  * @brief Desenha as pilhas na tela do jogo.
@@ -571,7 +1160,7 @@ void desenhos_de_extras(jogo_t *j);
 /**
  * @brief Desenha o fundo da tela do jogo.
  *
- * Esta função desenha o fundo da tela do jogo.
+ * Copia a camada com o fundo da disposição em uso, desenhada só quando ela é calculada.
  *
  * @param j Ponteiro para a estrutura de dados do jogo.
  */
@@ -586,6 +1175,112 @@ void desenho_do_fundo(jogo_t *j);
  */
 void desenho_da_tela(jogo_t *j);
 
+/**
+ * @brief Desenha o tabuleiro do jogo (pilhas, identificação, pontos e comando), sem o mouse.
+ *
+ * Desenha onde estiver o destino atual, a tela ou uma camada.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ */
+void desenho_do_tabuleiro(jogo_t *j);
+
+/**
+ * @brief Desenha o mouse na sua posição atual.
+ */
+void desenho_do_rato(void);
+
+/**
+ * @brief Preenche o mapa de toque da disposição a partir das coordenadas das pilhas.
+ *
+ * As pilhas principais ocupam toda a coluna abaixo delas, com as fileiras contadas
+ * de deslocamento_carta em deslocamento_carta; as demais, só o lugar de uma carta.
+ * O mapa só depende da disposição, não das cartas.
+ *
+ * @param d Ponteiro para a disposição.
+ */
+void monta_mapa_toque(disposicao_t *d);
+
+/**
+ * @brief Descobre a pilha e a carta desenhadas em um ponto, em tempo constante.
+ *
+ * Usa o mapa de toque da disposição em uso e considera o desenho atual das pilhas,
+ * inclusive o compacto.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param x Coordenada x do ponto.
+ * @param y Coordenada y do ponto.
+ * @param carta Ponteiro para guardar a posição na pilha da carta tocada (-1 se a pilha está vazia).
+ * @return O índice da pilha (como em pilha_do_jogo()), ou -1 se não há pilha no ponto.
+ */
+int toca_carta(jogo_t *j, int x, int y, int *carta);
+
+/**
+ * @brief Atualiza o estado do mouse em um quadro, transformando cliques e arrastos em jogadas.
+ *
+ * Um clique no monte abre uma carta (ou recicla o descarte, se o monte está vazio);
+ * um clique em uma carta aberta a seleciona e um clique em outra pilha a move para lá.
+ * Arrastar uma carta aberta e soltá-la sobre outra pilha leva junto as cartas acima dela.
+ * A jogada não é conferida; só deve ser realizada se estiver entre as de gera_jogadas().
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param r Ponteiro para o estado do mouse.
+ * @param x Coordenada x do mouse, na área da disposição em uso.
+ * @param y Coordenada y do mouse, na área da disposição em uso.
+ * @param apertado Se o botão do mouse está apertado.
+ * @param jg Ponteiro para guardar a jogada pedida.
+ * @return true se o mouse pediu uma jogada, false caso contrário.
+ */
+bool trata_rato(jogo_t *j, rato_t *r, int x, int y, bool apertado, jogada_t *jg);
+
+/**
+ * @brief Marca as cartas selecionadas ou sendo arrastadas, no lugar delas no tabuleiro.
+ *
+ * O tabuleiro pode estar deslocado na janela, como em jogo_em_mesas().
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param r Ponteiro para o estado do mouse.
+ * @param col Coluna do canto superior esquerdo do tabuleiro na janela.
+ * @param lin Linha do canto superior esquerdo do tabuleiro na janela.
+ */
+void desenho_da_selecao(jogo_t *j, rato_t *r, float col, float lin);
+
+/**
+ * @brief Desenha as cartas sendo arrastadas junto ao mouse, sem redesenhar o tabuleiro.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param r Ponteiro para o estado do mouse.
+ */
+void desenho_do_arrasto(jogo_t *j, rato_t *r);
+
+/**
+ * @brief Prepara a animação das jogadas de um jogo, a partir do estado atual dele.
+ *
+ * @param a Ponteiro para a animação.
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ */
+void inicia_animacao(animacao_t *a, jogo_t *j);
+
+/**
+ * @brief Acompanha o jogo a cada quadro: começa uma animação quando percebe uma jogada e
+ * simula a que estiver em andamento, em passos fixos, até o instante dado.
+ *
+ * Uma jogada nova termina a animação anterior. As jogadas não esperam pela animação: ela
+ * só muda o que é desenhado, a partir do jogo já alterado.
+ *
+ * @param a Ponteiro para a animação.
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param agora Instante atual, em segundos (tela_relogio()).
+ * @return O jogo a desenhar: o da animação, se há uma em andamento, ou j.
+ */
+jogo_t *acompanha_jogo(animacao_t *a, jogo_t *j, double agora);
+
+/**
+ * @brief Desenha as cartas da animação em andamento, na posição entre os dois últimos passos.
+ *
+ * @param a Ponteiro para a animação.
+ */
+void desenho_da_animacao(animacao_t *a);
+
 /**
  * @brief Apresenta informações sobre o jogo.
  *
@@ -600,6 +1295,19 @@ void apresentacao();
  */
 double jogo();
 
+/**
+ * @brief Joga várias partidas ao mesmo tempo, com os tabuleiros reduzidos em uma grade na janela.
+ *
+ * A tecla tab passa o teclado para o próximo tabuleiro em jogo, e apertar o botão do
+ * mouse em um tabuleiro passa o teclado e o mouse para ele. Cada tabuleiro é
+ * desenhado em uma camada do tamanho do seu lugar na janela, com uma disposição
+ * própria, e redesenhado só quando o que mostra muda ou a janela muda de tamanho.
+ *
+ * @param n_mesas Número de partidas (no máximo MAX_MESAS).
+ * @return A soma das pontuações das partidas vencidas.
+ */
+double jogo_em_mesas(int n_mesas);
+
 /**
  * @brief Pergunta ao jogador se deseja jogar novamente.
  *
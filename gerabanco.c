@@ -0,0 +1,238 @@
+/**
+ * @file gerabanco.c
+ *
+ * @brief Gera o banco de distribuições vencíveis usado pelo jogo.
+ *
+ * Examina as sementes em ordem a partir da primeira. Cada distribuição é jogada
+ * N_PARTIDAS_DIFICULDADE vezes com a heurística gulosa; se nenhuma partida vence,
+ * tenta a busca em feixe. As distribuições vencidas entram no banco, em ordem de
+ * semente, com as medidas de dificuldade e o tamanho da solução.
+ *
+ * Com -a continua um banco existente a partir da semente em que parou. O
+ * cabeçalho é atualizado a cada lote, então um banco interrompido continua
+ * válido com os registros gravados até ali.
+ *
+ * Uso: ./gerabanco [-o arquivo] [-n distribuições] [-s semente] [-p threads]
+ *                  [-l largura] [-t segundos] [-a]
+ *   -n é o número de distribuições vencíveis a acrescentar ao banco.
+ *   -l e -t são a largura e o tempo máximo da busca em feixe em cada distribuição.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "banco.h"
+#include "resolvedor.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// limites das partidas gulosas
+#define MAX_JOGADAS_GULOSAS 1000
+#define MAX_RECICLAGENS_GULOSAS 3
+// distribuições examinadas por thread em cada lote
+#define LOTE_POR_THREAD 16
+
+// exame de um lote de sementes, dividido entre as threads
+typedef struct {
+  uint64_t primeira;
+  int n_sementes;
+  int n_threads;
+  parametros_feixe_t par;
+  registro_banco_t *registros;
+  bool *vencivel;
+} lote_t;
+
+typedef struct {
+  lote_t *lote;
+  int indice;
+} trabalho_lote_t;
+
+// relógio monotônico, em segundos
+static double agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// examina uma distribuição; retorna true se ela é vencível e preenche o registro
+static bool examina_distribuicao(uint64_t semente, parametros_feixe_t *par, jogo_t *j, resultado_busca_t *res, registro_banco_t *r)
+{
+  gerador_t g;
+  inicia_gerador(&g, semente);
+  memset(r, 0, sizeof(*r));
+  r->semente = semente;
+  int menor = 0;
+
+  for (int i = 0; i < N_PARTIDAS_DIFICULDADE; i++) {
+    inicia_pilhas_jogo_com_semente(j, semente);
+    int n = partida_gulosa(j, MAX_JOGADAS_GULOSAS, MAX_RECICLAGENS_GULOSAS, &g);
+    if (venceu_jogo(j)) {
+      r->vitorias_gulosas++;
+      if (menor == 0 || n < menor) menor = n;
+    }
+  }
+
+  if (r->vitorias_gulosas == 0) {
+    inicia_pilhas_jogo_com_semente(j, semente);
+    if (!busca_em_feixe(j, par, res)) return false;
+    menor = res->n_jogadas;
+    r->estados = res->estados_expandidos > UINT32_MAX ? UINT32_MAX : res->estados_expandidos;
+  }
+  r->n_jogadas = menor;
+  r->dificuldade = dificuldade_distribuicao(r);
+  return true;
+}
+
+// laço de uma thread: examina as sementes do lote com índice igual ao dela, módulo o número de threads
+static void *examina_lote(void *arg)
+{
+  trabalho_lote_t *t = arg;
+  lote_t *l = t->lote;
+  jogo_t *j = malloc(sizeof(jogo_t));
+  resultado_busca_t *res = malloc(sizeof(resultado_busca_t));
+  assert(j != NULL && res != NULL);
+  j->relogio = NULL;
+
+  for (int i = t->indice; i < l->n_sementes; i += l->n_threads)
+    l->vencivel[i] = examina_distribuicao(l->primeira + i, &l->par, j, res, &l->registros[i]);
+
+  free(res);
+  free(j);
+  return NULL;
+}
+
+// grava o cabeçalho no início do arquivo, mantendo a posição de escrita
+static bool grava_cabecalho(FILE *arq, cabecalho_banco_t *c)
+{
+  long posicao = ftell(arq);
+  bool ok = fseek(arq, 0, SEEK_SET) == 0 && fwrite(c, sizeof(*c), 1, arq) == 1;
+  ok = fflush(arq) == 0 && ok;
+  return fseek(arq, posicao, SEEK_SET) == 0 && ok;
+}
+
+// abre o banco para acrescentar registros, criando um novo se preciso
+static FILE *abre_para_gravar(const char *nome, bool continua, uint64_t semente, cabecalho_banco_t *c)
+{
+  FILE *arq = continua ? fopen(nome, "r+b") : NULL;
+  if (arq != NULL) {
+    if (fread(c, sizeof(*c), 1, arq) != 1 || memcmp(c->marca, MARCA_BANCO, sizeof(c->marca)) != 0
+        || c->versao != VERSAO_BANCO || c->tamanho_registro != sizeof(registro_banco_t)) {
+      fclose(arq);
+      return NULL;
+    }
+    // registros depois do último contado no cabeçalho são de um lote incompleto
+    fseek(arq, sizeof(*c) + c->n_registros * sizeof(registro_banco_t), SEEK_SET);
+    return arq;
+  }
+
+  arq = fopen(nome, "w+b");
+  if (arq == NULL) return NULL;
+  memset(c, 0, sizeof(*c));
+  memcpy(c->marca, MARCA_BANCO, sizeof(c->marca));
+  c->versao = VERSAO_BANCO;
+  c->tamanho_registro = sizeof(registro_banco_t);
+  c->proxima_semente = semente;
+  if (fwrite(c, sizeof(*c), 1, arq) != 1) {
+    fclose(arq);
+    return NULL;
+  }
+  return arq;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *nome = "distribuicoes.bin";
+  long n_distribuicoes = 1000;
+  uint64_t semente = 1;
+  int n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  bool continua = false;
+  lote_t lote;
+  parametros_feixe_padrao(&lote.par);
+  lote.par.largura = 500;
+  lote.par.limite_memoria = 32 << 20;
+  lote.par.limite_tempo = 1.0;
+  int opcao;
+
+  while ((opcao = getopt(argc, argv, "o:n:s:p:l:t:a")) != -1) {
+    switch (opcao) {
+      case 'o': nome = optarg; break;
+      case 'n': n_distribuicoes = atol(optarg); break;
+      case 's': semente = strtoull(optarg, NULL, 10); break;
+      case 'p': n_threads = atoi(optarg); break;
+      case 'l': lote.par.largura = atoi(optarg); break;
+      case 't': lote.par.limite_tempo = atof(optarg); break;
+      case 'a': continua = true; break;
+      default:
+        fprintf(stderr, "uso: %s [-o arquivo] [-n distribuições] [-s semente] [-p threads] [-l largura] [-t segundos] [-a]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (n_threads < 1) n_threads = 1;
+
+  cabecalho_banco_t cabecalho;
+  FILE *arq = abre_para_gravar(nome, continua, semente, &cabecalho);
+  if (arq == NULL) {
+    fprintf(stderr, "não foi possível abrir o banco %s\n", nome);
+    return 1;
+  }
+
+  lote.n_threads = n_threads;
+  lote.registros = malloc(n_threads * LOTE_POR_THREAD * sizeof(registro_banco_t));
+  lote.vencivel = malloc(n_threads * LOTE_POR_THREAD * sizeof(bool));
+  trabalho_lote_t *trabalhos = malloc(n_threads * sizeof(trabalho_lote_t));
+  pthread_t *threads = malloc(n_threads * sizeof(pthread_t));
+  assert(lote.registros != NULL && lote.vencivel != NULL && trabalhos != NULL && threads != NULL);
+
+  long acrescentadas = 0, examinadas = 0, pelo_resolvedor = 0;
+  double inicio = agora();
+  bool ok = true;
+
+  while (acrescentadas < n_distribuicoes && ok) {
+    lote.primeira = cabecalho.proxima_semente;
+    lote.n_sementes = n_threads * LOTE_POR_THREAD;
+
+    // a thread atual também trabalha, como a thread 0
+    for (int i = 0; i < n_threads; i++) {
+      trabalhos[i].lote = &lote;
+      trabalhos[i].indice = i;
+    }
+    for (int i = 1; i < n_threads; i++)
+      pthread_create(&threads[i], NULL, examina_lote, &trabalhos[i]);
+    examina_lote(&trabalhos[0]);
+    for (int i = 1; i < n_threads; i++)
+      pthread_join(threads[i], NULL);
+
+    // grava em ordem de semente, parando ao completar o pedido
+    int usadas = 0;
+    for (; usadas < lote.n_sementes && acrescentadas < n_distribuicoes && ok; usadas++) {
+      if (!lote.vencivel[usadas]) continue;
+      ok = fwrite(&lote.registros[usadas], sizeof(registro_banco_t), 1, arq) == 1;
+      cabecalho.n_registros++;
+      acrescentadas++;
+      if (lote.registros[usadas].vitorias_gulosas == 0) pelo_resolvedor++;
+    }
+    examinadas += usadas;
+    cabecalho.proxima_semente += usadas;
+    ok = ok && grava_cabecalho(arq, &cabecalho);
+  }
+
+  double duracao = agora() - inicio;
+  ok = (fclose(arq) == 0) && ok;
+  printf("banco:             %s (%llu distribuições)\n", nome, (unsigned long long)cabecalho.n_registros);
+  printf("acrescentadas:     %ld de %ld examinadas (%.2f%%)\n", acrescentadas, examinadas,
+         examinadas > 0 ? 100.0 * acrescentadas / examinadas : 0);
+  printf("pelo resolvedor:   %ld\n", pelo_resolvedor);
+  printf("próxima semente:   %llu\n", (unsigned long long)cabecalho.proxima_semente);
+  printf("tempo:             %.3f s\n", duracao);
+  printf("distribuições/s:   %.1f\n", examinadas / duracao);
+
+  free(threads);
+  free(trabalhos);
+  free(lote.vencivel);
+  free(lote.registros);
+  if (!ok) {
+    fprintf(stderr, "erro ao gravar o banco %s\n", nome);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file identifica.c
+ *
+ * @brief Converte distribuições de klondike em identificadores de 29 bytes e vice-versa.
+ *
+ * Com -s mostra o identificador da distribuição de uma semente; com -i mostra a
+ * distribuição de um identificador (o monte do fundo para o topo e as pilhas
+ * principais). Sem essas opções mede quantas ordens do monte por segundo são
+ * codificadas e decodificadas, conferindo a volta de cada uma.
+ *
+ * Uso: ./identifica [-s semente] [-i identificador] [-b ordens]
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "permutacao.h"
+#include <unistd.h>
+
+// relógio monotônico, em segundos
+static double agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// mostra as cartas de uma pilha, da primeira à última
+static void mostra_pilha(const char *nome, pilha_t *p)
+{
+  char descricao[10];
+  printf("%-10s", nome);
+  for (int i = 0; i < numero_cartas_pilha(p); i++) {
+    descricao_carta(p->cartas[i], descricao);
+    printf(" %s", descricao);
+  }
+  printf("\n");
+}
+
+// mostra a distribuição de um identificador
+static bool mostra_distribuicao(const char *texto)
+{
+  id_distribuicao_t id;
+  jogo_t *j = malloc(sizeof(jogo_t));
+  assert(j != NULL);
+  j->relogio = NULL;
+  bool ok = texto_para_id(texto, &id) && inicia_pilhas_jogo_com_id(j, &id);
+  if (ok) {
+    mostra_pilha("monte", &j->monte);
+    for (int i = 0; i < N_PILHAS_PRINCIPAIS; i++) {
+      char nome[10];
+      sprintf(nome, "pilha %d", i + 1);
+      mostra_pilha(nome, &j->pilhas_principais[i]);
+    }
+  } else {
+    fprintf(stderr, "identificador inválido: %s\n", texto);
+  }
+  free(j);
+  return ok;
+}
+
+// mostra o identificador da distribuição de uma semente
+static void mostra_id_da_semente(uint64_t semente)
+{
+  id_distribuicao_t id;
+  char texto[TAM_TEXTO_ID + 1];
+  jogo_t *j = malloc(sizeof(jogo_t));
+  assert(j != NULL);
+  j->relogio = NULL;
+  inicia_pilhas_jogo_com_semente(j, semente);
+  id_do_jogo(j, &id);
+  id_para_texto(&id, texto);
+  printf("%s\n", texto);
+  free(j);
+}
+
+// codifica e decodifica ordens sorteadas, medindo o tempo de cada fase
+static bool mede_desempenho(int n_ordens)
+{
+  uint8_t *ordens = malloc((size_t)n_ordens * N_MAX_CARTAS);
+  id_distribuicao_t *ids = malloc((size_t)n_ordens * sizeof(id_distribuicao_t));
+  assert(ordens != NULL && ids != NULL);
+  gerador_t g;
+  inicia_gerador(&g, 1);
+
+  for (int k = 0; k < n_ordens; k++) {
+    uint8_t *ordem = ordens + (size_t)k * N_MAX_CARTAS;
+    for (int i = 0; i < N_MAX_CARTAS; i++)
+      ordem[i] = i;
+    for (int i = N_MAX_CARTAS - 1; i > 0; i--) {
+      int r = sorteia(&g, i + 1);
+      uint8_t temp = ordem[i];
+      ordem[i] = ordem[r];
+      ordem[r] = temp;
+    }
+  }
+
+  double inicio = agora();
+  for (int k = 0; k < n_ordens; k++)
+    codifica_ordem(ordens + (size_t)k * N_MAX_CARTAS, &ids[k]);
+  double tempo_codifica = agora() - inicio;
+
+  int erros = 0;
+  uint8_t volta[N_MAX_CARTAS];
+  inicio = agora();
+  for (int k = 0; k < n_ordens; k++) {
+    if (!decodifica_ordem(&ids[k], volta) || memcmp(volta, ordens + (size_t)k * N_MAX_CARTAS, N_MAX_CARTAS) != 0)
+      erros++;
+  }
+  double tempo_decodifica = agora() - inicio;
+
+  printf("ordens:            %d\n", n_ordens);
+  printf("codificações/s:    %.0f\n", n_ordens / tempo_codifica);
+  printf("decodificações/s:  %.0f\n", n_ordens / tempo_decodifica);
+  printf("erros:             %d\n", erros);
+
+  free(ids);
+  free(ordens);
+  return erros == 0;
+}
+
+int main(int argc, char *argv[])
+{
+  int n_ordens = 1000000;
+  int opcao;
+
+  while ((opcao = getopt(argc, argv, "s:i:b:")) != -1) {
+    switch (opcao) {
+      case 's': mostra_id_da_semente(strtoull(optarg, NULL, 10)); return 0;
+      case 'i': return mostra_distribuicao(optarg) ? 0 : 1;
+      case 'b': n_ordens = atoi(optarg); break;
+      default:
+        fprintf(stderr, "uso: %s [-s semente] [-i identificador] [-b ordens]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  return mede_desempenho(n_ordens) ? 0 : 1;
+}
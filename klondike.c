@@ -8,678 +8,88 @@
  *
  * @author Luiz Felipe Cavalheiro
  *
- * @note Para rodar o jogo, digite: gcc -Wall -o klondike klondike.c telag.c -lallegro_font -lallegro_color -lallegro_ttf -lallegro_primitives -lallegro && ./klondike
+ * @note Para rodar o jogo, digite: gcc -Wall -o klondike klondike.c regras.c estimador.c resolvedor.c banco.c acervo.c permutacao.c reproducao.c publicacao.c telemetria.c metricas.c telag.c -lallegro_font -lallegro_color -lallegro_ttf -lallegro_primitives -lallegro -lpthread -lm && ./klondike
  */
 
-//Para rodar o jogo: gcc -Wall -o klondike klondike.c telag.c -lallegro_font -lallegro_color -lallegro_ttf -lallegro_primitives -lallegro && ./klondike
+//Para rodar o jogo: gcc -Wall -o klondike klondike.c regras.c estimador.c resolvedor.c banco.c acervo.c permutacao.c reproducao.c publicacao.c telemetria.c metricas.c telag.c -lallegro_font -lallegro_color -lallegro_ttf -lallegro_primitives -lallegro -lpthread -lm && ./klondike
 #include "funcoes.h"
-
-/**
- * @brief Calcula o bônus com base no tempo da última jogada e pontos obtidos.
- *
- * Esta função calcula um bônus com base no tempo decorrido desde a última jogada
- * e nos pontos obtidos na jogada atual. O bônus é calculado de acordo com a fórmula:
- *   pontuacao = (7.0 - tempo_jogada) / 7.0 * 3.0 * pontos_da_jogada;
- * Se o tempo_jogada for maior ou igual a 7 segundos, o bônus é zero.
- *
- * @param j Ponteiro para a estrutura de dados do jogo.
- * @param pontos_da_jogada Número de pontos obtidos na jogada atual.
- * @return Valor do bônus calculado.
- */
-double bonus(jogo_t *j, int pontos_da_jogada)
-{
-  double pontuacao;
-  double tempo_jogada = tela_relogio() - j->tempo_ultima_jogada;
-  if (tempo_jogada < 7)
-    pontuacao = (7.0 - tempo_jogada) / 7.0 * 3.0 * pontos_da_jogada;
-  else
-    pontuacao = 0;
-  j->tempo_ultima_jogada = tela_relogio();
-  
-  return pontuacao;
-}
-
-// verifica se a pilha está vazia
-bool pilha_vazia(pilha_t *p)
-{
-  return p->n_cartas == 0;
-}
-
-// verifica se a pilha está cheia
-bool pilha_cheia(pilha_t *p)
-{
-  return p->n_cartas == N_MAX_CARTAS;
-}
-
-// faça uma função que empilha uma carta em uma pilha. 
-void empilha_carta(pilha_t *p, carta_t carta) 
-{
-  int n_cartas = p->n_cartas;
-  // se a pilha está vazia, insere a carta aberta
-  if (n_cartas == 0) {
-    p->cartas[n_cartas] = carta;
-    p->n_cartas++;
-  } else { // se a pilha não está vazia
-    // se a carta do topo esta fechada, adiciona carta e deixa fechada
-    if (n_cartas == p->n_cartas_fechadas) {
-      p->cartas[n_cartas] = carta;
-      p->n_cartas++;
-      p->n_cartas_fechadas++;
-
-    } else { //se a carta do topo está aberta, adiciona carta e deixa aberta
-      p->cartas[n_cartas] = carta;
-      p->n_cartas++;
-    }
-  }
-}
-
-// retorna a carta no topo de uma pilha. 
-// Quem chama precisa verificar se a pilha nao é vazia
-carta_t retorna_carta_topo(pilha_t *p)
-{
-  assert(!pilha_vazia(p));
-  return p->cartas[p->n_cartas - 1];
-}
-
-// retorna a carta no topo da pilha, removendo essa carta da pilha.
-// Quem chama precisa verificar se a pilha nao esta vazia
-carta_t remove_carta_topo(pilha_t *p)
-{ 
-  assert(!pilha_vazia(p));
-  carta_t c = retorna_carta_topo(p);
-  if (p->n_cartas == p->n_cartas_fechadas && p->n_cartas_fechadas > 0)
-    p->n_cartas_fechadas--;
-  p->n_cartas--;
-  return c;
-}
-
-// verifica se a bilha está fechada
-bool pilha_fechada(pilha_t *p)
-{
-  return p->n_cartas == p->n_cartas_fechadas;
-}
-
-// abre a carta do topo de uma pilha.
-void abre_carta_topo_pilha(pilha_t *p)
-{
-  assert(pilha_fechada(p));
-  p->n_cartas_fechadas--;
-}
-
-// fecha todas as cartas da pilha.
-void fecha_todas_cartas_pilha(pilha_t *p)
-{
-  assert(!pilha_vazia(p));
-  p->n_cartas_fechadas = p->n_cartas;
-}
-
-// esvazia a pilha
-void esvazia_pilha(pilha_t *p)
-{
-  p->n_cartas = 0;
-  p->n_cartas_fechadas = 0;
-}
-
-// gera baralho inteiro
-void gera_baralho_inteiro(pilha_t *p)
-{
-  for (naipe_t n = ouros; n <= paus; n++) {
-    for (valor_t v = as; v <= rei; v++) {
-      carta_t c = cria_carta(v,n);
-      p->cartas[p->n_cartas] = c;
-      p->n_cartas++;
-      p->n_cartas_fechadas++;
-    }
-  }
-}
-
-// embaralha cartas da pilha
-void embaralha_cartas_pilha(pilha_t *p)
-{
-  assert(!pilha_vazia(p));
-  srand(time(NULL));
-  int i = 0, j = 0, metade = N_MAX_CARTAS/2;
-  
-  for (i = 0; i < N_MAX_CARTAS; i++) {
-    // Gera um índice aleatório entre 0 e n_cartas (exclusivo)
-    // Troca apenas se o índice i for par
-    if (i % 2 == 0) {
-      // Gera um índice aleatório entre i e n_cartas (exclusivo)
-      //numero entre metade e N_MAX_CARTAS
-      if (i < metade)
-         j = (rand() % (N_MAX_CARTAS - metade)) + metade;
-      //numero entre 0 e N_MAX_CARTAS / 2
-      else
-        j = (rand() % (N_MAX_CARTAS - metade));
-    } else {
-      // Não realiza troca, mantém o índice atual
-      j = i;
-    }
-    // Troca as cartas nas posições i e j
-    carta_t temp = p->cartas[i];
-    p->cartas[i] = p->cartas[j];
-    p->cartas[j] = temp;
-  }
-
-  for (i = 0; i < N_MAX_CARTAS; i++) {
-    // Gera um índice aleatório entre 0 e n_cartas (exclusivo)
-    // Troca apenas se o índice i for impar
-    if (i % 2 != 0) {
-      if (i < metade)
-        j = (rand() % (N_MAX_CARTAS - metade));
-      else
-        j = (rand() % (N_MAX_CARTAS - metade)) + metade;
-    } else {
-      // Não realiza troca, mantém o índice atual
-      j = i;
-    }
-    // Troca as cartas nas posições i e j
-    carta_t temp = p->cartas[i];
-    p->cartas[i] = p->cartas[j];
-    p->cartas[j] = temp;
-  }
-  
-  i = 0;
-  while (i < N_MAX_CARTAS) {
-      if (i < metade)
-         j = (rand() % (N_MAX_CARTAS - metade)) + metade;
-      //numero entre 0 e N_MAX_CARTAS / 2
-      else
-        j = (rand() % (N_MAX_CARTAS - metade));
-      carta_t temp = p->cartas[j];
-      p->cartas[j] = p->cartas[i];
-      p->cartas[i] = temp;
-
-      i++;
-  }
-  
-}
-
-// retorna numero de cartas da pilha
-int numero_cartas_pilha(pilha_t *p)
-{
-  return p->n_cartas;
-}
-
-// retorna numero de cartas fechadas da pilha
-int numero_cartas_fechadas_pilha(pilha_t *p)
-{
-  return p->n_cartas_fechadas;
-}
-
-// retorna numero de cartas abertas da pilha
-int numero_cartas_abertas_pilha(pilha_t *p)
-{
-  return p->n_cartas - p->n_cartas_fechadas;
-}
-
-// verifica se posicao da carta na pilha é valida (não pode ser maior nem menor que o tamanho da pilha)
-bool posicao_valida(pilha_t *p, int pos)
-{
-  if (pos >= 0) {
-    if (pos < p->n_cartas) 
-      return true;
-    else 
-      return false;
-  } else {
-    if (p->n_cartas + pos >= 0)
-      return true;
-    else
-      return false;
-  }
-}
-
-// retorna carta de uma determinada posicao na pilha
-carta_t retorna_carta(pilha_t *p, int pos, bool *aberta)
-{
-  assert(posicao_valida(p,pos));
-  if (pos >= 0) {
-    if (aberta != NULL) {
-      if (pos >= p->n_cartas_fechadas)
-        *aberta = true;
-      else 
-        *aberta = false;
-    }
-    return p->cartas[pos];
-
-  } else { // numero negativo
-    if (aberta != NULL) {
-      if (p->n_cartas + pos >= p->n_cartas_fechadas)
-        *aberta = true;
-      else
-        *aberta = false;
-    }
-    return p->cartas[p->n_cartas + pos];
-  }
-}
-
-// cria a carta atribuindo valor e naipe
-carta_t cria_carta(valor_t valor, naipe_t naipe)
-{
-  carta_t c = {valor, naipe};
-  return c;
-}
-
-// retorna naipe da carta
-naipe_t naipe_carta(carta_t c)
-{
-  return c.naipe;
-}
-
-// retorna valor da carta
-valor_t valor_carta(carta_t c)
-{
-  return c.valor;
-}
-
-// retorna a cor de uma carta
-cor_t cor_carta(carta_t c)
-{
-  if (c.naipe == ouros || c.naipe == copas) {
-    return naipe_vermelho;
-  } else {
-    return naipe_preto;
-  }
-}
-
-// preenche a descricao da carta
-void descricao_carta(carta_t c, char *descricao)
-{
-  // Inicializa a string vazia
-  descricao[0] = '\0';
-
-  // Adiciona o valor da carta à string
-  switch (c.valor) {
-    case as:     sprintf(descricao, "A"); break;
-    case valete: sprintf(descricao, "J"); break;
-    case dama:   sprintf(descricao, "Q"); break;
-    case rei:    sprintf(descricao, "K"); break;
-    default:     sprintf(descricao, "%d", c.valor);
-  }
-
-  // Adiciona o naipe da carta à string
-  switch (c.naipe) {
-    case copas:   strcat(descricao, "\u2665"); break;
-    case ouros:   strcat(descricao, "\u2666"); break;
-    case paus:    strcat(descricao, "\u2663"); break;
-    case espadas: strcat(descricao, "\u2660"); break;
-  }
-}
-
-// compara se duas cartas são iguais
-bool compara_cartas(carta_t c1, carta_t c2)
-{
-  if (naipe_carta(c1) == naipe_carta(c2) && valor_carta(c1) == valor_carta(c2))
-    return true;
-  else 
-    return false;
-}
-
-// testa se a carta c pode ser empilhada na pilha p, no jogo "solitaire"
-bool pode_empilhar(carta_t c, pilha_t p)
-{
-  if (pilha_vazia(&p)) {
-    return c.valor == rei;
-  } else {
-    carta_t topo = p.cartas[p.n_cartas - 1];
-    if (cor_carta(c) == cor_carta(topo)) return false;
-    return c.valor == topo.valor - 1;
-  }
-}
-
-// Verifica as condicoes para mover n cartas 
-bool pode_mover(pilha_t *origem, pilha_t *destino, int n_cartas_a_mover) 
-{
-  if (origem->n_cartas - n_cartas_a_mover >= 0 && destino->n_cartas + n_cartas_a_mover <= N_MAX_CARTAS )
-    return true;
-  else
-    return false;
-}
-
-// Move uma quantidade de cartas em ordem
-void move_cartas_em_ordem(pilha_t *origem, pilha_t *destino, int n_cartas_a_mover)
-{
-  assert(pode_mover(origem,destino,n_cartas_a_mover));
-  int n_cartas_origem = origem->n_cartas;
-  int pos = n_cartas_origem - n_cartas_a_mover;
-
-  for (int i = pos; i < n_cartas_origem; i++) {
-    destino->cartas[destino->n_cartas] = origem->cartas[i];
-    destino->n_cartas++;
-  }   
-  origem->n_cartas -= n_cartas_a_mover;
-
-}
-
-// inicia as pilhas do jogo, distribuindo as cartas
-void inicia_pilhas_jogo(jogo_t *j)
-{
-  j->sair = false;
-  j->comando[0] = '\0';
-  // esvazia pilhas
-  esvazia_pilha(&j->monte);
-  esvazia_pilha(&j->descarte);
-  for (int i = 0; i < N_PILHAS_SAIDA; i++) {
-    esvazia_pilha(&j->pilhas_saida[i]);
-  }
-  for (int i = 0; i < N_PILHAS_PRINCIPAIS; i++) {
-    esvazia_pilha(&j->pilhas_principais[i]);
-  }
-
-  // gera baralho
-  gera_baralho_inteiro(&j->monte);
-
-  // embaralha as cartas
-  embaralha_cartas_pilha(&j->monte);
-
-  // distribui cartas na pilha
-  // nao precisa verificar se pode empilhar, pois é o inicio do jogo
-  for (int i = 0; i < N_PILHAS_PRINCIPAIS; i++) {
-    for (int k = 0; k < i+1; k++) {
-      empilha_carta(&j->pilhas_principais[i], remove_carta_topo(&j->monte));
-    }
-
-    fecha_todas_cartas_pilha(&j->pilhas_principais[i]);
-    abre_carta_topo_pilha(&j->pilhas_principais[i]);
-  }
-
-  j->tempo_ultima_jogada = tela_relogio();
-  j->pontos = 0.0;
-
-}
-
-// verifica se pode mover carta para pilha de saída
-bool pode_mover_para_pilha_saida(jogo_t *j, int n_pilha, carta_t c)
-{
-  if(n_pilha < 0 || n_pilha >= N_PILHAS_SAIDA) return false;
-
-  if ((pilha_vazia(&j->pilhas_saida[n_pilha]) && valor_carta(c) == as) || 
-      (!pilha_vazia(&j->pilhas_saida[n_pilha]) && naipe_carta(c) == naipe_carta(retorna_carta_topo(&j->pilhas_saida[n_pilha])) &&
-      valor_carta(c) == valor_carta(retorna_carta_topo(&j->pilhas_saida[n_pilha])) + 1)) {
-        return true;
-  } else {
-    return false;
-  }
-}
-
-// verifica se pode mover carta para pilha principal
-bool pode_mover_para_pilha_principal(jogo_t *j, int n_pilha, carta_t c)
-{
-  if(n_pilha < 0 || n_pilha >= N_PILHAS_PRINCIPAIS) return false;
-
-  if (pode_empilhar(c,j->pilhas_principais[n_pilha])) {
-      return true;
-  } else {
-    return false;
-  }
-}
-
-// verifica se pode mover cartas de uma pilha, só pode mover cartas abertas
-bool pode_mover_cartas_pilha(jogo_t *j, int n_pilha, int n_cartas_a_mover)
-{
-  if (n_pilha < 0 || n_pilha >= N_PILHAS_PRINCIPAIS) return false;
-
-  int n_cartas_abertas = numero_cartas_abertas_pilha(&j->pilhas_principais[n_pilha]);
-
-  if (n_cartas_a_mover <= n_cartas_abertas)
-    return true;
-  else
-    return false;
-
-}
-
-// verifica se venceu o jogo
-bool venceu_jogo(jogo_t *j)
-{
-  int total_cartas = 0;
-  for (int i = 0; i < N_PILHAS_SAIDA; i++){
-    total_cartas += numero_cartas_pilha(&j->pilhas_saida[i]);
-  }
-
-  return total_cartas == N_MAX_CARTAS;
-}
-
-// move a carta do topo do monte para o topo do descarte aberta
-bool abre_carta(jogo_t *j)
-{
-  if (!pilha_vazia(&j->monte)) {
-    empilha_carta(&j->descarte,remove_carta_topo(&j->monte));
-    return true;
-  } else {
-    return false;
-  }
-}
-
-// move todas as cartas do descarte para o monte
-bool recicla_descarte(jogo_t *j)
-{
-  if (pilha_vazia(&j->monte) && !pilha_vazia(&j->descarte)) {
-    int num_cartas_descarte = numero_cartas_pilha(&j->descarte);
-    for (int i = 0; i < num_cartas_descarte; i++) {
-      empilha_carta(&j->monte,remove_carta_topo(&j->descarte));
-    }
-    fecha_todas_cartas_pilha(&j->monte);
-    // reciclagem do descarte zera os pontos
-    j->pontos = 0;
-    return true;
-  } else {
-    return false;
-  }
-}
-
-// move carta do descarte para saida
-bool move_carta_descarte_para_saida(jogo_t *j, int n_pilha)
+#include "estimador.h"
+#include "resolvedor.h"
+#include "banco.h"
+#include "acervo.h"
+#include "reproducao.h"
+#include "publicacao.h"
+#include "telemetria.h"
+#include "metricas.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <math.h>
+
+// compara avaliações pela probabilidade de vitória, da maior para a menor
+static int compara_avaliacoes(const void *a, const void *b)
 {
-  if (!pilha_vazia(&j->descarte) && pode_mover_para_pilha_saida(j,n_pilha,retorna_carta_topo(&j->descarte))) {
-    empilha_carta(&j->pilhas_saida[n_pilha],remove_carta_topo(&j->descarte));
-    // carta colocada na pilha de saida da 15 pontos;
-    j->pontos += 15;
-    j->tempo_ultima_jogada = tela_relogio();
-    return true;
-  } else {
-    return false;
-  }
-}
-
-// move carta do descarte para jogo
-bool move_carta_descarte_para_jogo(jogo_t *j, int n_pilha)
-{
-  if (!pilha_vazia(&j->descarte) && pode_mover_para_pilha_principal(j,n_pilha,retorna_carta_topo(&j->descarte))) {
-    empilha_carta(&j->pilhas_principais[n_pilha],remove_carta_topo(&j->descarte));
-    // carta movida do descarte para pilha de jogo dá 10 pontos + bonus
-    j->pontos = j->pontos + 10 + bonus(j,10);
-    return true;
-  } else {
-    return false;
-  }
+  double pa = ((const avaliacao_t *)a)->probabilidade;
+  double pb = ((const avaliacao_t *)b)->probabilidade;
+  return (pa < pb) - (pa > pb);
 }
 
-// move carta do jogo para a saida
-bool move_carta_jogo_para_saida(jogo_t *j, int n_pilha_jogo, int n_pilha_saida) 
+// estima a chance de vitória de cada jogada e descreve as melhores em j->analise
+void analisa_jogadas(jogo_t *j)
 {
-  
-  if (n_pilha_jogo < 0 || n_pilha_jogo >= N_PILHAS_PRINCIPAIS) return false;
+  avaliacao_t avaliacoes[N_MAX_JOGADAS];
+  int n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int n = estima_probabilidades(j, avaliacoes, n_threads, TEMPO_ESTIMATIVA, 0, time(NULL));
 
-  if (!pilha_vazia(&j->pilhas_principais[n_pilha_jogo]) &&
-      pode_mover_para_pilha_saida(j,n_pilha_saida,retorna_carta_topo(&j->pilhas_principais[n_pilha_jogo]))) {
-    
-    empilha_carta(&j->pilhas_saida[n_pilha_saida],remove_carta_topo(&j->pilhas_principais[n_pilha_jogo]));
-    // carta colocada na pilha de saida da 15 pontos;
-    j->pontos += 15;
-
-    //abre a carta do topo se ela nao estover aberta
-    if (numero_cartas_pilha(&j->pilhas_principais[n_pilha_jogo]) > 0 && 
-        numero_cartas_fechadas_pilha(&j->pilhas_principais[n_pilha_jogo]) > 0 &&
-        pilha_fechada(&j->pilhas_principais[n_pilha_jogo])) {
-
-      abre_carta_topo_pilha(&j->pilhas_principais[n_pilha_jogo]);
-      // abertura de carta na pilha de jogo dá 20 pontos + bônus;
-      j->pontos = j->pontos + 20 + bonus(j,20);
-    }
-    
-    return true;
-  } else {
-    return false;
+  if (n == 0) {
+    sprintf(j->analise, "Análise: nenhuma jogada possível");
+    return;
   }
-}
 
-// move carta da saida para o jogo
-bool move_carta_saida_para_jogo(jogo_t *j, int n_pilha_saida, int n_pilha_jogo) 
-{
-  
-  if (n_pilha_saida < 0 || n_pilha_saida >= N_PILHAS_SAIDA) return false;
-
-  // adicionar verificacao de a pilha nao estar vazia
-  if (!pilha_vazia(&j->pilhas_saida[n_pilha_saida]) &&
-      pode_mover_para_pilha_principal(j,n_pilha_jogo,retorna_carta_topo(&j->pilhas_saida[n_pilha_saida]))) {
-    empilha_carta(&j->pilhas_principais[n_pilha_jogo],remove_carta_topo(&j->pilhas_saida[n_pilha_saida]));
-    // carta retirada de pilha de saída retira 15 pontos.
-    if (j->pontos - 15 < 0)
-      j->pontos = 0;
-    else
-      j->pontos -= 15;
-    j->tempo_ultima_jogada = tela_relogio();
-    return true;
-  } else {
-    return false;
+  qsort(avaliacoes, n, sizeof(avaliacao_t), compara_avaliacoes);
+  int nchar = sprintf(j->analise, "Análise:");
+  for (int i = 0; i < n && i < 5; i++) {
+    char comando[MAX_CHAR_CMD+1];
+    descricao_jogada(avaliacoes[i].jogada, comando);
+    nchar += sprintf(j->analise + nchar, "  %s %.0f%%", comando, avaliacoes[i].probabilidade * 100);
   }
 }
 
-// move tantas cartas de uma pilha do jogo para outra pilha do jogo
-bool move_cartas_entre_pilhas_jogo_com_qtde(jogo_t *j, int n_pilha1, int n_pilha2, int n_cartas_a_mover)
+// procura uma solução com busca em feixe e descreve em j->analise a próxima jogada da melhor linha
+void mostra_dica(jogo_t *j)
 {
-  if(n_pilha1 < 0 || n_pilha1 >= N_PILHAS_PRINCIPAIS || n_pilha2 < 0 || n_pilha2 >= N_PILHAS_PRINCIPAIS)
-    return false;
-
-  if (pode_mover_cartas_pilha(j,n_pilha1,n_cartas_a_mover) &&
-      pode_mover(&j->pilhas_principais[n_pilha1],&j->pilhas_principais[n_pilha2],n_cartas_a_mover)) {
-    move_cartas_em_ordem(&j->pilhas_principais[n_pilha1],&j->pilhas_principais[n_pilha2],n_cartas_a_mover);
-    
-    // esse trecho estava em move cartas em ordem
-    if (numero_cartas_pilha(&j->pilhas_principais[n_pilha1]) > 0 && 
-        numero_cartas_fechadas_pilha(&j->pilhas_principais[n_pilha1]) > 0 && 
-        pilha_fechada(&j->pilhas_principais[n_pilha1])) {
-      abre_carta_topo_pilha(&j->pilhas_principais[n_pilha1]);
-      j->pontos = j->pontos + 20 + bonus(j,20);
-    }
-
-    return true;
+  parametros_feixe_t par;
+  parametros_feixe_padrao(&par);
+  par.largura = LARGURA_DICA;
+  par.limite_memoria = MEMORIA_DICA;
+  par.limite_tempo = TEMPO_DICA;
+
+  resultado_busca_t *res = malloc(sizeof(resultado_busca_t));
+  assert(res != NULL);
+  busca_em_feixe(j, &par, res);
+
+  if (res->n_jogadas == 0) {
+    sprintf(j->analise, "Dica: nenhuma jogada melhora o jogo");
   } else {
-    return false;
-  }
-}
-
-// descobre quantas cartas devem ser movidas de uma pilha para outra
-bool move_cartas_entre_pilhas_jogo(jogo_t *j, int n_pilha1, int n_pilha2)
-{
-  if(n_pilha1 < 0 || n_pilha1 >= N_PILHAS_PRINCIPAIS || n_pilha2 < 0 || n_pilha2 >= N_PILHAS_PRINCIPAIS)
-    return false;
-  
-  int n_cartas_a_mover = numero_cartas_abertas_pilha(&j->pilhas_principais[n_pilha1]);
-  int lim_max = numero_cartas_pilha(&j->pilhas_principais[n_pilha1]);
-  int lim_min = numero_cartas_fechadas_pilha(&j->pilhas_principais[n_pilha1]);
-  int i = 0;
-
-  for (i = lim_min; i < lim_max; i++) {
-    if (pode_empilhar(retorna_carta(&j->pilhas_principais[n_pilha1],i,NULL),j->pilhas_principais[n_pilha2])) {
-      break;
-    } else{
-      n_cartas_a_mover--;
-    }
-  }
-
-  if (n_cartas_a_mover > 0) {
-    move_cartas_entre_pilhas_jogo_com_qtde(j,n_pilha1,n_pilha2,n_cartas_a_mover);
-    return true;
-  } else {
-    return false;
-  }
-}
-
-// verifica qual é a jogada e chama a respectiva funcao que move as cartas
-bool realiza_jogada(jogo_t *j, char *jogada)
-{
-  if (jogada == NULL || jogada[0] == '\0') {
-    return false;
-  }
-
-  char origem_char = jogada[0];
-  char destino_char;
-  if (jogada[1] == '\0'){
-    if (jogada[0] == 'm')
-      destino_char = 'p';
-    else if (jogada[0] == 'p')
-      destino_char = 'm';
-    else if (jogada[0] == 'f')
-      j->sair = true;
-  } else destino_char = jogada[1];
-
-  origem_char = toupper(origem_char);
-  destino_char = toupper(destino_char);
-
-  int origem, destino;
-  
-  // Mapeia os caracteres para índices numéricos
-  if (origem_char >= 'A' && origem_char <= 'D') {
-    origem = origem_char - 'A';
-  } else if (origem_char >= '1' && origem_char <= '7') {
-    origem = origem_char - '1';
-  } else if (origem_char != 'M' && origem_char != 'P') {
-    return false;
-  }
-
-  if (destino_char >= 'A' && destino_char <= 'D') {
-    destino = destino_char - 'A';
-  } else if (destino_char >= '1' && destino_char <= '7') {
-    destino = destino_char - '1';
-  } else if (destino_char != 'P' && destino_char != 'M') {
-    return false;
-  }
-  
-  //só pode mover da saida para pilha do jogo
-  if (origem_char >= 'A' && origem_char <= 'D') {
-    if (destino_char >= '1' && destino_char <= '7') 
-      return move_carta_saida_para_jogo(j,origem,destino);
-    else 
-      return false;
-  } else if (origem_char >= '1' && origem_char <= '7') { 
-    //só pode mover da pilha do jogo, para outra do jogo ou para saida
-    if (destino_char >= '1' && destino_char <= '7') 
-      return move_cartas_entre_pilhas_jogo(j,origem,destino);
-    else if (destino_char >= 'A' && destino_char <= 'D') 
-      return move_carta_jogo_para_saida(j,origem,destino);
-    else 
-      return false;
-  
-  } else if (origem_char == 'M') {
-    // só pode mover para descarte
-    if (destino_char == 'P')
-      return abre_carta(j);
-    else 
-      return false;
-  
-  } else if (origem_char == 'P') {
-    // pode reciclar descarte, mover para jogo ou saida
-    if (destino_char == 'M') 
-      return recicla_descarte(j);
-    else if (destino_char >= '1' && destino_char <= '7')
-      return move_carta_descarte_para_jogo(j,destino);
-    else if (destino_char >= 'A' && destino_char <= 'D')
-      return move_carta_descarte_para_saida(j,destino);
+    char comando[MAX_CHAR_CMD+1];
+    descricao_jogada(res->jogadas[0], comando);
+    if (res->resolvido)
+      sprintf(j->analise, "Dica: %s (vitória em %d jogadas)", comando, res->n_jogadas);
     else
-      return false;
-  } else {
-    return false;
+      sprintf(j->analise, "Dica: %s (sem solução encontrada)", comando);
   }
-
+  free(res);
 }
 
 // lê o caractere digitado pelo usuário e armazena na "string" comando 
 void processa_teclado(jogo_t * j)
 {
-  char tecla;
+  trata_tecla(j, tela_tecla());
+}
 
-  tecla = tela_tecla();
+// acrescenta uma tecla ao comando do jogo, realizando a jogada no enter
+void trata_tecla(jogo_t *j, char tecla)
+{
   if (tecla == '\0') return;
 
   int nchar = strlen(j->comando);
@@ -692,7 +102,15 @@ void processa_teclado(jogo_t * j)
       break;
     case '\n':
       if (nchar > 0) {
-        realiza_jogada(j, j->comando);
+        // '?' pede a análise das jogadas possíveis e 'd' uma dica do resolvedor
+        if (strcmp(j->comando, "?") == 0) {
+          analisa_jogadas(j);
+        } else if (strcmp(j->comando, "d") == 0) {
+          mostra_dica(j);
+        } else {
+          j->analise[0] = '\0';
+          realiza_jogada(j, j->comando);
+        }
         j->comando[0] = '\0';
       }
       break;
@@ -707,41 +125,47 @@ void processa_teclado(jogo_t * j)
 
 }
 
+// disposição usada pelos desenhos e pelo mouse, escolhida por usa_disposicao()
+static disposicao_t *disposicao = NULL;
+
 // desenha local da pilha
 void desenho_de_local(int lin, int col)
 {
-  tela_retangulo(col, lin, col+CARTA_LARGURA, lin+CARTA_ALTURA, 1, branco, transparente);
+  disposicao_t *d = disposicao;
+  tela_retangulo(col, lin, col+d->carta_largura, lin+d->carta_altura, 1, branco, transparente);
 }
 
 // desenha carta fechada
 void desenho_de_carta_fechada(int lin, int col)
 {
-  tela_retangulo(col, lin, col+CARTA_LARGURA, lin+CARTA_ALTURA, 2, branco, marrom);
+  disposicao_t *d = disposicao;
+  tela_retangulo(col, lin, col+d->carta_largura, lin+d->carta_altura, 2, branco, marrom);
   char txt[30];
   txt[0] = '\0';
   strcat(txt, "\u2592");
   int tam_borda_carta = 2;
-  int tam_letra = CARTA_LARGURA - 4;
-  int posXtexto = col + CARTA_LARGURA / 2 + tam_borda_carta/2;
-  int posYtexto = lin + CARTA_ALTURA / 3;
+  int tam_letra = d->letra_verso;
+  int posXtexto = col + d->carta_largura / 2 + tam_borda_carta/2;
+  int posYtexto = lin + d->carta_altura / 3;
   tela_texto(posXtexto, posYtexto, tam_letra, branco, txt);
 }
 
 // desenha carta aberta
 void desenho_de_carta_aberta(int lin, int col, carta_t carta)
 {
+  disposicao_t *d = disposicao;
   char txt[50];
   int cor;
   int tam_borda_carta = 2;
-  int tam_letra = CARTA_LARGURA / 5;
-  int posXtexto = col + CARTA_LARGURA / 4;
-  int posYtexto = lin + CARTA_ALTURA / 15 + tam_borda_carta;
+  int tam_letra = d->letra_valor;
+  int posXtexto = col + d->carta_largura / 4;
+  int posYtexto = lin + d->carta_altura / 15 + tam_borda_carta;
   descricao_carta(carta,txt);
   if (cor_carta(carta) == naipe_vermelho)
     cor = vermelho;
   else
     cor = preto;
-  tela_retangulo(col, lin, col+CARTA_LARGURA, lin+CARTA_ALTURA, tam_borda_carta, cor, branco);
+  tela_retangulo(col, lin, col+d->carta_largura, lin+d->carta_altura, tam_borda_carta, cor, branco);
   tela_texto(posXtexto, posYtexto, tam_letra, cor,txt);
   char naipe[5];
   naipe[0] = '\0';
@@ -751,8 +175,8 @@ void desenho_de_carta_aberta(int lin, int col, carta_t carta)
     case paus:    strcat(naipe, "\u2663"); break;
     case espadas: strcat(naipe, "\u2660"); break;
   }
-  tela_texto(col+CARTA_LARGURA/2, lin + CARTA_ALTURA/2, CARTA_LARGURA/2, cor,naipe);
-  tela_texto_esq(col+CARTA_LARGURA - tam_borda_carta, lin + CARTA_ALTURA - CARTA_ALTURA/6 - tam_borda_carta, tam_letra,cor,txt);
+  tela_texto(col+d->carta_largura/2, lin + d->carta_altura/2, d->letra_naipe, cor,naipe);
+  tela_texto_esq(col+d->carta_largura - tam_borda_carta, lin + d->carta_altura - d->carta_altura/6 - tam_borda_carta, tam_letra,cor,txt);
 }
 
 // desenha pilha fechada
@@ -769,6 +193,7 @@ void desenho_de_pilha_fechada(int lin, int col, pilha_t *p)
 // desenha pilha aberta
 void desenho_de_pilha_aberta(int lin, int col, pilha_t *p)
 {
+  disposicao_t *d = disposicao;
   int num_cartas_pilha = numero_cartas_pilha(p);
   int num_cartas_fechadas = numero_cartas_fechadas_pilha(p);
 
@@ -776,7 +201,7 @@ void desenho_de_pilha_aberta(int lin, int col, pilha_t *p)
     for (int i = 0; i < num_cartas_pilha; i++) {
       if (i > 0) {
         //atualizar os valores de lin
-        lin += CARTA_ALTURA/5;
+        lin += d->deslocamento_carta;
       }
       if (i < num_cartas_fechadas) 
         desenho_de_carta_fechada(lin,col);
@@ -791,6 +216,7 @@ void desenho_de_pilha_aberta(int lin, int col, pilha_t *p)
 // desenha pilha compactada
 void desenho_compacto_de_pilha_aberta(int lin, int col, pilha_t *p)
 {
+  disposicao_t *d = disposicao;
   int num_cartas_fechadas = numero_cartas_fechadas_pilha(p);
   int num_cartas_abertas = numero_cartas_abertas_pilha(p);
   if (!pilha_vazia(p)) {
@@ -800,26 +226,26 @@ void desenho_compacto_de_pilha_aberta(int lin, int col, pilha_t *p)
     if (num_cartas_fechadas > 2) {
       // desenha a primeira fechada
       desenho_de_carta_fechada(lin,col);
-      lin += CARTA_ALTURA / 5;
+      lin += d->deslocamento_carta;
 
       // desenha a fechada especial
       sprintf(txt, "%d fechada(s)",num_cartas_fechadas - 2);
       int tam_borda_carta = 2;
-      int tam_letra = CARTA_LARGURA / 6;
-      int posXtexto = col + CARTA_LARGURA / 3 + tam_borda_carta + tam_letra;
-      int posYtexto = lin + CARTA_ALTURA / 15;
-      tela_retangulo(col, lin, col+CARTA_LARGURA, lin+CARTA_ALTURA, tam_borda_carta, branco, marrom);
+      int tam_letra = d->letra_contagem;
+      int posXtexto = col + d->carta_largura / 3 + tam_borda_carta + tam_letra;
+      int posYtexto = lin + d->carta_altura / 15;
+      tela_retangulo(col, lin, col+d->carta_largura, lin+d->carta_altura, tam_borda_carta, branco, marrom);
       tela_texto(posXtexto, posYtexto, tam_letra, branco,txt);
-      lin += CARTA_ALTURA / 5;
+      lin += d->deslocamento_carta;
 
       //desenha a ultima fechada
       desenho_de_carta_fechada(lin,col);
-      lin += CARTA_ALTURA / 5;
+      lin += d->deslocamento_carta;
 
     } else if (num_cartas_fechadas > 0 && num_cartas_fechadas <= 2) {
       for (int i = 0; i < num_cartas_fechadas; i++) {
         desenho_de_carta_fechada(lin,col);
-        lin += CARTA_ALTURA / 5;
+        lin += d->deslocamento_carta;
       }
     } else {
       desenho_de_local(lin,col);
@@ -829,29 +255,29 @@ void desenho_compacto_de_pilha_aberta(int lin, int col, pilha_t *p)
     if (num_cartas_abertas > 2) {
       //desenha a primeira aberta, a especial e a carta do topo
       desenho_de_carta_aberta(lin,col,retorna_carta(p,num_cartas_fechadas,NULL));
-      lin += CARTA_ALTURA / 5;
+      lin += d->deslocamento_carta;
       //carta especial abaixo
       txt[0] = '\0';
       sprintf(txt, "%d aberta(s)",num_cartas_abertas-2);
       int tam_borda_carta = 2;
-      int tam_letra = CARTA_LARGURA/6;
-      int posXtexto = col + CARTA_LARGURA / 3 + tam_borda_carta + tam_letra;
-      int posYtexto = lin + CARTA_ALTURA / 15;
+      int tam_letra = d->letra_contagem;
+      int posXtexto = col + d->carta_largura / 3 + tam_borda_carta + tam_letra;
+      int posYtexto = lin + d->carta_altura / 15;
       int cor;
       if (cor_carta(retorna_carta_topo(p)) == naipe_vermelho)
         cor = preto;
       else
         cor = vermelho;
-      tela_retangulo(col, lin, col+CARTA_LARGURA, lin+CARTA_ALTURA, tam_borda_carta, cor, branco);
+      tela_retangulo(col, lin, col+d->carta_largura, lin+d->carta_altura, tam_borda_carta, cor, branco);
       tela_texto(posXtexto, posYtexto, tam_letra, cor,txt);
       // carta especial acima
-      lin += CARTA_ALTURA / 5;
+      lin += d->deslocamento_carta;
       desenho_de_carta_aberta(lin,col,retorna_carta_topo(p));
-      lin += CARTA_ALTURA / 5;
+      lin += d->deslocamento_carta;
     } else if (num_cartas_abertas > 0 && num_cartas_abertas <= 2) {
       for (int i = 0; i < num_cartas_abertas; i++) {
         desenho_de_carta_aberta(lin,col,retorna_carta(p,num_cartas_fechadas+i,NULL));
-        lin += CARTA_ALTURA / 5;
+        lin += d->deslocamento_carta;
       }
     } else {
       desenho_de_local(lin,col);
@@ -863,74 +289,145 @@ void desenho_compacto_de_pilha_aberta(int lin, int col, pilha_t *p)
 }
 
 // define as coordenadas x, y iniciais de cada pilha
-void inicializa_coordenadas(jogo_t *j)
+void inicializa_coordenadas(disposicao_t *d)
 {
-  int deslocamento_horizontal = LARGURA / 10;
-  int deslocamento_vertical = ESPACO_ENTRE_CARTAS * 2;
+  int deslocamento_horizontal = d->esquerda + d->largura / 10;
+  int deslocamento_vertical = d->espaco_entre_cartas * 2;
 
   for (int i = 0; i < N_PILHAS; i++) {
     if (i < 2) {
-      j->coordenadas_pilhas[i].col = deslocamento_horizontal;
-      j->coordenadas_pilhas[i].lin = deslocamento_vertical;
-      deslocamento_horizontal += CARTA_LARGURA + ESPACO_ENTRE_CARTAS;
+      d->pilhas[i].col = deslocamento_horizontal;
+      d->pilhas[i].lin = deslocamento_vertical;
+      deslocamento_horizontal += d->carta_largura + d->espaco_entre_cartas;
     } else if (i >= 2 && i <= 5) {
-      deslocamento_horizontal += CARTA_LARGURA + ESPACO_ENTRE_CARTAS;
-      j->coordenadas_pilhas[i].col = deslocamento_horizontal;
-      j->coordenadas_pilhas[i].lin = deslocamento_vertical;
+      deslocamento_horizontal += d->carta_largura + d->espaco_entre_cartas;
+      d->pilhas[i].col = deslocamento_horizontal;
+      d->pilhas[i].lin = deslocamento_vertical;
     } else {
       if (i == 6) {
-        deslocamento_horizontal = LARGURA/10;
-        deslocamento_vertical += CARTA_ALTURA + ESPACO_ENTRE_CARTAS*3;
+        deslocamento_horizontal = d->esquerda + d->largura / 10;
+        deslocamento_vertical += d->carta_altura + d->espaco_entre_cartas*3;
       }
-      j->coordenadas_pilhas[i].col = deslocamento_horizontal;
-      j->coordenadas_pilhas[i].lin = deslocamento_vertical;
-      deslocamento_horizontal += CARTA_LARGURA + ESPACO_ENTRE_CARTAS;
+      d->pilhas[i].col = deslocamento_horizontal;
+      d->pilhas[i].lin = deslocamento_vertical;
+      deslocamento_horizontal += d->carta_largura + d->espaco_entre_cartas;
     }
   }
 
 }
 
+// desenha a identificação das pilhas
+static void desenho_da_identificacao(disposicao_t *d)
+{
+  char c[2];
+  c[0] = c[1] = '\0';
+  for (int i = 0; i < N_PILHAS; i++) {
+    if (i == 0) {
+      tela_texto_esq(d->pilhas[i].col + d->carta_largura / 2 + d->espaco_entre_cartas / 4 + 2, d->pilhas[i].lin - d->espaco_entre_cartas - d->espaco_entre_cartas / 4, d->letra_pilha, amarelo, "M");
+    } else if (i == 1) {
+      tela_texto_esq(d->pilhas[i].col + d->carta_largura / 2 + d->espaco_entre_cartas / 4, d->pilhas[i].lin - d->espaco_entre_cartas - d->espaco_entre_cartas / 4, d->letra_pilha, amarelo, "P");
+    } else if (i >= 2 && i <= 5) {
+      c[0] = 'A' - 2 + i;
+      tela_texto_esq(d->pilhas[i].col + d->carta_largura / 2 + d->espaco_entre_cartas / 4, d->pilhas[i].lin - d->espaco_entre_cartas - d->espaco_entre_cartas / 4, d->letra_pilha, amarelo, c);
+    } else {
+      c[0] = '1' - 6 + i;
+      tela_texto_esq(d->pilhas[i].col + d->carta_largura / 2 + d->espaco_entre_cartas / 4, d->pilhas[i].lin - d->espaco_entre_cartas - d->espaco_entre_cartas / 4, d->letra_pilha, amarelo, c);
+    }
+  }
+}
+
+// calcula os tamanhos na escala da área e refaz o mapa de toque e a camada do fundo
+void calcula_disposicao(disposicao_t *d, int largura, int altura)
+{
+  // em uma área minúscula (um tabuleiro do -m em uma janela pequena) nada pode ficar
+  // com tamanho zero: as fileiras do mapa de toque são divididas pelo deslocamento
+  if (largura < 1) largura = 1;
+  if (altura < 1) altura = 1;
+  d->largura_area = largura;
+  d->altura = altura;
+  d->escala = fminf((float)largura / LARGURA, (float)altura / ALTURA);
+  d->largura = LARGURA * d->escala;
+  d->esquerda = (largura - d->largura) / 2;
+  d->carta_largura = d->largura / 11;
+  d->carta_altura = ALTURA * d->escala / 5;
+  d->espaco_entre_cartas = d->largura / 36;
+  d->deslocamento_carta = d->carta_altura / 5;
+  if (d->carta_largura < 1) d->carta_largura = 1;
+  if (d->carta_altura < 1) d->carta_altura = 1;
+  if (d->deslocamento_carta < 1) d->deslocamento_carta = 1;
+  d->letra_titulo = d->largura / 40;
+  d->letra_texto = d->largura / 50;
+  d->letra_pilha = d->carta_largura / 3;
+  d->letra_valor = d->carta_largura / 5;
+  d->letra_naipe = d->carta_largura / 2;
+  d->letra_verso = d->carta_largura - 4;
+  d->letra_contagem = d->carta_largura / 6;
+  inicializa_coordenadas(d);
+  monta_mapa_toque(d);
+
+  if (!d->iniciada)
+    d->camada_fundo = tela_cria_camada(largura, altura);
+  else
+    tela_redimensiona_camada(d->camada_fundo, largura, altura);
+  d->iniciada = true;
+  tela_desenha_em_camada(d->camada_fundo);
+  tela_limpa();
+  desenho_da_identificacao(d);
+  tela_desenha_em_camada(-1);
+}
+
+void usa_disposicao(disposicao_t *d)
+{
+  disposicao = d;
+}
+
+// se a pilha principal k não cabe até o fim da janela e é desenhada de forma compacta
+static bool pilha_compacta(jogo_t *j, int k)
+{
+  disposicao_t *d = disposicao;
+  int num_cartas_pilha = numero_cartas_pilha(&j->pilhas_principais[k]);
+  int lim_maximo_tela = d->altura - d->carta_altura / 2;
+  int espaco_da_pilha = num_cartas_pilha * d->deslocamento_carta + d->pilhas[PILHA_PRINCIPAL + k].lin + d->carta_altura;
+  return espaco_da_pilha >= lim_maximo_tela;
+}
+
 // desenha todas as pilhas 
 void desenho_das_pilhas(jogo_t *j)
 {
+  disposicao_t *d = disposicao;
   int i = 0;
   // desenho do monte
   if (numero_cartas_pilha(&j->monte) > 0) {
-    desenho_de_pilha_fechada(j->coordenadas_pilhas[i].lin,j->coordenadas_pilhas[i].col,&j->monte);
+    desenho_de_pilha_fechada(d->pilhas[i].lin,d->pilhas[i].col,&j->monte);
   } else
-    desenho_de_local(j->coordenadas_pilhas[i].lin,j->coordenadas_pilhas[i].col);
+    desenho_de_local(d->pilhas[i].lin,d->pilhas[i].col);
   i++;
   
   // desenho do descarte
   if (numero_cartas_pilha(&j->descarte) > 0)
-    desenho_de_carta_aberta(j->coordenadas_pilhas[i].lin,j->coordenadas_pilhas[i].col,retorna_carta_topo(&j->descarte));
+    desenho_de_carta_aberta(d->pilhas[i].lin,d->pilhas[i].col,retorna_carta_topo(&j->descarte));
   else
-    desenho_de_local(j->coordenadas_pilhas[i].lin,j->coordenadas_pilhas[i].col);
+    desenho_de_local(d->pilhas[i].lin,d->pilhas[i].col);
   i++;
 
   // desenho das pilhas de saida
   for (int k = 0; k < N_PILHAS_SAIDA; k++) {
     if (numero_cartas_pilha(&j->pilhas_saida[k]) > 0) 
-      desenho_de_carta_aberta(j->coordenadas_pilhas[i].lin,j->coordenadas_pilhas[i].col,retorna_carta_topo(&j->pilhas_saida[k]));
+      desenho_de_carta_aberta(d->pilhas[i].lin,d->pilhas[i].col,retorna_carta_topo(&j->pilhas_saida[k]));
     else 
-      desenho_de_local(j->coordenadas_pilhas[i].lin,j->coordenadas_pilhas[i].col);
+      desenho_de_local(d->pilhas[i].lin,d->pilhas[i].col);
     i++;
   }
 
   // desenho das pilhas principais
   for (int k = 0; k < N_PILHAS_PRINCIPAIS; k++) {
     if (numero_cartas_pilha(&j->pilhas_principais[k]) > 0) {
-      
-      int num_cartas_pilha = numero_cartas_pilha(&j->pilhas_principais[k]);
-      int lim_maximo_tela = ALTURA - CARTA_ALTURA / 2;
-      int espaco_da_pilha = num_cartas_pilha * (CARTA_ALTURA / 5) + j->coordenadas_pilhas[i].lin + CARTA_ALTURA;
-
-      if (espaco_da_pilha < lim_maximo_tela) 
-        desenho_de_pilha_aberta(j->coordenadas_pilhas[i].lin,j->coordenadas_pilhas[i].col,&j->pilhas_principais[k]); 
+      if (!pilha_compacta(j, k)) 
+        desenho_de_pilha_aberta(d->pilhas[i].lin,d->pilhas[i].col,&j->pilhas_principais[k]); 
       else
-        desenho_compacto_de_pilha_aberta(j->coordenadas_pilhas[i].lin,j->coordenadas_pilhas[i].col,&j->pilhas_principais[k]); 
+        desenho_compacto_de_pilha_aberta(d->pilhas[i].lin,d->pilhas[i].col,&j->pilhas_principais[k]); 
     } else {
-      desenho_de_local(j->coordenadas_pilhas[i].lin,j->coordenadas_pilhas[i].col);
+      desenho_de_local(d->pilhas[i].lin,d->pilhas[i].col);
     }
     i++;
   }
@@ -939,17 +436,25 @@ void desenho_das_pilhas(jogo_t *j)
 // desenhas coisas extras na tela
 void desenhos_de_extras(jogo_t *j)
 {
+  disposicao_t *d = disposicao;
   // pontuacao
   char pontuacao [30];
   sprintf(pontuacao,"Pontos: %.2f",j->pontos);
-  tela_texto_esq(LARGURA - LARGURA/10,ALTURA - ALTURA/10,LARGURA/40,amarelo,pontuacao);
+  tela_texto_esq(d->esquerda + d->largura - d->largura/10,d->altura - d->altura/10,d->letra_titulo,amarelo,pontuacao);
 
   // comando 
   char jogada [30];
   sprintf(jogada,"Digite sua jogada: %s",j->comando);
-  tela_texto_dir(LARGURA/10,ALTURA - ALTURA/10,LARGURA/40,amarelo,jogada);
+  tela_texto_dir(d->esquerda + d->largura/10,d->altura - d->altura/10,d->letra_titulo,amarelo,jogada);
+
+  // resultado da análise, se foi pedida
+  if (j->analise[0] != '\0')
+    tela_texto_dir(d->esquerda + d->largura/10,d->altura - d->altura/20,d->letra_texto,branco,j->analise);
+}
 
-  // mouse
+// desenha o mouse
+void desenho_do_rato(void)
+{
   int rx, ry;
   tela_rato_pos(&rx, &ry);
 
@@ -957,132 +462,691 @@ void desenhos_de_extras(jogo_t *j)
   tela_circulo(rx, ry, 5, 2, naipe_vermelho, verde);
 }
 
-// desenho de fundo do jogo
-void desenho_do_fundo(jogo_t *j)
+// cartas que aparecem em cada fileira de uma pilha desenhada de forma compacta, como em
+// desenho_compacto_de_pilha_aberta(); a fileira que só mostra quantas cartas estão
+// escondidas vale pela primeira delas. retorna o número de fileiras
+static int fileiras_compactas(pilha_t *p, int cartas[6])
 {
-  inicializa_coordenadas(j);
-  //identificacao da pilha
-  char c[1];
-  c[0] = '\0';
-  for (int i = 0; i < N_PILHAS; i++) {
-    if (i == 0) {
-      tela_texto_esq(j->coordenadas_pilhas[i].col + CARTA_LARGURA / 2 + ESPACO_ENTRE_CARTAS / 4 + 2, j->coordenadas_pilhas[i].lin - ESPACO_ENTRE_CARTAS - ESPACO_ENTRE_CARTAS / 4, CARTA_LARGURA / 3, amarelo, "M");
-    } else if (i == 1) {
-      tela_texto_esq(j->coordenadas_pilhas[i].col + CARTA_LARGURA / 2 + ESPACO_ENTRE_CARTAS / 4, j->coordenadas_pilhas[i].lin - ESPACO_ENTRE_CARTAS - ESPACO_ENTRE_CARTAS / 4, CARTA_LARGURA / 3, amarelo, "P");
-    } else if (i >= 2 && i <= 5) {
-      c[0] = 'A' - 2 + i;
-      tela_texto_esq(j->coordenadas_pilhas[i].col + CARTA_LARGURA / 2 + ESPACO_ENTRE_CARTAS / 4, j->coordenadas_pilhas[i].lin - ESPACO_ENTRE_CARTAS - ESPACO_ENTRE_CARTAS / 4, CARTA_LARGURA / 3, amarelo, c);
-    } else {
-      c[0] = '1' - 6 + i;
-      tela_texto_esq(j->coordenadas_pilhas[i].col + CARTA_LARGURA / 2 + ESPACO_ENTRE_CARTAS / 4, j->coordenadas_pilhas[i].lin - ESPACO_ENTRE_CARTAS - ESPACO_ENTRE_CARTAS / 4, CARTA_LARGURA / 3, amarelo, c);
+  int fechadas = numero_cartas_fechadas_pilha(p);
+  int n = numero_cartas_pilha(p);
+  int f = 0;
+  if (fechadas > 2) {
+    cartas[f++] = 0;
+    cartas[f++] = 1;
+    cartas[f++] = fechadas - 1;
+  } else {
+    for (int i = 0; i < fechadas; i++) cartas[f++] = i;
+  }
+  if (n - fechadas > 2) {
+    cartas[f++] = fechadas;
+    cartas[f++] = fechadas + 1;
+    cartas[f++] = n - 1;
+  } else {
+    for (int i = fechadas; i < n; i++) cartas[f++] = i;
+  }
+  return f;
+}
+
+// quantas fileiras a pilha ocupa no desenho (a vazia ocupa uma, com o lugar da carta) e, em
+// carta, a carta que aparece na fileira (abaixo da última, a do topo; -1 se a pilha está vazia)
+static int fileiras_da_pilha(jogo_t *j, int pilha, int fileira, int *carta)
+{
+  pilha_t *p = pilha_do_jogo(j, pilha);
+  int n = numero_cartas_pilha(p);
+  *carta = n - 1;
+  if (n == 0 || pilha < PILHA_PRINCIPAL) return 1;
+  if (!pilha_compacta(j, pilha - PILHA_PRINCIPAL)) {
+    if (fileira < n) *carta = fileira;
+    return n;
+  }
+  int cartas[6];
+  int n_fileiras = fileiras_compactas(p, cartas);
+  *carta = cartas[fileira < n_fileiras ? fileira : n_fileiras - 1];
+  return n_fileiras;
+}
+
+// a fileira onde aparece uma carta da pilha (fora das pilhas principais só o topo aparece, na primeira)
+static int fileira_da_carta(jogo_t *j, int pilha, int carta)
+{
+  if (pilha < PILHA_PRINCIPAL) return 0;
+  if (!pilha_compacta(j, pilha - PILHA_PRINCIPAL)) return carta;
+  int cartas[6];
+  int n_fileiras = fileiras_compactas(pilha_do_jogo(j, pilha), cartas);
+  int f = 0;
+  while (f + 1 < n_fileiras && cartas[f + 1] <= carta) f++;
+  return f;
+}
+
+// preenche o mapa de toque com as pilhas que ocupam o centro de cada célula
+void monta_mapa_toque(disposicao_t *d)
+{
+  mapa_toque_t *m = &d->toque;
+  m->colunas = (d->largura_area + LADO_TOQUE - 1) / LADO_TOQUE;
+  m->linhas = (d->altura + LADO_TOQUE - 1) / LADO_TOQUE;
+  free(m->celulas);
+  m->celulas = malloc(m->colunas * m->linhas * sizeof(toque_t));
+  if (m->celulas == NULL) {
+    fprintf(stderr, "Sem memória para o mapa de toque\n");
+    exit(1);
+  }
+  for (int lin = 0; lin < m->linhas; lin++) {
+    for (int col = 0; col < m->colunas; col++) {
+      toque_t *t = &m->celulas[lin * m->colunas + col];
+      int x = col * LADO_TOQUE + LADO_TOQUE / 2;
+      int y = lin * LADO_TOQUE + LADO_TOQUE / 2;
+      t->pilha = -1;
+      t->fileira = 0;
+      for (int i = 0; i < N_PILHAS; i++) {
+        coordenadas_t c = d->pilhas[i];
+        // as pilhas principais podem crescer até o fim da janela
+        int fim = i < PILHA_PRINCIPAL ? c.lin + d->carta_altura : d->altura;
+        if (x >= c.col && x < c.col + d->carta_largura && y >= c.lin && y < fim) {
+          t->pilha = i;
+          // em uma janela alta e estreita as fileiras passam do que cabe em um byte;
+          // as que passam da última carta valem todas pelo topo
+          int fileira = (y - c.lin) / d->deslocamento_carta;
+          t->fileira = fileira > UINT8_MAX ? UINT8_MAX : fileira;
+          break;
+        }
+      }
     }
   }
-  c[0] = '\0';
-  
+}
+
+// consulta o mapa de toque e confere se o ponto não está abaixo da última carta da pilha
+int toca_carta(jogo_t *j, int x, int y, int *carta)
+{
+  disposicao_t *d = disposicao;
+  mapa_toque_t *m = &d->toque;
+  if (x < 0 || y < 0 || x >= d->largura_area || y >= d->altura) return -1;
+  toque_t t = m->celulas[y / LADO_TOQUE * m->colunas + x / LADO_TOQUE];
+  if (t.pilha < 0) return -1;
+  int n_fileiras = fileiras_da_pilha(j, t.pilha, t.fileira, carta);
+  if (y - d->pilhas[t.pilha].lin >= (n_fileiras - 1) * d->deslocamento_carta + d->carta_altura)
+    return -1;
+  return t.pilha;
+}
+
+// quantos pixels o mouse anda apertado antes de um clique virar um arrasto
+#define LIMIAR_ARRASTO 4
+
+// se a carta da pilha está aberta e pode ser levada pelo mouse
+static bool carta_aberta(jogo_t *j, int pilha, int carta)
+{
+  if (pilha < 0 || pilha == PILHA_MONTE) return false;
+  pilha_t *p = pilha_do_jogo(j, pilha);
+  return carta >= numero_cartas_fechadas_pilha(p) && carta < numero_cartas_pilha(p);
+}
+
+// monta a jogada que leva a carta da origem, com as que estão sobre ela, para o destino
+static bool monta_jogada_do_rato(jogo_t *j, int origem, int carta, int destino, jogada_t *jg)
+{
+  if (!carta_aberta(j, origem, carta) || destino == origem || destino < PILHA_SAIDA) return false;
+  int n = numero_cartas_pilha(pilha_do_jogo(j, origem)) - carta;
+  // só as pilhas principais recebem mais de uma carta
+  if (n > 1 && destino < PILHA_PRINCIPAL) return false;
+  jg->origem = origem;
+  jg->destino = destino;
+  jg->n_cartas = n;
+  return true;
+}
+
+// compara o botão com o do quadro anterior: apertar começa um toque, andar apertado
+// arrasta e soltar termina o arrasto ou conta como clique
+bool trata_rato(jogo_t *j, rato_t *r, int x, int y, bool apertado, jogada_t *jg)
+{
+  disposicao_t *d = disposicao;
+  bool pediu = false;
+  r->x = x;
+  r->y = y;
+  // a seleção some se a carta deixou de estar lá (por uma jogada pelo teclado, por exemplo)
+  if (r->selecionada >= 0 && !carta_aberta(j, r->selecionada, r->carta_selecionada))
+    r->selecionada = -1;
+
+  if (apertado && !r->apertado) {
+    r->x0 = x;
+    r->y0 = y;
+    r->origem = toca_carta(j, x, y, &r->carta);
+    r->arrastando = false;
+  } else if (apertado && !r->arrastando) {
+    if (carta_aberta(j, r->origem, r->carta) && abs(x - r->x0) + abs(y - r->y0) > LIMIAR_ARRASTO) {
+      coordenadas_t c = d->pilhas[r->origem];
+      r->arrastando = true;
+      r->selecionada = -1;
+      r->dx = r->x0 - c.col;
+      r->dy = r->y0 - (c.lin + fileira_da_carta(j, r->origem, r->carta) * d->deslocamento_carta);
+    }
+  } else if (!apertado && r->apertado) {
+    int carta;
+    int destino = toca_carta(j, x, y, &carta);
+    if (r->arrastando) {
+      pediu = destino >= 0 && monta_jogada_do_rato(j, r->origem, r->carta, destino, jg);
+    } else if (r->selecionada >= 0) {
+      pediu = destino >= 0 && monta_jogada_do_rato(j, r->selecionada, r->carta_selecionada, destino, jg);
+      r->selecionada = -1;
+    } else if (r->origem == PILHA_MONTE && destino == PILHA_MONTE) {
+      // o monte abre uma carta, ou recebe o descarte de volta se estiver vazio
+      jg->origem = numero_cartas_pilha(&j->monte) > 0 ? PILHA_MONTE : PILHA_DESCARTE;
+      jg->destino = numero_cartas_pilha(&j->monte) > 0 ? PILHA_DESCARTE : PILHA_MONTE;
+      jg->n_cartas = 1;
+      pediu = true;
+    } else if (destino == r->origem && carta_aberta(j, r->origem, r->carta)) {
+      r->selecionada = r->origem;
+      r->carta_selecionada = r->carta;
+    }
+    r->arrastando = false;
+  }
+  r->apertado = apertado;
+  return pediu;
+}
+
+// escurece as cartas sendo arrastadas ou contorna as selecionadas
+void desenho_da_selecao(jogo_t *j, rato_t *r, float col, float lin)
+{
+  disposicao_t *d = disposicao;
+  int sombra = 13;
+  tela_altera_cor(sombra, 0, 0, 0, 0.5);
+  int pilha = r->arrastando ? r->origem : r->selecionada;
+  int carta = r->arrastando ? r->carta : r->carta_selecionada;
+  if (!carta_aberta(j, pilha, carta)) return;
+
+  coordenadas_t c = d->pilhas[pilha];
+  int topo;
+  int n_fileiras = fileiras_da_pilha(j, pilha, 0, &topo);
+  float x1 = col + c.col;
+  float x2 = col + c.col + d->carta_largura;
+  float y1 = lin + c.lin + fileira_da_carta(j, pilha, carta) * d->deslocamento_carta;
+  float y2 = lin + c.lin + (n_fileiras - 1) * d->deslocamento_carta + d->carta_altura;
+  if (r->arrastando)
+    tela_retangulo(x1, y1, x2, y2, 0, transparente, sombra);
+  else
+    tela_retangulo(x1, y1, x2, y2, 3, amarelo, transparente);
+}
+
+// desenha as cartas arrastadas por cima do tabuleiro, presas ao mouse onde foram pegas
+void desenho_do_arrasto(jogo_t *j, rato_t *r)
+{
+  disposicao_t *d = disposicao;
+  if (!r->arrastando || !carta_aberta(j, r->origem, r->carta)) return;
+  pilha_t *p = pilha_do_jogo(j, r->origem);
+  int col = r->x - r->dx;
+  int lin = r->y - r->dy;
+  for (int i = r->carta; i < numero_cartas_pilha(p); i++) {
+    desenho_de_carta_aberta(lin, col, retorna_carta(p, i, NULL));
+    lin += d->deslocamento_carta;
+  }
+}
+
+// passo fixo da simulação das animações, em segundos
+#define PASSO_ANIMACAO (1.0 / 120)
+// fração do caminho que falta que as cartas andam a cada passo (chegam desacelerando)
+#define APROXIMACAO_ANIMACAO 0.2
+// um quadro atrasado mais que isto não é simulado por inteiro, as cartas só continuam
+#define ATRASO_MAXIMO_ANIMACAO 0.1
+
+// onde fica a carta da pilha, na disposição em uso
+static void posicao_da_carta(jogo_t *j, int pilha, int carta, float *col, float *lin)
+{
+  disposicao_t *d = disposicao;
+  *col = d->pilhas[pilha].col;
+  *lin = d->pilhas[pilha].lin + fileira_da_carta(j, pilha, carta) * d->deslocamento_carta;
+}
+
+void inicia_animacao(animacao_t *a, jogo_t *j)
+{
+  a->ativa = false;
+  a->origem_largada = -1;
+  a->chave = chave_jogo(j);
+  for (int i = 0; i < N_PILHAS; i++)
+    a->n_cartas[i] = numero_cartas_pilha(pilha_do_jogo(j, i));
+}
+
+// começa a animar as n cartas que foram da origem ao destino em j
+static void comeca_animacao(animacao_t *a, jogo_t *j, int origem, int destino, int n, double agora)
+{
+  a->jogo = *j;
+  pilha_t *p = pilha_do_jogo(&a->jogo, destino);
+  posicao_da_carta(&a->jogo, destino, p->n_cartas - n, &a->col_alvo, &a->lin_alvo);
+  // as cartas continuam no vetor da pilha, só deixam de ser desenhadas nela
+  p->n_cartas -= n;
+  if (a->origem_largada == origem && a->destino_largada == destino) {
+    a->col = a->col_largada;
+    a->lin = a->lin_largada;
+  } else {
+    // logo abaixo do que sobrou na origem, onde estava a primeira carta levada
+    posicao_da_carta(j, origem, numero_cartas_pilha(pilha_do_jogo(j, origem)), &a->col, &a->lin);
+  }
+  a->col_anterior = a->col;
+  a->lin_anterior = a->lin;
+  a->destino = destino;
+  a->n_cartas_movidas = n;
+  a->acumulado = 0;
+  a->instante = agora;
+  a->ativa = true;
+}
+
+jogo_t *acompanha_jogo(animacao_t *a, jogo_t *j, double agora)
+{
+  uint64_t chave = chave_jogo(j);
+  if (chave != a->chave) {
+    // uma jogada é uma só pilha perdendo cartas e outra ganhando as mesmas; vários
+    // passos de uma vez (na reprodução, por exemplo) não são animados
+    int origem = -1, destino = -1, perdidas = 0, ganhas = 0, mudadas = 0;
+    for (int i = 0; i < N_PILHAS; i++) {
+      int n_cartas = numero_cartas_pilha(pilha_do_jogo(j, i));
+      int diferenca = n_cartas - a->n_cartas[i];
+      if (diferenca < 0) {
+        origem = i;
+        perdidas = -diferenca;
+        mudadas++;
+      } else if (diferenca > 0) {
+        destino = i;
+        ganhas = diferenca;
+        mudadas++;
+      }
+      a->n_cartas[i] = n_cartas;
+    }
+    a->chave = chave;
+    a->ativa = false;
+    // o descarte voltando para o monte não é animado: as cartas viram de uma vez
+    if (mudadas == 2 && origem >= 0 && destino >= 0 && perdidas == ganhas && destino != PILHA_MONTE)
+      comeca_animacao(a, j, origem, destino, ganhas, agora);
+    a->origem_largada = -1;
+  }
+  if (!a->ativa) return j;
+
+  // o que não é pilha vem sempre do jogo, que continua mudando durante a animação
+  strcpy(a->jogo.comando, j->comando);
+  strcpy(a->jogo.analise, j->analise);
+  a->jogo.pontos = j->pontos;
+
+  a->acumulado += fmin(agora - a->instante, ATRASO_MAXIMO_ANIMACAO);
+  a->instante = agora;
+  while (a->acumulado >= PASSO_ANIMACAO) {
+    a->acumulado -= PASSO_ANIMACAO;
+    a->col_anterior = a->col;
+    a->lin_anterior = a->lin;
+    a->col += (a->col_alvo - a->col) * APROXIMACAO_ANIMACAO;
+    a->lin += (a->lin_alvo - a->lin) * APROXIMACAO_ANIMACAO;
+    // a menos de um pixel as cartas chegaram
+    if (fabsf(a->col_alvo - a->col) + fabsf(a->lin_alvo - a->lin) < 1) {
+      a->ativa = false;
+      return j;
+    }
+  }
+  return &a->jogo;
+}
+
+void desenho_da_animacao(animacao_t *a)
+{
+  if (!a->ativa) return;
+  disposicao_t *d = disposicao;
+  // a parte do próximo passo que já passou, para o movimento não andar aos saltos de um passo
+  float t = a->acumulado / PASSO_ANIMACAO;
+  float col = a->col_anterior + (a->col - a->col_anterior) * t;
+  float lin = a->lin_anterior + (a->lin - a->lin_anterior) * t;
+  pilha_t *p = pilha_do_jogo(&a->jogo, a->destino);
+  for (int i = 0; i < a->n_cartas_movidas; i++) {
+    desenho_de_carta_aberta(lin, col, p->cartas[p->n_cartas + i]);
+    lin += d->deslocamento_carta;
+  }
+}
+
+// desenho de fundo do jogo (a identificação das pilhas, desenhada na camada quando a disposição muda)
+void desenho_do_fundo(jogo_t *j)
+{
+  disposicao_t *d = disposicao;
+  tela_mostra_camada(d->camada_fundo, 0, 0, d->largura_area, d->altura);
+}
+
+// disposição da janela inteira e a dos tabuleiros de jogo_em_mesas(), do tamanho de uma célula
+static disposicao_t disposicao_janela;
+static disposicao_t disposicao_mesa;
+
+// passa a usar a disposição da janela, refeita antes se a janela mudou de tamanho
+// desde o último quadro; retorna se mudou
+static bool atualiza_disposicao(void)
+{
+  int largura, altura;
+  bool mudou = tela_redimensionada(&largura, &altura);
+  if (mudou)
+    calcula_disposicao(&disposicao_janela, largura, altura);
+  usa_disposicao(&disposicao_janela);
+  return mudou;
 }
 
 // desenha a tela, funcao que chama os desenhos mais específicos de cada parte
 void desenho_da_tela(jogo_t *j)
+{
+  atualiza_disposicao();
+  desenho_do_tabuleiro(j);
+  desenho_do_rato();
+  tela_atualiza();
+}
+
+// desenha o tabuleiro de um jogo (tudo menos o mouse), na tela ou em uma camada
+void desenho_do_tabuleiro(jogo_t *j)
 {
   desenho_do_fundo(j);
   desenho_das_pilhas(j);
   desenhos_de_extras(j);
-  tela_atualiza();
 }
 
 // tela de apresentacao do jogo
 void apresentacao() 
 {
-  int fucsia = 11;
-  int num_linhas = 1;
-  int tam_letra = LARGURA / 40;
-  int posY = ALTURA/6;
-  tela_altera_cor(fucsia, 1, 0.2, 0.8, 1);
-  // desenha um quadrado no contorno da janela
-  tela_retangulo(LARGURA/10, ALTURA/10, LARGURA - LARGURA/10, ALTURA - ALTURA /10, 5, fucsia, transparente);
-  
-  char texto [100];
-  sprintf(texto,"BEM VINDO AO KLONDIKE!!!");
-  tela_texto(LARGURA/2,posY,tam_letra,amarelo,texto);
-  tam_letra = LARGURA / 50;
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"- Cada pilha é representada por uma letra ou número:");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,branco,texto);
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"   > M: Monte de cartas;");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"   > P: Pilha de descarte;");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"   > A-D: Pilhas de saída;");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"   > 1-7: Pilhas de jogo;");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas+=2;
-  sprintf(texto,"- Para fazer uma jogada digite a pilha de origem e destino (ex.: '5b');");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,branco,texto);
-  texto[0] = '\0';
-  num_linhas+=2;
-  sprintf(texto," - Jogadas (uma jogada possui 1 ou 2 caracteres):");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,branco,texto);
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"       > 'm' = 'mp';");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"       > 'p' = 'pm';");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"       > '(1-7)(1-7)';");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"       > '(1-7)(a-d)';");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"       > '(a-d)(1-7)'");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas+=2;
-  sprintf(texto,"Obs.: O mouse não movimenta cartas. Para sair digite 'F' como jogada.");
-  tela_texto_dir(LARGURA/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,branco,texto);
-  texto[0] = '\0';
-  num_linhas+=2;
-  tam_letra = LARGURA / 40;
-  sprintf(texto,"Tecle <enter> para iniciar!!!");
-  tela_texto(LARGURA/2,ALTURA - ALTURA/10 -tam_letra,tam_letra,amarelo,texto);
-  tela_atualiza();
-  char c;
+  // redesenhada a cada quadro, para acompanhar a janela se ela mudar de tamanho
   while (true) {
-    c = tela_tecla();
-    if (c == '\n')
+    atualiza_disposicao();
+    disposicao_t *d = disposicao;
+    int fucsia = 11;
+    int num_linhas = 1;
+    int tam_letra = d->letra_titulo;
+    int posY = d->altura/6;
+    tela_altera_cor(fucsia, 1, 0.2, 0.8, 1);
+    // desenha um quadrado no contorno da janela
+    tela_retangulo(d->esquerda + d->largura/10, d->altura/10, d->esquerda + d->largura - d->largura/10, d->altura - d->altura /10, 5, fucsia, transparente);
+    
+    char texto [100];
+    sprintf(texto,"BEM VINDO AO KLONDIKE!!!");
+    tela_texto(d->esquerda + d->largura/2,posY,tam_letra,amarelo,texto);
+    tam_letra = d->letra_texto;
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"- Cada pilha é representada por uma letra ou número:");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,branco,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"   > M: Monte de cartas;");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"   > P: Pilha de descarte;");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"   > A-D: Pilhas de saída;");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"   > 1-7: Pilhas de jogo;");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas+=2;
+    sprintf(texto,"- Para fazer uma jogada digite a pilha de origem e destino (ex.: '5b');");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,branco,texto);
+    texto[0] = '\0';
+    num_linhas+=2;
+    sprintf(texto," - Jogadas (uma jogada possui 1 ou 2 caracteres):");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,branco,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"       > 'm' = 'mp';");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"       > 'p' = 'pm';");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"       > '(1-7)(1-7)';");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"       > '(1-7)(a-d)';");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"       > '(a-d)(1-7)'");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas+=2;
+    sprintf(texto,"Obs.: Também dá para clicar ou arrastar as cartas. Para sair digite 'F' como jogada.");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,branco,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"Digite '?' para analisar as jogadas ou 'd' para pedir uma dica.");
+    tela_texto_dir(d->esquerda + d->largura/10+tam_letra,posY + num_linhas*tam_letra+tam_letra,tam_letra,branco,texto);
+    texto[0] = '\0';
+    num_linhas+=2;
+    tam_letra = d->letra_titulo;
+    sprintf(texto,"Tecle <enter> para iniciar!!!");
+    tela_texto(d->esquerda + d->largura/2,d->altura - d->altura/10 -tam_letra,tam_letra,amarelo,texto);
+    tela_atualiza();
+    if (tela_tecla() == '\n')
       break;
   }
 }
 
+// quanto a thread da lógica espera por uma tecla antes de conferir de novo se o jogo acabou
+#define SEGUNDOS_ESPERA_TECLA 0.1
+
+// banco de distribuições vencíveis, aberto em main() se for passado como argumento
+static banco_t banco;
+static gerador_t gerador_banco;
+
+// telemetria das partidas, iniciada em main() se for pedida
+static telemetria_t telemetria;
+static bool com_telemetria = false;
+static int n_partidas = 0;
+
+// o que é preciso guardar antes de uma jogada para descrevê-la depois
+typedef struct {
+  int n_cartas[N_PILHAS];
+  double pontos;
+  double bonus_total;
+  uint64_t chave;
+} antes_da_jogada_t;
+
+// registra o início ou o fim de uma partida nas métricas e na telemetria
+static void registra_partida(jogo_t *j, int partida, tipo_evento_t tipo)
+{
+  if (tipo == evento_inicio) {
+    conta_metrica(&metricas.partidas_iniciadas);
+    j->instante_ultima_jogada = relogio_do_jogo(j);
+  } else {
+    conta_metrica(venceu_jogo(j) ? &metricas.partidas_vencidas : &metricas.partidas_abandonadas);
+    observa_histograma(&metricas.pontuacao, j->pontos);
+  }
+  if (!com_telemetria) return;
+  evento_t e = { .instante = relogio_do_jogo(j), .pontos = j->pontos, .partida = partida, .tipo = tipo,
+                 .origem = tipo == evento_fim && venceu_jogo(j) };
+  registra_evento(&telemetria, &e);
+}
+
+// guarda o que é preciso para descrever depois a jogada que vai ser feita
+static void antes_da_jogada(jogo_t *j, antes_da_jogada_t *a)
+{
+  for (int i = 0; i < N_PILHAS; i++)
+    a->n_cartas[i] = numero_cartas_pilha(pilha_do_jogo(j, i));
+  a->pontos = j->pontos;
+  a->bonus_total = j->bonus_total;
+  a->chave = chave_jogo(j);
+}
+
+// se o jogo mudou desde antes_da_jogada(), registra a jogada nas métricas e na telemetria
+static void registra_jogada(jogo_t *j, antes_da_jogada_t *a, int partida)
+{
+  if (chave_jogo(j) == a->chave) return;
+  conta_metrica(&metricas.jogadas);
+  // o tempo pensando conta desde a jogada anterior, qualquer que seja
+  double anterior = j->instante_ultima_jogada;
+  j->instante_ultima_jogada = relogio_do_jogo(j);
+  if (!com_telemetria) return;
+
+  // a origem perdeu cartas e o destino ganhou (abrir uma carta não muda as contagens)
+  evento_t e = { .instante = relogio_do_jogo(j), .pontos = j->pontos, .delta_pontos = j->pontos - a->pontos,
+                 .bonus = j->bonus_total - a->bonus_total, .partida = partida, .tipo = evento_jogada,
+                 .origem = -1, .destino = -1 };
+  e.tempo_pensando = e.instante - anterior;
+  for (int i = 0; i < N_PILHAS; i++) {
+    int diferenca = numero_cartas_pilha(pilha_do_jogo(j, i)) - a->n_cartas[i];
+    if (diferenca < 0 && e.origem < 0) {
+      e.origem = i;
+      e.n_cartas = -diferenca;
+    } else if (diferenca > 0 && e.destino < 0) {
+      e.destino = i;
+    }
+  }
+  registra_evento(&telemetria, &e);
+}
+
+// trata uma tecla e, se ela realizou uma jogada, registra a jogada nas métricas e na telemetria
+static void trata_tecla_registrando(jogo_t *j, char tecla, int partida)
+{
+  if (tecla != '\n') {
+    trata_tecla(j, tecla);
+    return;
+  }
+
+  antes_da_jogada_t a;
+  antes_da_jogada(j, &a);
+  trata_tecla(j, tecla);
+  registra_jogada(j, &a, partida);
+}
+
+// realiza uma jogada pedida com o mouse, se ela for uma das possíveis, registrando-a como as do teclado
+static void jogada_do_rato_registrando(jogo_t *j, jogada_t jg, int partida)
+{
+  jogada_t jogadas[N_MAX_JOGADAS];
+  int n = gera_jogadas(j, jogadas);
+  // como no teclado, quantas cartas vão de uma pilha principal para outra é decidido
+  // pelas regras, o que vale também para as cartas escondidas no desenho compacto
+  for (int i = 0; i < n; i++) {
+    if (jogadas[i].origem != jg.origem || jogadas[i].destino != jg.destino) continue;
+    antes_da_jogada_t a;
+    antes_da_jogada(j, &a);
+    j->analise[0] = '\0';
+    aplica_jogada(j, jogadas[i]);
+    registra_jogada(j, &a, partida);
+    return;
+  }
+}
+
+// distribui as cartas de um jogo, do banco se ele foi aberto; retorna o número da partida
+static int distribui(jogo_t *j)
+{
+  j->relogio = tela_relogio;
+  if (banco.n_registros > 0) {
+    const registro_banco_t *r = inicia_pilhas_jogo_do_banco(j, &banco, &gerador_banco);
+    sprintf(j->analise, "Distribuição %llu: vitória garantida", (unsigned long long)r->semente);
+  } else {
+    inicia_pilhas_jogo(j);
+  }
+  registra_partida(j, n_partidas, evento_inicio);
+  return n_partidas++;
+}
+
+// uma jogada em um inteiro, para passar de uma thread a outra (0 é nenhuma jogada)
+static uint32_t empacota_jogada(jogada_t jg)
+{
+  return (uint32_t)(jg.origem + 1) | (uint32_t)jg.destino << 8 | (uint32_t)jg.n_cartas << 16;
+}
+
+static jogada_t desempacota_jogada(uint32_t v)
+{
+  jogada_t jg = { (int)(v & 0xff) - 1, (v >> 8) & 0xff, (v >> 16) & 0xff };
+  return jg;
+}
+
+// o jogo da thread da lógica e onde ela publica as cópias para o desenho
+typedef struct {
+  jogo_t *jogo;
+  int partida;
+  publicacao_t *publicacao;
+  // jogada pedida com o mouse pela thread do desenho, empacotada (0 se nenhuma)
+  _Atomic uint32_t jogada_do_rato;
+  // se chegou uma tecla desde o último quadro, para o desenho pular a animação
+  _Atomic bool teclou;
+} logica_t;
+
+// laço da thread da lógica: trata as teclas e as jogadas do mouse e publica o jogo a cada mudança
+static void *logica_do_jogo(void *arg)
+{
+  logica_t *l = arg;
+  jogo_t *j = l->jogo;
+  while (!venceu_jogo(j) && j->sair == false) {
+    char tecla = tela_espera_tecla(SEGUNDOS_ESPERA_TECLA);
+    uint32_t jogada = atomic_exchange(&l->jogada_do_rato, 0);
+    if (tecla == '\0' && jogada == 0) continue;
+    // antes de publicar, para a animação da jogada desta tecla não ser pulada
+    if (tecla != '\0')
+      atomic_store(&l->teclou, true);
+    if (jogada != 0)
+      jogada_do_rato_registrando(j, desempacota_jogada(jogada), l->partida);
+    if (tecla != '\0')
+      trata_tecla_registrando(j, tecla, l->partida);
+    publica_jogo(l->publicacao, j);
+  }
+  registra_partida(j, l->partida, evento_fim);
+  return NULL;
+}
+
 // funcao que "gera" o jogo
 double jogo() 
 {
 
   jogo_t *j = malloc(sizeof(jogo_t));
-  inicia_pilhas_jogo(j);
+  publicacao_t *publicacao = malloc(sizeof(publicacao_t));
+  assert(j != NULL && publicacao != NULL);
+  int partida = distribui(j);
   
   apresentacao();
+
+  // a lógica roda em outra thread; esta só desenha a última cópia publicada e
+  // transforma o mouse em jogadas, que a lógica realiza
+  inicia_publicacao(publicacao, j);
+  logica_t logica = { j, partida, publicacao, 0, false };
+  pthread_t thread_logica;
+  pthread_create(&thread_logica, NULL, logica_do_jogo, &logica);
+  jogo_t *copia;
+  rato_t rato = { .origem = -1, .selecionada = -1 };
+  // as jogadas são animadas só aqui, no desenho: a lógica já as realizou
+  animacao_t *animacao = malloc(sizeof(animacao_t));
+  assert(animacao != NULL);
+  inicia_animacao(animacao, j);
+  copia = ultimo_jogo_publicado(publicacao);
   do {
-    desenho_da_tela(j);
-    processa_teclado(j);
-  } while(!venceu_jogo(j) && j->sair == false);
+    // a jogada do mouse ainda não foi pega pela lógica (lido antes da cópia, que então
+    // já pode trazê-la)
+    bool pendente = atomic_load(&logica.jogada_do_rato) != 0;
+    jogo_t *anterior = copia;
+    copia = ultimo_jogo_publicado(publicacao);
+    // as posições da animação são da disposição antiga
+    if (atualiza_disposicao())
+      animacao->ativa = false;
+    int rx, ry;
+    jogada_t jg;
+    tela_rato_pos(&rx, &ry);
+    bool apertado = tela_rato_apertado();
+    // uma tecla ou um aperto do botão pula a animação em andamento
+    if (atomic_exchange(&logica.teclou, false) || (apertado && !rato.apertado))
+      animacao->ativa = false;
+    jogo_t *desenhado = acompanha_jogo(animacao, copia, tela_relogio());
+    // a lógica já tratou a jogada largada e a cópia nova não a trouxe: foi recusada
+    if (copia != anterior && !pendente)
+      animacao->origem_largada = -1;
+    bool arrastava = rato.arrastando;
+    if (trata_rato(copia, &rato, rx, ry, apertado, &jg)) {
+      atomic_store(&logica.jogada_do_rato, empacota_jogada(jg));
+      tela_acorda();
+      // cartas largadas voam de onde estão, e não da pilha de onde saíram
+      animacao->origem_largada = arrastava ? jg.origem : -1;
+      animacao->destino_largada = jg.destino;
+      animacao->col_largada = rato.x - rato.dx;
+      animacao->lin_largada = rato.y - rato.dy;
+    }
+    desenho_do_tabuleiro(desenhado);
+    desenho_da_selecao(copia, &rato, 0, 0);
+    desenho_do_arrasto(copia, &rato);
+    desenho_da_animacao(animacao);
+    desenho_do_rato();
+    tela_atualiza();
+    // a última jogada ainda é animada antes de o jogo terminar
+  } while((!venceu_jogo(copia) && copia->sair == false) || animacao->ativa);
+  pthread_join(thread_logica, NULL);
+  free(animacao);
+  free(publicacao);
   
   double pontos;
   
@@ -1096,34 +1160,184 @@ double jogo()
   return pontos;
 }
 
+// resume o que aparece no tabuleiro de um jogo, para só redesenhar a camada quando muda
+static uint64_t assinatura_do_tabuleiro(jogo_t *j)
+{
+  uint64_t a = 0;
+  for (int i = 0; i < N_PILHAS; i++) {
+    pilha_t *p = pilha_do_jogo(j, i);
+    a = espalha_64(a ^ p->chave ^ ((uint64_t)p->n_cartas_fechadas << 56));
+  }
+  for (char *c = j->comando; *c != '\0'; c++)
+    a = espalha_64(a ^ (uint8_t)*c);
+  for (char *c = j->analise; *c != '\0'; c++)
+    a = espalha_64(a ^ (uint8_t)*c);
+  uint64_t pontos;
+  memcpy(&pontos, &j->pontos, sizeof(pontos));
+  return espalha_64(a ^ pontos);
+}
+
+// camadas dos tabuleiros, criadas na primeira vez que são usadas e reaproveitadas nas próximas rodadas
+static int camadas_mesas[MAX_MESAS];
+static int n_camadas_mesas = 0;
+
+// divide a janela em células, uma por tabuleiro, e refaz a disposição e as camadas
+// dos tabuleiros no tamanho da célula
+static void dispoe_mesas(mesa_t mesas[], int n_mesas, int colunas, int linhas)
+{
+  int largura = disposicao_janela.largura_area / colunas;
+  int altura = disposicao_janela.altura / linhas;
+  calcula_disposicao(&disposicao_mesa, largura, altura);
+  largura = disposicao_mesa.largura_area;
+  altura = disposicao_mesa.altura;
+  for (int i = 0; i < n_mesas; i++) {
+    mesa_t *m = &mesas[i];
+    tela_redimensiona_camada(m->camada, largura, altura);
+    m->col = largura * (i % colunas);
+    m->lin = altura * (i / colunas);
+    // nenhuma assinatura coincide com esta, então a camada é redesenhada no próximo quadro
+    m->assinatura = assinatura_do_tabuleiro(m->jogo) + 1;
+  }
+}
+
+// vários jogos ao mesmo tempo na mesma janela; tab passa o teclado para o próximo
+double jogo_em_mesas(int n_mesas)
+{
+  mesa_t mesas[MAX_MESAS];
+  int colunas = 1;
+  while (colunas * colunas < n_mesas) colunas++;
+  int linhas = (n_mesas + colunas - 1) / colunas;
+  int cinza = 12;
+  tela_altera_cor(cinza, 0, 0, 0, 0.6);
+
+  for (int i = 0; i < n_mesas; i++) {
+    if (i == n_camadas_mesas)
+      camadas_mesas[n_camadas_mesas++] = tela_cria_camada(LARGURA, ALTURA);
+    mesa_t *m = &mesas[i];
+    m->jogo = malloc(sizeof(jogo_t));
+    assert(m->jogo != NULL);
+    m->partida = distribui(m->jogo);
+    m->camada = camadas_mesas[i];
+    m->terminada = false;
+  }
+
+  apresentacao();
+  dispoe_mesas(mesas, n_mesas, colunas, linhas);
+  int foco = 0, em_jogo = n_mesas;
+  rato_t rato = { .origem = -1, .selecionada = -1 };
+  while (em_jogo > 0) {
+    // os tabuleiros só são refeitos quando a janela muda de tamanho
+    if (atualiza_disposicao())
+      dispoe_mesas(mesas, n_mesas, colunas, linhas);
+    usa_disposicao(&disposicao_mesa);
+    float largura = disposicao_mesa.largura_area, altura = disposicao_mesa.altura;
+    char tecla = tela_tecla();
+    int rx, ry;
+    tela_rato_pos(&rx, &ry);
+    bool apertado = tela_rato_apertado();
+    // apertar o botão em outro tabuleiro passa o teclado e o mouse para ele
+    if (apertado && !rato.apertado) {
+      for (int i = 0; i < n_mesas; i++) {
+        mesa_t *m = &mesas[i];
+        if (i != foco && !m->terminada && rx >= m->col && rx < m->col + largura && ry >= m->lin && ry < m->lin + altura) {
+          foco = i;
+          rato.selecionada = -1;
+        }
+      }
+    }
+
+    mesa_t *mf = &mesas[foco];
+    jogo_t *j = mf->jogo;
+    jogada_t jg;
+    bool jogou = false;
+    if (tecla == '\t') {
+      do foco = (foco + 1) % n_mesas; while (mesas[foco].terminada);
+      rato.selecionada = -1;
+    } else if (tecla != '\0') {
+      trata_tecla_registrando(j, tecla, mf->partida);
+      jogou = true;
+    }
+    // o mouse é levado para as coordenadas da célula do tabuleiro
+    if (trata_rato(j, &rato, rx - mf->col, ry - mf->lin, apertado, &jg)) {
+      jogada_do_rato_registrando(j, jg, mf->partida);
+      jogou = true;
+    }
+    if (jogou && (venceu_jogo(j) || j->sair)) {
+      mf->terminada = true;
+      registra_partida(j, mf->partida, evento_fim);
+      if (venceu_jogo(j))
+        sprintf(j->analise, "Vitória com %.2f pontos", j->pontos);
+      else
+        sprintf(j->analise, "Partida abandonada");
+      if (--em_jogo > 0)
+        do foco = (foco + 1) % n_mesas; while (mesas[foco].terminada);
+    }
+
+    // só os tabuleiros que mudaram são redesenhados; os demais são copiados da camada
+    for (int i = 0; i < n_mesas; i++) {
+      mesa_t *m = &mesas[i];
+      uint64_t a = assinatura_do_tabuleiro(m->jogo);
+      if (a != m->assinatura) {
+        tela_desenha_em_camada(m->camada);
+        tela_limpa();
+        desenho_do_tabuleiro(m->jogo);
+        m->assinatura = a;
+      }
+    }
+    tela_desenha_em_camada(-1);
+    for (int i = 0; i < n_mesas; i++) {
+      mesa_t *m = &mesas[i];
+      tela_mostra_camada(m->camada, m->col, m->lin, largura, altura);
+      if (m->terminada)
+        tela_retangulo(m->col, m->lin, m->col + largura, m->lin + altura, 0, transparente, cinza);
+      if (i == foco && !m->terminada) {
+        tela_retangulo(m->col, m->lin, m->col + largura, m->lin + altura, 3, amarelo, transparente);
+        desenho_da_selecao(m->jogo, &rato, m->col, m->lin);
+      }
+    }
+    desenho_do_rato();
+    tela_atualiza();
+  }
+
+  // a pontuação da rodada é a soma das partidas vencidas
+  double pontos = 0;
+  for (int i = 0; i < n_mesas; i++) {
+    if (!mesas[i].jogo->sair)
+      pontos += mesas[i].jogo->pontos;
+    free(mesas[i].jogo);
+  }
+  return pontos;
+}
+
 // verifica se o usuário quer jogar novamente
 bool quer_jogar_de_novo(double pontos) 
 {
   if (pontos == 0)
     return false;
-  int fucsia = 11;
-  int num_linhas = 0;
-  int tam_letra = LARGURA / 40;
-  int posY = ALTURA/3;
-  tela_altera_cor(fucsia, 1, 0.2, 0.8, 1);
-  // desenha um quadrado no contorno da janela
-  tela_retangulo(LARGURA/10, ALTURA/10, LARGURA - LARGURA/10, ALTURA - ALTURA /10, 5, fucsia, transparente);
-  
-  char texto [100];
-  sprintf(texto,"PARABÉNS!! VOCÊ VENCEU!!!");
-  tela_texto(LARGURA/2,posY,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas++;
-  sprintf(texto,"PONTUAÇÃO: %.2f",pontos);
-  tela_texto(LARGURA/2,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
-  texto[0] = '\0';
-  num_linhas+=2;
-  sprintf(texto,"Digite 's' para jogar de novo ou 'n' para sair");
-  tela_texto(LARGURA/2,ALTURA - ALTURA/10*2 - tam_letra,tam_letra,branco,texto);
-  tela_atualiza();
-  char c;
   while (true) {
-    c = tela_tecla();
+    atualiza_disposicao();
+    disposicao_t *d = disposicao;
+    int fucsia = 11;
+    int num_linhas = 0;
+    int tam_letra = d->letra_titulo;
+    int posY = d->altura/3;
+    tela_altera_cor(fucsia, 1, 0.2, 0.8, 1);
+    // desenha um quadrado no contorno da janela
+    tela_retangulo(d->esquerda + d->largura/10, d->altura/10, d->esquerda + d->largura - d->largura/10, d->altura - d->altura /10, 5, fucsia, transparente);
+    
+    char texto [100];
+    sprintf(texto,"PARABÉNS!! VOCÊ VENCEU!!!");
+    tela_texto(d->esquerda + d->largura/2,posY,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas++;
+    sprintf(texto,"PONTUAÇÃO: %.2f",pontos);
+    tela_texto(d->esquerda + d->largura/2,posY + num_linhas*tam_letra+tam_letra,tam_letra,amarelo,texto);
+    texto[0] = '\0';
+    num_linhas+=2;
+    sprintf(texto,"Digite 's' para jogar de novo ou 'n' para sair");
+    tela_texto(d->esquerda + d->largura/2,d->altura - d->altura/10*2 - tam_letra,tam_letra,branco,texto);
+    tela_atualiza();
+    char c = tela_tecla();
     if (c == 's' || c == 'S') {
       return true;
     } else if (c == 'n' || c == 'N') {
@@ -1132,16 +1346,142 @@ bool quer_jogar_de_novo(double pontos)
   }
 }
 
-int main()
+// segundos entre duas jogadas na reprodução automática
+#define PASSO_REPRODUCAO 0.3
+// jogadas puladas por '<' e '>' na reprodução
+#define SALTO_REPRODUCAO 25
+
+// mostra uma partida gravada, que pode ser percorrida para trás e para a frente
+void reproduz_partida(const char *nome_acervo, uint64_t indice)
 {
+  acervo_t acervo;
+  id_distribuicao_t id;
+  static jogada_t jogadas[MAX_JOGADAS_ACERVO];
+  int n_jogadas;
+  if (!abre_acervo(&acervo, nome_acervo)) {
+    fprintf(stderr, "acervo inválido: %s\n", nome_acervo);
+    return;
+  }
+  bool lida = procura_partida(&acervo, indice) && le_partida(&acervo, &id, jogadas, &n_jogadas);
+  fecha_acervo(&acervo);
+  if (!lida) {
+    fprintf(stderr, "partida %llu não encontrada em %s\n", (unsigned long long)indice, nome_acervo);
+    return;
+  }
+
+  jogo_t *inicial = malloc(sizeof(jogo_t));
+  inicial->relogio = NULL;
+  reproducao_t r;
+  if (!inicia_pilhas_jogo_com_id(inicial, &id) || !inicia_reproducao(&r, inicial, jogadas, n_jogadas)) {
+    fprintf(stderr, "partida %llu inválida\n", (unsigned long long)indice);
+    free(inicial);
+    return;
+  }
+  free(inicial);
+
   tela_inicio(LARGURA,ALTURA,"klondike");
+  calcula_disposicao(&disposicao_janela, LARGURA, ALTURA);
+  animacao_t *animacao = malloc(sizeof(animacao_t));
+  assert(animacao != NULL);
+  inicia_animacao(animacao, r.jogo);
+  bool automatico = false;
+  double proxima = 0;
+  while (!r.jogo->sair) {
+    int alvo = r.posicao;
+    char tecla = tela_tecla();
+    switch (tecla) {
+      case ',': alvo--; automatico = false; break;
+      case '.': alvo++; automatico = false; break;
+      case '<': alvo -= SALTO_REPRODUCAO; automatico = false; break;
+      case '>': alvo += SALTO_REPRODUCAO; automatico = false; break;
+      case 'i': alvo = 0; automatico = false; break;
+      case 'f': alvo = r.n_jogadas; automatico = false; break;
+      case ' ': automatico = !automatico; proxima = tela_relogio(); break;
+      case 'q': r.jogo->sair = true; break;
+    }
+    if (automatico && tela_relogio() >= proxima) {
+      alvo++;
+      proxima += PASSO_REPRODUCAO;
+      if (alvo >= r.n_jogadas) automatico = false;
+    }
+    if (alvo != r.posicao)
+      vai_para_jogada(&r, alvo);
+
+    char ultima[MAX_CHAR_CMD+1] = "";
+    if (r.posicao > 0)
+      descricao_jogada(r.jogadas[r.posicao - 1], ultima);
+    snprintf(r.jogo->analise, TAM_ANALISE, "Reprodução: jogada %d de %d %s  (, . < > i f espaço q)",
+             r.posicao, r.n_jogadas, ultima);
+    if (atualiza_disposicao() || tecla != '\0')
+      animacao->ativa = false;
+    desenho_do_tabuleiro(acompanha_jogo(animacao, r.jogo, tela_relogio()));
+    desenho_da_animacao(animacao);
+    desenho_do_rato();
+    tela_atualiza();
+  }
+
+  free(animacao);
+  tela_fim();
+  termina_reproducao(&r);
+}
+
+int main(int argc, char *argv[])
+{
+  // ./klondike -r partidas.acervo [n] mostra a partida n gravada no acervo
+  if (argc > 2 && strcmp(argv[1], "-r") == 0) {
+    reproduz_partida(argv[2], argc > 3 ? strtoull(argv[3], NULL, 10) : 0);
+    return 0;
+  }
+
+  int n_mesas = 1;
+  double quadros_por_segundo = QUADROS_POR_SEGUNDO;
+  while (argc > 2 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-m") == 0) {
+      // ./klondike -m n joga n partidas (2 a MAX_MESAS) ao mesmo tempo, na mesma janela
+      n_mesas = atoi(argv[2]);
+      if (n_mesas < 1) n_mesas = 1;
+      if (n_mesas > MAX_MESAS) n_mesas = MAX_MESAS;
+    } else if (strcmp(argv[1], "-q") == 0) {
+      // ./klondike -q 144 desenha até 144 quadros por segundo (0 = a frequência do monitor)
+      quadros_por_segundo = atof(argv[2]);
+    } else if (strcmp(argv[1], "-e") == 0) {
+      // ./klondike -e metricas.prom (ou -e unix:/run/klondike.sock) exporta as métricas para um coletor local
+      if (!inicia_exportacao_metricas(argv[2], INTERVALO_METRICAS))
+        fprintf(stderr, "não foi possível exportar as métricas para %s\n", argv[2]);
+    } else if (strcmp(argv[1], "-t") == 0) {
+      // ./klondike -t prefixo grava a telemetria das partidas em prefixo_000000.bin, ...
+      com_telemetria = inicia_telemetria(&telemetria, argv[2]);
+      if (!com_telemetria)
+        fprintf(stderr, "não foi possível gravar a telemetria em %s\n", argv[2]);
+    } else {
+      break;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+
+  // ./klondike distribuicoes.bin joga só distribuições vencíveis, sorteadas do banco
+  if (argc > 1 && !abre_banco(&banco, argv[1]))
+    fprintf(stderr, "banco de distribuições inválido: %s\n", argv[1]);
+  inicia_gerador(&gerador_banco, time(NULL));
+
+  tela_inicio(LARGURA,ALTURA,"klondike");
+  tela_limita_quadros(quadros_por_segundo);
+  calcula_disposicao(&disposicao_janela, LARGURA, ALTURA);
   double pontos;
  
   do {
-    pontos = jogo();
+    pontos = n_mesas > 1 ? jogo_em_mesas(n_mesas) : jogo();
   } while(quer_jogar_de_novo(pontos));
   
   tela_fim();
+  fecha_banco(&banco);
+  termina_exportacao_metricas();
+  if (com_telemetria) {
+    uint64_t descartados = termina_telemetria(&telemetria);
+    if (descartados > 0)
+      fprintf(stderr, "telemetria: %llu eventos descartados\n", (unsigned long long)descartados);
+  }
  
   return 0;
 }
\ No newline at end of file
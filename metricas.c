@@ -0,0 +1,191 @@
+/**
+ * @file metricas.c
+ *
+ * @brief Contadores e histogramas do jogo, exportados no formato de texto do Prometheus.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "metricas.h"
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+// espaço para o texto de todas as métricas
+#define TAM_TEXTO_METRICAS 8192
+
+metricas_t metricas = {
+  .tempo_quadro = { 10, { 0.005, 0.010, 0.0167, 0.025, 0.034, 0.050, 0.075, 0.100, 0.250, 1.0 } },
+  .desenhos_quadro = { 8, { 50, 100, 200, 400, 800, 1600, 3200, 6400 } },
+  .pontuacao = { 10, { 100, 200, 300, 400, 500, 600, 800, 1000, 1500, 2000 } },
+};
+
+void observa_histograma(histograma_t *h, double valor)
+{
+  int i = 0;
+  while (i < h->n_limites && valor > h->limites[i]) i++;
+  atomic_fetch_add_explicit(&h->baldes[i], 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&h->soma_milesimos, (uint64_t)llround(valor * 1000), memory_order_relaxed);
+  atomic_fetch_add_explicit(&h->contagem, 1, memory_order_relaxed);
+}
+
+// escreve um contador; retorna o número de caracteres
+static size_t escreve_contador(char *texto, size_t tam, const char *nome, const char *ajuda, _Atomic uint64_t *c)
+{
+  return snprintf(texto, tam, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", nome, ajuda, nome, nome,
+                  (unsigned long long)atomic_load_explicit(c, memory_order_relaxed));
+}
+
+// escreve um histograma, com os baldes acumulados como o Prometheus espera; retorna o número de caracteres
+static size_t escreve_histograma(char *texto, size_t tam, const char *nome, const char *ajuda, histograma_t *h)
+{
+  size_t n = snprintf(texto, tam, "# HELP %s %s\n# TYPE %s histogram\n", nome, ajuda, nome);
+  uint64_t acumulado = 0;
+  for (int i = 0; i <= h->n_limites; i++) {
+    acumulado += atomic_load_explicit(&h->baldes[i], memory_order_relaxed);
+    if (i < h->n_limites)
+      n += snprintf(texto + n, n < tam ? tam - n : 0, "%s_bucket{le=\"%g\"} %llu\n", nome, h->limites[i],
+                    (unsigned long long)acumulado);
+    else
+      n += snprintf(texto + n, n < tam ? tam - n : 0, "%s_bucket{le=\"+Inf\"} %llu\n", nome,
+                    (unsigned long long)acumulado);
+  }
+  n += snprintf(texto + n, n < tam ? tam - n : 0, "%s_sum %.3f\n%s_count %llu\n", nome,
+                atomic_load_explicit(&h->soma_milesimos, memory_order_relaxed) / 1000.0, nome,
+                (unsigned long long)atomic_load_explicit(&h->contagem, memory_order_relaxed));
+  return n;
+}
+
+size_t escreve_metricas(char *texto, size_t tam)
+{
+  metricas_t *m = &metricas;
+  size_t n = 0;
+#define RESTO (n < tam ? tam - n : 0)
+  n += escreve_histograma(texto + n, RESTO, "klondike_tempo_quadro_segundos", "Tempo entre dois quadros.", &m->tempo_quadro);
+  n += escreve_histograma(texto + n, RESTO, "klondike_desenhos_por_quadro", "Chamadas de desenho em cada quadro.", &m->desenhos_quadro);
+  n += escreve_contador(texto + n, RESTO, "klondike_quadros_total", "Quadros mostrados.", &m->quadros);
+  n += escreve_contador(texto + n, RESTO, "klondike_desenhos_total", "Chamadas de desenho.", &m->desenhos);
+  n += escreve_contador(texto + n, RESTO, "klondike_carregamentos_fonte_total", "Fontes carregadas do disco.", &m->carregamentos_fonte);
+  n += escreve_contador(texto + n, RESTO, "klondike_bytes_terminal_total", "Bytes escritos no terminal pela tela de texto.", &m->bytes_terminal);
+  n += escreve_contador(texto + n, RESTO, "klondike_jogadas_total", "Jogadas realizadas.", &m->jogadas);
+  n += escreve_contador(texto + n, RESTO, "klondike_partidas_iniciadas_total", "Partidas iniciadas.", &m->partidas_iniciadas);
+  n += escreve_contador(texto + n, RESTO, "klondike_partidas_vencidas_total", "Partidas vencidas.", &m->partidas_vencidas);
+  n += escreve_contador(texto + n, RESTO, "klondike_partidas_abandonadas_total", "Partidas abandonadas.", &m->partidas_abandonadas);
+  n += escreve_histograma(texto + n, RESTO, "klondike_pontuacao", "Pontos das partidas terminadas.", &m->pontuacao);
+#undef RESTO
+  return n;
+}
+
+// estado da thread da exportação
+static struct {
+  char caminho[108];
+  bool socket;
+  double intervalo;
+  int fd;
+  _Atomic bool parar;
+  pthread_t thread;
+  bool iniciada;
+} exportacao;
+
+// escreve as métricas no arquivo, por um arquivo temporário, para o coletor nunca ler pela metade
+static void grava_arquivo_metricas(void)
+{
+  char texto[TAM_TEXTO_METRICAS], temporario[sizeof(exportacao.caminho) + 8];
+  size_t n = escreve_metricas(texto, sizeof(texto));
+  if (n >= sizeof(texto)) n = sizeof(texto) - 1;
+  snprintf(temporario, sizeof(temporario), "%s.tmp", exportacao.caminho);
+  FILE *arq = fopen(temporario, "w");
+  if (arq == NULL) return;
+  bool ok = fwrite(texto, 1, n, arq) == n;
+  ok = fclose(arq) == 0 && ok;
+  if (ok) rename(temporario, exportacao.caminho);
+}
+
+// entrega as métricas a uma conexão e a fecha
+static void atende_conexao_metricas(int conexao)
+{
+  char texto[TAM_TEXTO_METRICAS];
+  size_t n = escreve_metricas(texto, sizeof(texto));
+  if (n >= sizeof(texto)) n = sizeof(texto) - 1;
+  size_t enviados = 0;
+  while (enviados < n) {
+    ssize_t r = send(conexao, texto + enviados, n - enviados, MSG_NOSIGNAL);
+    if (r <= 0) break;
+    enviados += r;
+  }
+  close(conexao);
+}
+
+// laço da thread da exportação
+static void *exporta_metricas(void *arg)
+{
+  double proxima = 0;
+  while (!atomic_load(&exportacao.parar)) {
+    if (exportacao.socket) {
+      struct pollfd p = { exportacao.fd, POLLIN, 0 };
+      if (poll(&p, 1, 100) > 0) {
+        int conexao = accept(exportacao.fd, NULL, NULL);
+        if (conexao >= 0) atende_conexao_metricas(conexao);
+      }
+    } else {
+      struct timespec t;
+      clock_gettime(CLOCK_MONOTONIC, &t);
+      double agora = t.tv_sec + t.tv_nsec / 1e9;
+      if (agora >= proxima) {
+        grava_arquivo_metricas();
+        proxima = agora + exportacao.intervalo;
+      }
+      struct timespec espera = { 0, 100000000 };
+      nanosleep(&espera, NULL);
+    }
+  }
+  if (!exportacao.socket) grava_arquivo_metricas();
+  return NULL;
+}
+
+bool inicia_exportacao_metricas(const char *destino, double intervalo)
+{
+  size_t prefixo = strlen(PREFIXO_SOCKET_METRICAS);
+  exportacao.socket = strncmp(destino, PREFIXO_SOCKET_METRICAS, prefixo) == 0;
+  if (exportacao.socket) destino += prefixo;
+  if (strlen(destino) >= sizeof(exportacao.caminho)) return false;
+  strcpy(exportacao.caminho, destino);
+  exportacao.intervalo = intervalo;
+  atomic_store(&exportacao.parar, false);
+
+  if (exportacao.socket) {
+    struct sockaddr_un endereco = { .sun_family = AF_UNIX };
+    strcpy(endereco.sun_path, exportacao.caminho);
+    exportacao.fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (exportacao.fd < 0) return false;
+    unlink(exportacao.caminho);
+    if (bind(exportacao.fd, (struct sockaddr *)&endereco, sizeof(endereco)) != 0 || listen(exportacao.fd, 8) != 0) {
+      close(exportacao.fd);
+      return false;
+    }
+  }
+  if (pthread_create(&exportacao.thread, NULL, exporta_metricas, NULL) != 0) {
+    if (exportacao.socket) close(exportacao.fd);
+    return false;
+  }
+  exportacao.iniciada = true;
+  return true;
+}
+
+void termina_exportacao_metricas(void)
+{
+  if (!exportacao.iniciada) return;
+  atomic_store(&exportacao.parar, true);
+  pthread_join(exportacao.thread, NULL);
+  if (exportacao.socket) {
+    close(exportacao.fd);
+    unlink(exportacao.caminho);
+  }
+  exportacao.iniciada = false;
+}
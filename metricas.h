@@ -0,0 +1,99 @@
+#ifndef METRICAS_H
+#define METRICAS_H
+
+/**
+ * @file metricas.h
+ *
+ * @brief Contadores e histogramas do jogo, exportados no formato de texto do Prometheus.
+ *
+ * Contar e observar são só somas atômicas relaxadas, sem travas, feitas por
+ * quem desenha ou joga. Uma thread em segundo plano lê os valores de tempos em
+ * tempos e os escreve em um arquivo (trocado de uma vez, por rename) ou os
+ * entrega a cada conexão em um socket Unix, para um coletor local.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// limites máximos de um histograma (o último balde, +Inf, é a mais)
+#define MAX_LIMITES_HISTOGRAMA 16
+// intervalo padrão entre duas escritas no arquivo, em segundos
+#define INTERVALO_METRICAS 5.0
+// prefixo do destino que indica um socket Unix em vez de um arquivo
+#define PREFIXO_SOCKET_METRICAS "unix:"
+
+typedef struct {
+  int n_limites;
+  double limites[MAX_LIMITES_HISTOGRAMA];
+  _Atomic uint64_t baldes[MAX_LIMITES_HISTOGRAMA + 1];
+  // soma dos valores observados, em milésimos
+  _Atomic uint64_t soma_milesimos;
+  _Atomic uint64_t contagem;
+} histograma_t;
+
+typedef struct {
+  // segundos entre dois quadros e chamadas de desenho em cada quadro
+  histograma_t tempo_quadro;
+  histograma_t desenhos_quadro;
+  _Atomic uint64_t quadros;
+  _Atomic uint64_t desenhos;
+  _Atomic uint64_t carregamentos_fonte;
+  // bytes escritos no terminal pela tela de texto (telat.c)
+  _Atomic uint64_t bytes_terminal;
+  _Atomic uint64_t jogadas;
+  _Atomic uint64_t partidas_iniciadas;
+  _Atomic uint64_t partidas_vencidas;
+  _Atomic uint64_t partidas_abandonadas;
+  // pontos das partidas terminadas
+  histograma_t pontuacao;
+} metricas_t;
+
+// as métricas do programa
+extern metricas_t metricas;
+
+/**
+ * @brief Soma um a um contador.
+ *
+ * @param c Ponteiro para o contador.
+ */
+static inline void conta_metrica(_Atomic uint64_t *c)
+{
+  atomic_fetch_add_explicit(c, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Observa um valor em um histograma.
+ *
+ * @param h Ponteiro para o histograma.
+ * @param valor Valor observado.
+ */
+void observa_histograma(histograma_t *h, double valor);
+
+/**
+ * @brief Escreve todas as métricas no formato de texto do Prometheus.
+ *
+ * @param texto Onde escrever.
+ * @param tam Espaço disponível.
+ * @return Número de caracteres escritos (sem o '\0'), ou o que seria preciso se não couber.
+ */
+size_t escreve_metricas(char *texto, size_t tam);
+
+/**
+ * @brief Inicia a thread que exporta as métricas.
+ *
+ * @param destino Caminho do arquivo, ou "unix:" seguido do caminho do socket.
+ * @param intervalo Segundos entre duas escritas no arquivo (ignorado no socket).
+ * @return true se a exportação foi iniciada, false caso contrário.
+ */
+bool inicia_exportacao_metricas(const char *destino, double intervalo);
+
+/**
+ * @brief Escreve as métricas uma última vez e termina a thread da exportação.
+ */
+void termina_exportacao_metricas(void);
+
+#endif // METRICAS_H
@@ -0,0 +1,198 @@
+/**
+ * @file perft.c
+ *
+ * @brief Contagem de sequências de jogadas (perft) a partir de uma distribuição.
+ *
+ * Como o perft dos programas de xadrez: a partir de uma distribuição gerada por
+ * uma semente, percorre todas as sequências de jogadas até uma profundidade,
+ * usando faz_jogada()/desfaz_jogada(), e mostra a contagem em cada profundidade
+ * e os nós por segundo. As contagens são determinísticas e servem para conferir
+ * mudanças nas regras e na geração de jogadas.
+ *
+ * Uso: ./perft [-p profundidade] [-s semente] [-e] [-d] [-v c1,c2,...]
+ *   -e também conta os estados distintos em cada profundidade;
+ *   -d confere se cada jogada desfeita devolve exatamente o estado anterior e
+ *      se as chaves e os valores derivados incrementais estão corretos;
+ *   -v compara as contagens com as esperadas e termina com erro se forem diferentes.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+#include <unistd.h>
+
+#define MAX_PROFUNDIDADE 32
+
+// conjunto de chaves de estados, com endereçamento aberto
+typedef struct {
+  uint64_t *chaves;
+  long capacidade;
+  long n_chaves;
+} conjunto_t;
+
+// contagens da busca
+static long sequencias[MAX_PROFUNDIDADE + 1];
+static conjunto_t estados[MAX_PROFUNDIDADE + 1];
+static bool conta_estados = false;
+static bool confere_desfazer = false;
+
+// relógio monotônico, em segundos
+static double agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// insere uma chave no conjunto, dobrando a capacidade quando fica meio cheio
+static void insere_chave(conjunto_t *c, uint64_t chave)
+{
+  if (chave == 0) chave = 1; // zero marca posição livre
+  if (2 * (c->n_chaves + 1) > c->capacidade) {
+    conjunto_t novo = {NULL, c->capacidade > 0 ? 2 * c->capacidade : 1024, 0};
+    novo.chaves = calloc(novo.capacidade, sizeof(uint64_t));
+    assert(novo.chaves != NULL);
+    for (long i = 0; i < c->capacidade; i++) {
+      if (c->chaves[i] != 0)
+        insere_chave(&novo, c->chaves[i]);
+    }
+    free(c->chaves);
+    *c = novo;
+  }
+  long i = chave & (c->capacidade - 1);
+  while (c->chaves[i] != 0) {
+    if (c->chaves[i] == chave) return;
+    i = (i + 1) & (c->capacidade - 1);
+  }
+  c->chaves[i] = chave;
+  c->n_chaves++;
+}
+
+// compara as pilhas de dois jogos e a pontuação, com a parte que veio do bônus
+static bool jogos_iguais(jogo_t *a, jogo_t *b)
+{
+  if (a->pontos != b->pontos || a->bonus_total != b->bonus_total || a->tempo_ultima_jogada != b->tempo_ultima_jogada)
+    return false;
+  if (chave_jogo(a) != chave_jogo(b) || memcmp(&a->derivados, &b->derivados, sizeof(derivados_t)) != 0)
+    return false;
+  for (int i = 0; i < N_PILHAS; i++) {
+    pilha_t *pa = pilha_do_jogo(a, i);
+    pilha_t *pb = pilha_do_jogo(b, i);
+    if (pa->n_cartas != pb->n_cartas || pa->n_cartas_fechadas != pb->n_cartas_fechadas)
+      return false;
+    for (int k = 0; k < pa->n_cartas; k++) {
+      if (!compara_cartas(pa->cartas[k], pb->cartas[k]))
+        return false;
+    }
+  }
+  return true;
+}
+
+// percorre todas as sequências de jogadas a partir do estado atual
+static void perft(jogo_t *j, int profundidade, int max_profundidade)
+{
+  sequencias[profundidade]++;
+  if (conta_estados)
+    insere_chave(&estados[profundidade], chave_jogo(j));
+  if (profundidade == max_profundidade) return;
+
+  jogada_t jogadas[N_MAX_JOGADAS];
+  int n_jogadas = gera_jogadas(j, jogadas);
+  jogo_t *antes = NULL;
+  if (confere_desfazer) {
+    antes = malloc(sizeof(jogo_t));
+    *antes = *j;
+  }
+
+  for (int i = 0; i < n_jogadas; i++) {
+    desfazer_t d;
+    bool feita = faz_jogada(j, jogadas[i], &d);
+    assert(feita);
+    if (confere_desfazer && (!confere_chaves_jogo(j) || !confere_derivados_jogo(j))) {
+      fprintf(stderr, "erro: chave ou valores derivados incorretos na profundidade %d\n", profundidade + 1);
+      exit(1);
+    }
+    perft(j, profundidade + 1, max_profundidade);
+    desfaz_jogada(j, jogadas[i], &d);
+    if (confere_desfazer && !jogos_iguais(j, antes)) {
+      char comando[MAX_CHAR_CMD+1];
+      descricao_jogada(jogadas[i], comando);
+      fprintf(stderr, "erro: desfazer a jogada '%s' na profundidade %d não devolveu o estado anterior\n",
+              comando, profundidade);
+      exit(1);
+    }
+  }
+
+  free(antes);
+}
+
+int main(int argc, char *argv[])
+{
+  int max_profundidade = 6;
+  uint64_t semente = 1;
+  char *esperadas = NULL;
+  int opcao;
+
+  while ((opcao = getopt(argc, argv, "p:s:edv:")) != -1) {
+    switch (opcao) {
+      case 'p': max_profundidade = atoi(optarg); break;
+      case 's': semente = strtoull(optarg, NULL, 10); break;
+      case 'e': conta_estados = true; break;
+      case 'd': confere_desfazer = true; break;
+      case 'v': esperadas = optarg; break;
+      default:
+        fprintf(stderr, "uso: %s [-p profundidade] [-s semente] [-e] [-d] [-v c1,c2,...]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (max_profundidade < 0 || max_profundidade > MAX_PROFUNDIDADE) {
+    fprintf(stderr, "a profundidade deve estar entre 0 e %d\n", MAX_PROFUNDIDADE);
+    return 1;
+  }
+
+  jogo_t *j = malloc(sizeof(jogo_t));
+  assert(j != NULL);
+  j->relogio = NULL;
+  inicia_pilhas_jogo_com_semente(j, semente);
+
+  double inicio = agora();
+  perft(j, 0, max_profundidade);
+  double duracao = agora() - inicio;
+
+  long total_nos = 0;
+  bool confere = true;
+  printf("profundidade %15s", "sequências");
+  if (conta_estados) printf(" %15s", "estados");
+  printf("\n");
+  for (int p = 0; p <= max_profundidade; p++) {
+    total_nos += sequencias[p];
+    printf("%12d %15ld", p, sequencias[p]);
+    if (conta_estados) printf(" %15ld", estados[p].n_chaves);
+    printf("\n");
+  }
+  printf("nós: %ld em %.3f s (%.0f nós/s)\n", total_nos, duracao, total_nos / duracao);
+
+  // as contagens esperadas começam na profundidade 1
+  for (int p = 1; esperadas != NULL && *esperadas != '\0'; p++) {
+    char *fim;
+    long esperada = strtol(esperadas, &fim, 10);
+    if (fim == esperadas || (*fim != ',' && *fim != '\0')) {
+      fprintf(stderr, "uso: %s [-p profundidade] [-s semente] [-e] [-d] [-v c1,c2,...]\n", argv[0]);
+      for (int k = 0; k <= max_profundidade; k++)
+        free(estados[k].chaves);
+      free(j);
+      return 1;
+    }
+    if (p > max_profundidade || esperada != sequencias[p]) {
+      fprintf(stderr, "profundidade %d: esperado %ld, obtido %ld\n", p, esperada,
+              p <= max_profundidade ? sequencias[p] : 0);
+      confere = false;
+    }
+    esperadas = (*fim == ',') ? fim + 1 : fim;
+  }
+
+  for (int p = 0; p <= max_profundidade; p++)
+    free(estados[p].chaves);
+  free(j);
+  return confere ? 0 : 1;
+}
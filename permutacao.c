@@ -0,0 +1,220 @@
+/**
+ * @file permutacao.c
+ *
+ * @brief Identificadores compactos de distribuições: a posição lexicográfica da ordem do monte.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "permutacao.h"
+
+// número grande de 256 bits, em palavras de 64 bits little-endian
+#define N_PALAVRAS 4
+
+// os dígitos são agrupados enquanto o produto das bases cabe em 64 bits
+typedef struct {
+  int inicio;
+  int fim;
+  uint64_t produto;
+} grupo_digitos_t;
+
+// o dígito i do código de Lehmer tem base 52 - i; cada grupo tem o produto das suas bases
+static const grupo_digitos_t grupos[] = {
+  {0, 11, 2411123563360512000ULL},
+  {11, 23, 3783468344527872000ULL},
+  {23, 37, 6761440164390912000ULL},
+  {37, 52, 1307674368000ULL},
+};
+#define N_GRUPOS (int)(sizeof(grupos) / sizeof(grupos[0]))
+
+// inversos das bases dos dígitos: a divisão por uma base vira uma multiplicação
+static const uint64_t inverso[N_MAX_CARTAS + 1] = {
+  0,
+  UINT64_MAX / 1, UINT64_MAX / 2, UINT64_MAX / 3, UINT64_MAX / 4, UINT64_MAX / 5, UINT64_MAX / 6,
+  UINT64_MAX / 7, UINT64_MAX / 8, UINT64_MAX / 9, UINT64_MAX / 10, UINT64_MAX / 11, UINT64_MAX / 12,
+  UINT64_MAX / 13, UINT64_MAX / 14, UINT64_MAX / 15, UINT64_MAX / 16, UINT64_MAX / 17, UINT64_MAX / 18,
+  UINT64_MAX / 19, UINT64_MAX / 20, UINT64_MAX / 21, UINT64_MAX / 22, UINT64_MAX / 23, UINT64_MAX / 24,
+  UINT64_MAX / 25, UINT64_MAX / 26, UINT64_MAX / 27, UINT64_MAX / 28, UINT64_MAX / 29, UINT64_MAX / 30,
+  UINT64_MAX / 31, UINT64_MAX / 32, UINT64_MAX / 33, UINT64_MAX / 34, UINT64_MAX / 35, UINT64_MAX / 36,
+  UINT64_MAX / 37, UINT64_MAX / 38, UINT64_MAX / 39, UINT64_MAX / 40, UINT64_MAX / 41, UINT64_MAX / 42,
+  UINT64_MAX / 43, UINT64_MAX / 44, UINT64_MAX / 45, UINT64_MAX / 46, UINT64_MAX / 47, UINT64_MAX / 48,
+  UINT64_MAX / 49, UINT64_MAX / 50, UINT64_MAX / 51, UINT64_MAX / 52,
+};
+
+// divide x pela base usando o inverso, acertando o quociente aproximado; retorna o resto
+static inline uint64_t divide_pela_base(uint64_t *x, int base)
+{
+  uint64_t q = ((unsigned __int128)*x * inverso[base]) >> 64;
+  uint64_t r = *x - q * base;
+  while (r >= (uint64_t)base) {
+    q++;
+    r -= base;
+  }
+  *x = q;
+  return r;
+}
+
+// n = n * fator + parcela
+static void multiplica_soma(uint64_t *n, uint64_t fator, uint64_t parcela)
+{
+  unsigned __int128 vai = parcela;
+  for (int k = 0; k < N_PALAVRAS; k++) {
+    vai += (unsigned __int128)n[k] * fator;
+    n[k] = (uint64_t)vai;
+    vai >>= 64;
+  }
+}
+
+// n = n / divisor, retornando o resto
+static uint64_t divide(uint64_t *n, uint64_t divisor)
+{
+  uint64_t resto = 0;
+  for (int k = N_PALAVRAS - 1; k >= 0; k--) {
+#if defined(__x86_64__)
+    // o resto é menor que o divisor, então o quociente de 128 por 64 bits cabe em 64: uma instrução div
+    uint64_t quociente;
+    __asm__("divq %4" : "=a"(quociente), "=d"(resto) : "a"(n[k]), "d"(resto), "rm"(divisor));
+    n[k] = quociente;
+#else
+    unsigned __int128 atual = ((unsigned __int128)resto << 64) | n[k];
+    n[k] = (uint64_t)(atual / divisor);
+    resto = (uint64_t)(atual % divisor);
+#endif
+  }
+  return resto;
+}
+
+// posição do k-ésimo bit ligado (a partir de 0) da máscara
+static int seleciona_bit(uint64_t mascara, int k)
+{
+  // seleção em palavra: conta os bits de cada byte em paralelo, acha o byte pelas
+  // somas acumuladas e termina dentro dele
+  const uint64_t uns = 0x0101010101010101ULL, altos = 0x8080808080808080ULL;
+  uint64_t c = mascara - ((mascara >> 1) & 0x5555555555555555ULL);
+  c = (c & 0x3333333333333333ULL) + ((c >> 2) & 0x3333333333333333ULL);
+  c = (c + (c >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  uint64_t acumulado = c * uns;
+  // número de bytes cuja soma acumulada ainda não passa de k
+  uint64_t ate_k = (((k * uns) | altos) - acumulado) & altos;
+  int byte = ((ate_k >> 7) * uns) >> 56;
+  int antes = ((acumulado << 8) >> (8 * byte)) & 0xff;
+  // dentro do byte, o mesmo truque: cada bit vai para um byte e as somas acumuladas dizem a posição
+  uint64_t espalhado = (((mascara >> (8 * byte)) & 0xff) * uns) & 0x8040201008040201ULL;
+  uint64_t bits = ((espalhado + 0x7f7f7f7f7f7f7f7fULL) >> 7) & uns;
+  uint64_t ate_resto = ((((k - antes) * uns) | altos) - bits * uns) & altos;
+  return 8 * byte + (int)((((ate_resto >> 7) * uns) >> 56));
+}
+
+// transforma os dígitos do código de Lehmer na ordem das cartas
+static void monta_ordem(const uint8_t *digitos, uint8_t *ordem)
+{
+  uint64_t livres = (1ULL << N_MAX_CARTAS) - 1;
+  for (int i = 0; i < N_MAX_CARTAS; i++) {
+    int carta = seleciona_bit(livres, digitos[i]);
+    ordem[i] = carta;
+    livres &= ~(1ULL << carta);
+  }
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// o mesmo com a instrução pdep, que deposita o bit k na k-ésima posição livre
+__attribute__((target("bmi2")))
+static void monta_ordem_pdep(const uint8_t *digitos, uint8_t *ordem)
+{
+  uint64_t livres = (1ULL << N_MAX_CARTAS) - 1;
+  for (int i = 0; i < N_MAX_CARTAS; i++) {
+    uint64_t bit = __builtin_ia32_pdep_di(1ULL << digitos[i], livres);
+    ordem[i] = __builtin_ctzll(bit);
+    livres &= ~bit;
+  }
+}
+#endif
+
+void codifica_ordem(const uint8_t *ordem, id_distribuicao_t *id)
+{
+  uint64_t n[N_PALAVRAS] = {0};
+  uint64_t livres = (1ULL << N_MAX_CARTAS) - 1;
+
+  for (int g = 0; g < N_GRUPOS; g++) {
+    uint64_t parcela = 0;
+    for (int i = grupos[g].inicio; i < grupos[g].fim; i++) {
+      // dígito: quantas cartas livres são menores que a carta da posição
+      uint64_t bit = 1ULL << ordem[i];
+      parcela = parcela * (N_MAX_CARTAS - i) + __builtin_popcountll(livres & (bit - 1));
+      livres &= ~bit;
+    }
+    multiplica_soma(n, grupos[g].produto, parcela);
+  }
+
+  for (int b = 0; b < TAM_ID_DISTRIBUICAO; b++)
+    id->bytes[b] = n[b / 8] >> (8 * (b % 8));
+}
+
+bool decodifica_ordem(const id_distribuicao_t *id, uint8_t *ordem)
+{
+  uint64_t n[N_PALAVRAS] = {0};
+  for (int b = 0; b < TAM_ID_DISTRIBUICAO; b++)
+    n[b / 8] |= (uint64_t)id->bytes[b] << (8 * (b % 8));
+
+  // tira os grupos do fim para o começo, e os dígitos de cada grupo também
+  uint8_t digitos[N_MAX_CARTAS];
+  for (int g = N_GRUPOS - 1; g >= 0; g--) {
+    uint64_t parcela = divide(n, grupos[g].produto);
+    for (int i = grupos[g].fim - 1; i >= grupos[g].inicio; i--) {
+      digitos[i] = divide_pela_base(&parcela, N_MAX_CARTAS - i);
+    }
+  }
+  // sobrou alguma coisa: o número era maior ou igual a 52!
+  for (int k = 0; k < N_PALAVRAS; k++)
+    if (n[k] != 0) return false;
+
+#if defined(__x86_64__) && defined(__GNUC__)
+  if (__builtin_cpu_supports("bmi2")) {
+    monta_ordem_pdep(digitos, ordem);
+    return true;
+  }
+#endif
+  monta_ordem(digitos, ordem);
+  return true;
+}
+
+void id_do_jogo(jogo_t *j, id_distribuicao_t *id)
+{
+  uint8_t ordem[N_MAX_CARTAS];
+  ordem_inicial_jogo(j, ordem);
+  codifica_ordem(ordem, id);
+}
+
+bool inicia_pilhas_jogo_com_id(jogo_t *j, const id_distribuicao_t *id)
+{
+  uint8_t ordem[N_MAX_CARTAS];
+  if (!decodifica_ordem(id, ordem)) return false;
+  inicia_pilhas_jogo_com_ordem(j, ordem);
+  return true;
+}
+
+void id_para_texto(const id_distribuicao_t *id, char *texto)
+{
+  for (int b = 0; b < TAM_ID_DISTRIBUICAO; b++)
+    sprintf(texto + 2 * b, "%02x", id->bytes[TAM_ID_DISTRIBUICAO - 1 - b]);
+}
+
+// valor de um dígito hexadecimal, ou -1
+static int valor_hexa(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  c = tolower(c);
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+bool texto_para_id(const char *texto, id_distribuicao_t *id)
+{
+  if (strlen(texto) != TAM_TEXTO_ID) return false;
+  for (int b = 0; b < TAM_ID_DISTRIBUICAO; b++) {
+    int alto = valor_hexa(texto[2 * b]), baixo = valor_hexa(texto[2 * b + 1]);
+    if (alto < 0 || baixo < 0) return false;
+    id->bytes[TAM_ID_DISTRIBUICAO - 1 - b] = alto * 16 + baixo;
+  }
+  return true;
+}
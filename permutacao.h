@@ -0,0 +1,87 @@
+#ifndef PERMUTACAO_H
+#define PERMUTACAO_H
+
+/**
+ * @file permutacao.h
+ *
+ * @brief Identificadores compactos de distribuições: a posição lexicográfica da ordem do monte.
+ *
+ * Uma distribuição é uma permutação das 52 cartas, e há 52! < 2^226 delas. A
+ * posição (rank) da permutação na ordem lexicográfica cabe em 29 bytes e
+ * identifica a distribuição independentemente do gerador que a embaralhou: duas
+ * distribuições são iguais se e só se os identificadores forem iguais.
+ *
+ * A conversão usa o código de Lehmer: cada dígito é o número de cartas ainda não
+ * usadas menores que a carta da posição, contado com popcount em uma máscara de
+ * bits, e os dígitos são agrupados em palavras de 64 bits antes de entrar no
+ * número grande. Na volta, a carta de cada dígito é achada selecionando o
+ * k-ésimo bit da máscara das cartas livres, com a instrução pdep quando o
+ * processador tem BMI2 ou com contagem de bits em paralelo quando não tem.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+
+// número de bytes de um identificador: 226 bits arredondados para cima
+#define TAM_ID_DISTRIBUICAO 29
+// caracteres do identificador em hexadecimal, sem o '\0'
+#define TAM_TEXTO_ID (2 * TAM_ID_DISTRIBUICAO)
+
+// identificador de uma distribuição: a posição lexicográfica, em little-endian
+typedef struct {
+  uint8_t bytes[TAM_ID_DISTRIBUICAO];
+} id_distribuicao_t;
+
+/**
+ * @brief Calcula a posição lexicográfica de uma ordem do monte.
+ *
+ * @param ordem Os N_MAX_CARTAS índices das cartas (uma permutação de 0 a 51).
+ * @param id Ponteiro para o identificador.
+ */
+void codifica_ordem(const uint8_t *ordem, id_distribuicao_t *id);
+
+/**
+ * @brief Refaz a ordem do monte a partir da posição lexicográfica.
+ *
+ * @param id Ponteiro para o identificador.
+ * @param ordem Vetor com espaço para N_MAX_CARTAS índices.
+ * @return true se o identificador é válido (menor que 52!), false caso contrário.
+ */
+bool decodifica_ordem(const id_distribuicao_t *id, uint8_t *ordem);
+
+/**
+ * @brief Calcula o identificador da distribuição de um jogo recém-distribuído.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo, antes de qualquer jogada.
+ * @param id Ponteiro para o identificador.
+ */
+void id_do_jogo(jogo_t *j, id_distribuicao_t *id);
+
+/**
+ * @brief Inicializa as pilhas do jogo com a distribuição de um identificador.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param id Ponteiro para o identificador.
+ * @return true se o identificador é válido, false caso contrário (o jogo não é alterado).
+ */
+bool inicia_pilhas_jogo_com_id(jogo_t *j, const id_distribuicao_t *id);
+
+/**
+ * @brief Escreve o identificador em hexadecimal, do byte mais significativo para o menos.
+ *
+ * @param id Ponteiro para o identificador.
+ * @param texto Vetor com espaço para TAM_TEXTO_ID + 1 caracteres.
+ */
+void id_para_texto(const id_distribuicao_t *id, char *texto);
+
+/**
+ * @brief Lê um identificador escrito em hexadecimal por id_para_texto().
+ *
+ * @param texto O texto com TAM_TEXTO_ID dígitos hexadecimais.
+ * @param id Ponteiro para o identificador.
+ * @return true se o texto é válido, false caso contrário.
+ */
+bool texto_para_id(const char *texto, id_distribuicao_t *id);
+
+#endif // PERMUTACAO_H
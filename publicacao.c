@@ -0,0 +1,36 @@
+/**
+ * @file publicacao.c
+ *
+ * @brief Passagem de cópias do jogo de uma thread para outra, sem travas.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "publicacao.h"
+
+void inicia_publicacao(publicacao_t *p, jogo_t *j)
+{
+  for (int i = 0; i < 3; i++)
+    p->copias[i] = *j;
+  p->escrita = 0;
+  atomic_store(&p->meio, 1);
+  p->leitura = 2;
+}
+
+void publica_jogo(publicacao_t *p, jogo_t *j)
+{
+  p->copias[p->escrita] = *j;
+  // a cópia escrita vai para o meio e a que estava no meio passa a ser escrita
+  int antiga = atomic_exchange_explicit(&p->meio, p->escrita | PUBLICACAO_NOVA, memory_order_acq_rel);
+  p->escrita = antiga & ~PUBLICACAO_NOVA;
+}
+
+jogo_t *ultimo_jogo_publicado(publicacao_t *p)
+{
+  // só troca se houver uma cópia nova; senão continua com a mesma
+  if (atomic_load_explicit(&p->meio, memory_order_relaxed) & PUBLICACAO_NOVA) {
+    int nova = atomic_exchange_explicit(&p->meio, p->leitura, memory_order_acq_rel);
+    p->leitura = nova & ~PUBLICACAO_NOVA;
+  }
+  return &p->copias[p->leitura];
+}
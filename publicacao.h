@@ -0,0 +1,62 @@
+#ifndef PUBLICACAO_H
+#define PUBLICACAO_H
+
+/**
+ * @file publicacao.h
+ *
+ * @brief Passagem de cópias do jogo de uma thread para outra, sem travas.
+ *
+ * Três cópias do jogo se revezam: uma é a que a thread da lógica está escrevendo,
+ * outra a que a thread do desenho está lendo e a terceira, a do meio, é a última
+ * publicada. Publicar e pegar a última cópia são só uma troca atômica com a do
+ * meio, então nenhuma das threads espera pela outra: a lógica publica quantas vezes
+ * quiser e o desenho sempre pega a cópia mais recente, que ninguém mais altera.
+ *
+ * Só uma thread pode escrever e só uma pode ler.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+#include <stdatomic.h>
+
+// bit do índice da cópia do meio que indica que ela ainda não foi lida
+#define PUBLICACAO_NOVA 4
+
+typedef struct {
+  jogo_t copias[3];
+  // índice da cópia do meio, com PUBLICACAO_NOVA se ela foi publicada depois da última leitura
+  _Atomic int meio;
+  // cópias em uso por cada thread
+  int escrita;
+  int leitura;
+} publicacao_t;
+
+/**
+ * @brief Prepara a publicação, com todas as cópias iguais ao jogo dado.
+ *
+ * @param p Ponteiro para a publicação.
+ * @param j Ponteiro para o jogo inicial.
+ */
+void inicia_publicacao(publicacao_t *p, jogo_t *j);
+
+/**
+ * @brief Publica uma cópia do jogo (thread da lógica).
+ *
+ * @param p Ponteiro para a publicação.
+ * @param j Ponteiro para o jogo a ser copiado.
+ */
+void publica_jogo(publicacao_t *p, jogo_t *j);
+
+/**
+ * @brief Retorna a cópia publicada mais recente (thread do desenho).
+ *
+ * A cópia pode ser alterada por quem lê (as coordenadas das pilhas, por exemplo)
+ * e continua válida até a próxima chamada.
+ *
+ * @param p Ponteiro para a publicação.
+ * @return Ponteiro para a cópia.
+ */
+jogo_t *ultimo_jogo_publicado(publicacao_t *p);
+
+#endif // PUBLICACAO_H
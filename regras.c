@@ -0,0 +1,1407 @@
+/**
+ * @file regras.c
+ *
+ * @brief Regras do jogo klondike (paciência): pilhas, cartas e jogadas.
+ *
+ * Este arquivo não depende da Allegro, para que as regras possam ser usadas
+ * sem janela (robôs, testes de desempenho, ferramentas).
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+
+// com CONFERE_CHAVES definido, toda alteração de pilha confere a chave incremental
+#ifdef CONFERE_CHAVES
+#define CONFERE_CHAVE_PILHA(p) assert((p)->chave == calcula_chave_pilha(p))
+#else
+#define CONFERE_CHAVE_PILHA(p)
+#endif
+
+// lê o relógio do jogo; sem relógio o tempo não passa
+double relogio_do_jogo(jogo_t *j)
+{
+  if (j->relogio == NULL)
+    return 0;
+  return j->relogio();
+}
+
+/**
+ * @brief Calcula o bônus com base no tempo da última jogada e pontos obtidos.
+ *
+ * Esta função calcula um bônus com base no tempo decorrido desde a última jogada
+ * e nos pontos obtidos na jogada atual. O bônus é calculado de acordo com a fórmula:
+ *   pontuacao = (7.0 - tempo_jogada) / 7.0 * 3.0 * pontos_da_jogada;
+ * Se o tempo_jogada for maior ou igual a 7 segundos, o bônus é zero.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param pontos_da_jogada Número de pontos obtidos na jogada atual.
+ * @return Valor do bônus calculado.
+ */
+double bonus(jogo_t *j, int pontos_da_jogada)
+{
+  double pontuacao;
+  double tempo_jogada = relogio_do_jogo(j) - j->tempo_ultima_jogada;
+  if (tempo_jogada < 7)
+    pontuacao = (7.0 - tempo_jogada) / 7.0 * 3.0 * pontos_da_jogada;
+  else
+    pontuacao = 0;
+  j->tempo_ultima_jogada = relogio_do_jogo(j);
+  j->bonus_total += pontuacao;
+  
+  return pontuacao;
+}
+
+// cartas sobre as quais cada carta pode ser empilhada nas pilhas principais (cor diferente
+// e valor uma unidade maior), um bit por índice de carta
+static const uint64_t empilha_sobre[N_MAX_CARTAS] = {
+  0x0010008000000ULL, 0x0020010000000ULL, 0x0040020000000ULL, 0x0080040000000ULL,
+  0x0100080000000ULL, 0x0200100000000ULL, 0x0400200000000ULL, 0x0800400000000ULL,
+  0x1000800000000ULL, 0x2001000000000ULL, 0x4002000000000ULL, 0x8004000000000ULL,
+  0x0000000000000ULL, 0x0010008000000ULL, 0x0020010000000ULL, 0x0040020000000ULL,
+  0x0080040000000ULL, 0x0100080000000ULL, 0x0200100000000ULL, 0x0400200000000ULL,
+  0x0800400000000ULL, 0x1000800000000ULL, 0x2001000000000ULL, 0x4002000000000ULL,
+  0x8004000000000ULL, 0x0000000000000ULL, 0x0000000004002ULL, 0x0000000008004ULL,
+  0x0000000010008ULL, 0x0000000020010ULL, 0x0000000040020ULL, 0x0000000080040ULL,
+  0x0000000100080ULL, 0x0000000200100ULL, 0x0000000400200ULL, 0x0000000800400ULL,
+  0x0000001000800ULL, 0x0000002001000ULL, 0x0000000000000ULL, 0x0000000004002ULL,
+  0x0000000008004ULL, 0x0000000010008ULL, 0x0000000020010ULL, 0x0000000040020ULL,
+  0x0000000080040ULL, 0x0000000100080ULL, 0x0000000200100ULL, 0x0000000400200ULL,
+  0x0000000800400ULL, 0x0000001000800ULL, 0x0000002001000ULL, 0x0000000000000ULL,
+};
+
+// carta sobre a qual cada carta pode ir nas pilhas de saída (mesmo naipe e valor uma
+// unidade menor), um bit por índice de carta; o ás vai para pilha vazia
+static const uint64_t sobe_na_saida[N_MAX_CARTAS] = {
+  0x0000000000000ULL, 0x0000000000001ULL, 0x0000000000002ULL, 0x0000000000004ULL,
+  0x0000000000008ULL, 0x0000000000010ULL, 0x0000000000020ULL, 0x0000000000040ULL,
+  0x0000000000080ULL, 0x0000000000100ULL, 0x0000000000200ULL, 0x0000000000400ULL,
+  0x0000000000800ULL, 0x0000000000000ULL, 0x0000000002000ULL, 0x0000000004000ULL,
+  0x0000000008000ULL, 0x0000000010000ULL, 0x0000000020000ULL, 0x0000000040000ULL,
+  0x0000000080000ULL, 0x0000000100000ULL, 0x0000000200000ULL, 0x0000000400000ULL,
+  0x0000000800000ULL, 0x0000001000000ULL, 0x0000000000000ULL, 0x0000004000000ULL,
+  0x0000008000000ULL, 0x0000010000000ULL, 0x0000020000000ULL, 0x0000040000000ULL,
+  0x0000080000000ULL, 0x0000100000000ULL, 0x0000200000000ULL, 0x0000400000000ULL,
+  0x0000800000000ULL, 0x0001000000000ULL, 0x0002000000000ULL, 0x0000000000000ULL,
+  0x0008000000000ULL, 0x0010000000000ULL, 0x0020000000000ULL, 0x0040000000000ULL,
+  0x0080000000000ULL, 0x0100000000000ULL, 0x0200000000000ULL, 0x0400000000000ULL,
+  0x0800000000000ULL, 0x1000000000000ULL, 0x2000000000000ULL, 0x4000000000000ULL,
+};
+
+// cor de cada naipe
+static const cor_t cor_naipe[] = {naipe_vermelho, naipe_vermelho, naipe_preto, naipe_preto};
+
+// espalha os bits de um número (finalizador do splitmix64)
+uint64_t espalha_64(uint64_t x)
+{
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// índice da carta, entre 0 e 51, ordenado por naipe e valor
+int indice_carta(carta_t c)
+{
+  return c.naipe * 13 + c.valor - 1;
+}
+
+// carta correspondente a um índice
+carta_t carta_do_indice(int indice)
+{
+  return cria_carta(indice % 13 + 1, indice / 13);
+}
+
+// número aleatório de Zobrist de uma carta em uma posição, aberta ou fechada.
+// em vez de uma tabela, usa uma função de espalhamento, que não precisa ser inicializada
+static uint64_t zobrist(carta_t c, int pos, bool aberta)
+{
+  return espalha_64(((uint64_t)indice_carta(c) * N_MAX_CARTAS + pos) * 2 + aberta + 1);
+}
+
+// calcula a chave da pilha do zero
+uint64_t calcula_chave_pilha(pilha_t *p)
+{
+  uint64_t chave = 0;
+  for (int i = 0; i < p->n_cartas; i++)
+    chave ^= zobrist(p->cartas[i], i, i >= p->n_cartas_fechadas);
+  return chave;
+}
+
+// calcula o tamanho da sequência válida que termina na posição pos (0 se a carta estiver fechada)
+static int calcula_sequencia(pilha_t *p, int pos)
+{
+  if (pos < p->n_cartas_fechadas)
+    return 0;
+  if (pos > p->n_cartas_fechadas) {
+    carta_t abaixo = p->cartas[pos - 1];
+    carta_t c = p->cartas[pos];
+    if (cor_carta(c) != cor_carta(abaixo) && c.valor == abaixo.valor - 1)
+      return p->sequencia[pos - 1] + 1;
+  }
+  return 1;
+}
+
+// recalcula a chave e as sequências da pilha, depois de alterar as cartas diretamente
+void recalcula_pilha(pilha_t *p)
+{
+  p->chave = calcula_chave_pilha(p);
+  for (int i = 0; i < p->n_cartas; i++)
+    p->sequencia[i] = calcula_sequencia(p, i);
+}
+
+// tamanho da sequência válida de cartas abertas no topo da pilha
+int tamanho_sequencia_topo(pilha_t *p)
+{
+  if (pilha_vazia(p))
+    return 0;
+  return p->sequencia[p->n_cartas - 1];
+}
+
+// verifica se a pilha está vazia
+bool pilha_vazia(pilha_t *p)
+{
+  return p->n_cartas == 0;
+}
+
+// verifica se a pilha está cheia
+bool pilha_cheia(pilha_t *p)
+{
+  return p->n_cartas == N_MAX_CARTAS;
+}
+
+// faça uma função que empilha uma carta em uma pilha. 
+void empilha_carta(pilha_t *p, carta_t carta) 
+{
+  int n_cartas = p->n_cartas;
+  // se a pilha está vazia, insere a carta aberta
+  if (n_cartas == 0) {
+    p->cartas[n_cartas] = carta;
+    p->n_cartas++;
+    p->chave ^= zobrist(carta, n_cartas, true);
+  } else { // se a pilha não está vazia
+    // se a carta do topo esta fechada, adiciona carta e deixa fechada
+    if (n_cartas == p->n_cartas_fechadas) {
+      p->cartas[n_cartas] = carta;
+      p->n_cartas++;
+      p->n_cartas_fechadas++;
+      p->chave ^= zobrist(carta, n_cartas, false);
+
+    } else { //se a carta do topo está aberta, adiciona carta e deixa aberta
+      p->cartas[n_cartas] = carta;
+      p->n_cartas++;
+      p->chave ^= zobrist(carta, n_cartas, true);
+    }
+  }
+  p->sequencia[n_cartas] = calcula_sequencia(p, n_cartas);
+  CONFERE_CHAVE_PILHA(p);
+}
+
+// retorna a carta no topo de uma pilha. 
+// Quem chama precisa verificar se a pilha nao é vazia
+carta_t retorna_carta_topo(pilha_t *p)
+{
+  assert(!pilha_vazia(p));
+  return p->cartas[p->n_cartas - 1];
+}
+
+// retorna a carta no topo da pilha, removendo essa carta da pilha.
+// Quem chama precisa verificar se a pilha nao esta vazia
+carta_t remove_carta_topo(pilha_t *p)
+{ 
+  assert(!pilha_vazia(p));
+  carta_t c = retorna_carta_topo(p);
+  p->chave ^= zobrist(c, p->n_cartas - 1, p->n_cartas > p->n_cartas_fechadas);
+  if (p->n_cartas == p->n_cartas_fechadas && p->n_cartas_fechadas > 0)
+    p->n_cartas_fechadas--;
+  p->n_cartas--;
+  CONFERE_CHAVE_PILHA(p);
+  return c;
+}
+
+// verifica se a bilha está fechada
+bool pilha_fechada(pilha_t *p)
+{
+  return p->n_cartas == p->n_cartas_fechadas;
+}
+
+// abre a carta do topo de uma pilha.
+void abre_carta_topo_pilha(pilha_t *p)
+{
+  assert(pilha_fechada(p));
+  carta_t c = retorna_carta_topo(p);
+  p->chave ^= zobrist(c, p->n_cartas - 1, false) ^ zobrist(c, p->n_cartas - 1, true);
+  p->n_cartas_fechadas--;
+  p->sequencia[p->n_cartas - 1] = 1;
+  CONFERE_CHAVE_PILHA(p);
+}
+
+// fecha todas as cartas da pilha.
+void fecha_todas_cartas_pilha(pilha_t *p)
+{
+  assert(!pilha_vazia(p));
+  for (int i = p->n_cartas_fechadas; i < p->n_cartas; i++) {
+    p->chave ^= zobrist(p->cartas[i], i, true) ^ zobrist(p->cartas[i], i, false);
+    p->sequencia[i] = 0;
+  }
+  p->n_cartas_fechadas = p->n_cartas;
+  CONFERE_CHAVE_PILHA(p);
+}
+
+// esvazia a pilha
+void esvazia_pilha(pilha_t *p)
+{
+  p->n_cartas = 0;
+  p->n_cartas_fechadas = 0;
+  p->chave = 0;
+}
+
+// gera baralho inteiro
+void gera_baralho_inteiro(pilha_t *p)
+{
+  for (naipe_t n = ouros; n <= paus; n++) {
+    for (valor_t v = as; v <= rei; v++) {
+      carta_t c = cria_carta(v,n);
+      p->cartas[p->n_cartas] = c;
+      p->chave ^= zobrist(c, p->n_cartas, false);
+      p->sequencia[p->n_cartas] = 0;
+      p->n_cartas++;
+      p->n_cartas_fechadas++;
+    }
+  }
+}
+
+// embaralha cartas da pilha
+void embaralha_cartas_pilha(pilha_t *p)
+{
+  assert(!pilha_vazia(p));
+  srand(time(NULL));
+  int i = 0, j = 0, metade = N_MAX_CARTAS/2;
+  
+  for (i = 0; i < N_MAX_CARTAS; i++) {
+    // Gera um índice aleatório entre 0 e n_cartas (exclusivo)
+    // Troca apenas se o índice i for par
+    if (i % 2 == 0) {
+      // Gera um índice aleatório entre i e n_cartas (exclusivo)
+      //numero entre metade e N_MAX_CARTAS
+      if (i < metade)
+         j = (rand() % (N_MAX_CARTAS - metade)) + metade;
+      //numero entre 0 e N_MAX_CARTAS / 2
+      else
+        j = (rand() % (N_MAX_CARTAS - metade));
+    } else {
+      // Não realiza troca, mantém o índice atual
+      j = i;
+    }
+    // Troca as cartas nas posições i e j
+    carta_t temp = p->cartas[i];
+    p->cartas[i] = p->cartas[j];
+    p->cartas[j] = temp;
+  }
+
+  for (i = 0; i < N_MAX_CARTAS; i++) {
+    // Gera um índice aleatório entre 0 e n_cartas (exclusivo)
+    // Troca apenas se o índice i for impar
+    if (i % 2 != 0) {
+      if (i < metade)
+        j = (rand() % (N_MAX_CARTAS - metade));
+      else
+        j = (rand() % (N_MAX_CARTAS - metade)) + metade;
+    } else {
+      // Não realiza troca, mantém o índice atual
+      j = i;
+    }
+    // Troca as cartas nas posições i e j
+    carta_t temp = p->cartas[i];
+    p->cartas[i] = p->cartas[j];
+    p->cartas[j] = temp;
+  }
+  
+  i = 0;
+  while (i < N_MAX_CARTAS) {
+      if (i < metade)
+         j = (rand() % (N_MAX_CARTAS - metade)) + metade;
+      //numero entre 0 e N_MAX_CARTAS / 2
+      else
+        j = (rand() % (N_MAX_CARTAS - metade));
+      carta_t temp = p->cartas[j];
+      p->cartas[j] = p->cartas[i];
+      p->cartas[i] = temp;
+
+      i++;
+  }
+  
+  recalcula_pilha(p);
+}
+
+// retorna numero de cartas da pilha
+int numero_cartas_pilha(pilha_t *p)
+{
+  return p->n_cartas;
+}
+
+// retorna numero de cartas fechadas da pilha
+int numero_cartas_fechadas_pilha(pilha_t *p)
+{
+  return p->n_cartas_fechadas;
+}
+
+// retorna numero de cartas abertas da pilha
+int numero_cartas_abertas_pilha(pilha_t *p)
+{
+  return p->n_cartas - p->n_cartas_fechadas;
+}
+
+// verifica se posicao da carta na pilha é valida (não pode ser maior nem menor que o tamanho da pilha)
+bool posicao_valida(pilha_t *p, int pos)
+{
+  if (pos >= 0) {
+    if (pos < p->n_cartas) 
+      return true;
+    else 
+      return false;
+  } else {
+    if (p->n_cartas + pos >= 0)
+      return true;
+    else
+      return false;
+  }
+}
+
+// retorna carta de uma determinada posicao na pilha
+carta_t retorna_carta(pilha_t *p, int pos, bool *aberta)
+{
+  assert(posicao_valida(p,pos));
+  if (pos >= 0) {
+    if (aberta != NULL) {
+      if (pos >= p->n_cartas_fechadas)
+        *aberta = true;
+      else 
+        *aberta = false;
+    }
+    return p->cartas[pos];
+
+  } else { // numero negativo
+    if (aberta != NULL) {
+      if (p->n_cartas + pos >= p->n_cartas_fechadas)
+        *aberta = true;
+      else
+        *aberta = false;
+    }
+    return p->cartas[p->n_cartas + pos];
+  }
+}
+
+// cria a carta atribuindo valor e naipe
+carta_t cria_carta(valor_t valor, naipe_t naipe)
+{
+  carta_t c = {valor, naipe};
+  return c;
+}
+
+// retorna naipe da carta
+naipe_t naipe_carta(carta_t c)
+{
+  return c.naipe;
+}
+
+// retorna valor da carta
+valor_t valor_carta(carta_t c)
+{
+  return c.valor;
+}
+
+// retorna a cor de uma carta
+cor_t cor_carta(carta_t c)
+{
+  return cor_naipe[c.naipe];
+}
+
+// preenche a descricao da carta
+void descricao_carta(carta_t c, char *descricao)
+{
+  // Inicializa a string vazia
+  descricao[0] = '\0';
+
+  // Adiciona o valor da carta à string
+  switch (c.valor) {
+    case as:     sprintf(descricao, "A"); break;
+    case valete: sprintf(descricao, "J"); break;
+    case dama:   sprintf(descricao, "Q"); break;
+    case rei:    sprintf(descricao, "K"); break;
+    default:     sprintf(descricao, "%d", c.valor);
+  }
+
+  // Adiciona o naipe da carta à string
+  switch (c.naipe) {
+    case copas:   strcat(descricao, "\u2665"); break;
+    case ouros:   strcat(descricao, "\u2666"); break;
+    case paus:    strcat(descricao, "\u2663"); break;
+    case espadas: strcat(descricao, "\u2660"); break;
+  }
+}
+
+// compara se duas cartas são iguais
+bool compara_cartas(carta_t c1, carta_t c2)
+{
+  if (naipe_carta(c1) == naipe_carta(c2) && valor_carta(c1) == valor_carta(c2))
+    return true;
+  else 
+    return false;
+}
+
+// testa pela tabela se a carta c pode ser empilhada na pilha principal p
+static bool pode_empilhar_na_pilha(carta_t c, pilha_t *p)
+{
+  if (pilha_vazia(p))
+    return c.valor == rei;
+  return (empilha_sobre[indice_carta(c)] >> indice_carta(retorna_carta_topo(p))) & 1;
+}
+
+// testa se a carta c pode ser empilhada na pilha p, no jogo "solitaire"
+bool pode_empilhar(carta_t c, pilha_t p)
+{
+  return pode_empilhar_na_pilha(c, &p);
+}
+
+// Verifica as condicoes para mover n cartas 
+bool pode_mover(pilha_t *origem, pilha_t *destino, int n_cartas_a_mover) 
+{
+  if (origem->n_cartas - n_cartas_a_mover >= 0 && destino->n_cartas + n_cartas_a_mover <= N_MAX_CARTAS )
+    return true;
+  else
+    return false;
+}
+
+// Move uma quantidade de cartas em ordem
+void move_cartas_em_ordem(pilha_t *origem, pilha_t *destino, int n_cartas_a_mover)
+{
+  assert(pode_mover(origem,destino,n_cartas_a_mover));
+  int n_cartas_origem = origem->n_cartas;
+  int pos = n_cartas_origem - n_cartas_a_mover;
+
+  for (int i = pos; i < n_cartas_origem; i++) {
+    carta_t c = origem->cartas[i];
+    origem->chave ^= zobrist(c, i, i >= origem->n_cartas_fechadas);
+    destino->chave ^= zobrist(c, destino->n_cartas, destino->n_cartas >= destino->n_cartas_fechadas);
+    destino->cartas[destino->n_cartas] = c;
+    destino->sequencia[destino->n_cartas] = calcula_sequencia(destino, destino->n_cartas);
+    destino->n_cartas++;
+  }   
+  origem->n_cartas -= n_cartas_a_mover;
+  CONFERE_CHAVE_PILHA(origem);
+  CONFERE_CHAVE_PILHA(destino);
+
+}
+
+// registra a localização das cartas de uma pilha a partir de uma posição até o topo
+static void localiza_cartas_pilha(derivados_t *d, jogo_t *j, int indice, int pos)
+{
+  pilha_t *p = pilha_do_jogo(j, indice);
+  for (int i = pos; i < p->n_cartas; i++) {
+    localizacao_t *l = &d->localizacao[indice_carta(p->cartas[i])];
+    l->pilha = indice;
+    l->posicao = i;
+    l->aberta = i >= p->n_cartas_fechadas;
+  }
+}
+
+// registra a carta aberta do topo de uma pilha de saída ou principal nas máscaras de topos
+static void registra_topo(derivados_t *d, jogo_t *j, int indice)
+{
+  if (indice < PILHA_SAIDA) return;
+  pilha_t *p = pilha_do_jogo(j, indice);
+  uint64_t *topos = indice < PILHA_PRINCIPAL ? &d->topos_saida : &d->topos_principais;
+
+  int8_t topo = -1;
+  if (!pilha_vazia(p) && !pilha_fechada(p))
+    topo = indice_carta(retorna_carta_topo(p));
+  if (d->topo[indice] >= 0)
+    *topos ^= 1ULL << d->topo[indice];
+  if (topo >= 0)
+    *topos ^= 1ULL << topo;
+  d->topo[indice] = topo;
+
+  if (pilha_vazia(p))
+    d->pilhas_vazias |= 1u << indice;
+  else
+    d->pilhas_vazias &= ~(1u << indice);
+}
+
+// atualiza o que mudou em uma pilha: a localização das cartas da posição pos até o topo
+// e a carta do topo
+static void pilha_alterada(jogo_t *j, int indice, int pos)
+{
+  localiza_cartas_pilha(&j->derivados, j, indice, pos < 0 ? 0 : pos);
+  registra_topo(&j->derivados, j, indice);
+}
+
+// calcula do zero os valores derivados das pilhas
+static derivados_t calcula_derivados(jogo_t *j)
+{
+  derivados_t d;
+  memset(&d, 0, sizeof(d));
+  for (int i = 0; i < N_PILHAS; i++) {
+    localiza_cartas_pilha(&d, j, i, 0);
+    d.topo[i] = -1;
+    registra_topo(&d, j, i);
+  }
+  for (int i = 0; i < N_PILHAS_SAIDA; i++) {
+    pilha_t *p = &j->pilhas_saida[i];
+    d.cartas_saida += numero_cartas_pilha(p);
+    if (!pilha_vazia(p))
+      d.altura_naipe[naipe_carta(retorna_carta_topo(p))] = numero_cartas_pilha(p);
+  }
+  for (int i = 0; i < N_PILHAS_PRINCIPAIS; i++)
+    d.cartas_fechadas += numero_cartas_fechadas_pilha(&j->pilhas_principais[i]);
+  return d;
+}
+
+// recalcula os valores derivados, depois de alterar as pilhas diretamente
+void recalcula_derivados(jogo_t *j)
+{
+  j->derivados = calcula_derivados(j);
+}
+
+// confere os valores derivados e as sequências das pilhas com um cálculo do zero
+bool confere_derivados_jogo(jogo_t *j)
+{
+  derivados_t d = calcula_derivados(j);
+  if (memcmp(&d, &j->derivados, sizeof(d)) != 0)
+    return false;
+  for (int i = 0; i < N_PILHAS; i++) {
+    pilha_t *p = pilha_do_jogo(j, i);
+    for (int k = 0; k < p->n_cartas; k++) {
+      if (p->sequencia[k] != calcula_sequencia(p, k))
+        return false;
+    }
+  }
+  return true;
+}
+
+// conta uma carta que entrou (delta 1) ou saiu (delta -1) das pilhas de saída
+static void conta_carta_saida(jogo_t *j, carta_t c, int delta)
+{
+  j->derivados.cartas_saida += delta;
+  j->derivados.altura_naipe[naipe_carta(c)] += delta;
+}
+
+// abre a carta do topo de uma pilha principal, descontando-a das cartas fechadas
+static void abre_carta_topo_principal(jogo_t *j, int n_pilha)
+{
+  abre_carta_topo_pilha(&j->pilhas_principais[n_pilha]);
+  j->derivados.cartas_fechadas--;
+  pilha_alterada(j, PILHA_PRINCIPAL + n_pilha, numero_cartas_pilha(&j->pilhas_principais[n_pilha]) - 1);
+}
+
+// guarda as pilhas do jogo em um registro compacto
+void compacta_jogo(jogo_t *j, jogo_compacto_t *c)
+{
+  int k = 0;
+  for (int i = 0; i < N_PILHAS; i++) {
+    pilha_t *p = pilha_do_jogo(j, i);
+    c->n_cartas[i] = p->n_cartas;
+    c->n_cartas_fechadas[i] = p->n_cartas_fechadas;
+    for (int n = 0; n < p->n_cartas; n++)
+      c->cartas[k++] = indice_carta(p->cartas[n]);
+  }
+}
+
+// recria as pilhas do jogo a partir do registro compacto
+void expande_jogo(jogo_compacto_t *c, jogo_t *j)
+{
+  int k = 0;
+  for (int i = 0; i < N_PILHAS; i++) {
+    pilha_t *p = pilha_do_jogo(j, i);
+    p->n_cartas = c->n_cartas[i];
+    p->n_cartas_fechadas = c->n_cartas_fechadas[i];
+    for (int n = 0; n < p->n_cartas; n++)
+      p->cartas[n] = carta_do_indice(c->cartas[k++]);
+    recalcula_pilha(p);
+  }
+  recalcula_derivados(j);
+}
+
+// todos os destinos de uma carta, cruzando as tabelas com as máscaras dos topos
+uint16_t destinos_carta(jogo_t *j, carta_t c)
+{
+  derivados_t *d = &j->derivados;
+  int ic = indice_carta(c);
+  uint16_t destinos = 0;
+
+  uint64_t topos = (empilha_sobre[ic] & d->topos_principais) | (sobe_na_saida[ic] & d->topos_saida);
+  while (topos != 0) {
+    destinos |= 1u << d->localizacao[__builtin_ctzll(topos)].pilha;
+    topos &= topos - 1;
+  }
+  if (valor_carta(c) == rei)
+    destinos |= d->pilhas_vazias & MASCARA_PRINCIPAIS;
+  else if (valor_carta(c) == as)
+    destinos |= d->pilhas_vazias & MASCARA_SAIDA;
+
+  return destinos;
+}
+
+// localização de uma carta, em tempo constante
+localizacao_t localiza_carta(jogo_t *j, carta_t c)
+{
+  return j->derivados.localizacao[indice_carta(c)];
+}
+
+// esvazia as pilhas do jogo e gera o baralho inteiro no monte
+static void prepara_baralho(jogo_t *j)
+{
+  j->sair = false;
+  j->comando[0] = '\0';
+  j->analise[0] = '\0';
+  // esvazia pilhas
+  esvazia_pilha(&j->monte);
+  esvazia_pilha(&j->descarte);
+  for (int i = 0; i < N_PILHAS_SAIDA; i++) {
+    esvazia_pilha(&j->pilhas_saida[i]);
+  }
+  for (int i = 0; i < N_PILHAS_PRINCIPAIS; i++) {
+    esvazia_pilha(&j->pilhas_principais[i]);
+  }
+
+  // gera baralho
+  gera_baralho_inteiro(&j->monte);
+}
+
+// distribui as cartas do monte nas pilhas principais
+static void distribui_cartas(jogo_t *j)
+{
+  // distribui cartas na pilha
+  // nao precisa verificar se pode empilhar, pois é o inicio do jogo
+  for (int i = 0; i < N_PILHAS_PRINCIPAIS; i++) {
+    for (int k = 0; k < i+1; k++) {
+      empilha_carta(&j->pilhas_principais[i], remove_carta_topo(&j->monte));
+    }
+
+    fecha_todas_cartas_pilha(&j->pilhas_principais[i]);
+    abre_carta_topo_pilha(&j->pilhas_principais[i]);
+  }
+
+  recalcula_derivados(j);
+  j->tempo_ultima_jogada = relogio_do_jogo(j);
+  j->pontos = 0.0;
+  j->bonus_total = 0.0;
+}
+
+// inicia as pilhas do jogo, distribuindo as cartas
+void inicia_pilhas_jogo(jogo_t *j)
+{
+  prepara_baralho(j);
+
+  // embaralha as cartas
+  embaralha_cartas_pilha(&j->monte);
+
+  distribui_cartas(j);
+}
+
+// inicia as pilhas do jogo com um embaralhamento determinado pela semente
+void inicia_pilhas_jogo_com_semente(jogo_t *j, uint64_t semente)
+{
+  gerador_t g;
+  inicia_gerador(&g, semente);
+
+  prepara_baralho(j);
+  embaralha_cartas(j->monte.cartas, numero_cartas_pilha(&j->monte), &g);
+  recalcula_pilha(&j->monte);
+  distribui_cartas(j);
+}
+
+// inicia as pilhas do jogo com o monte na ordem dada (índices das cartas, do fundo para o topo)
+void inicia_pilhas_jogo_com_ordem(jogo_t *j, const uint8_t *ordem)
+{
+  prepara_baralho(j);
+  for (int i = 0; i < N_MAX_CARTAS; i++)
+    j->monte.cartas[i] = carta_do_indice(ordem[i]);
+  recalcula_pilha(&j->monte);
+  distribui_cartas(j);
+}
+
+// refaz a ordem do monte antes da distribuição, desfazendo distribui_cartas()
+void ordem_inicial_jogo(jogo_t *j, uint8_t *ordem)
+{
+  int n_monte = numero_cartas_pilha(&j->monte);
+  for (int i = 0; i < n_monte; i++)
+    ordem[i] = indice_carta(j->monte.cartas[i]);
+  // as cartas foram tiradas do topo do monte, pilha após pilha
+  int topo = N_MAX_CARTAS - 1;
+  for (int i = 0; i < N_PILHAS_PRINCIPAIS; i++) {
+    for (int k = 0; k < i+1; k++)
+      ordem[topo--] = indice_carta(j->pilhas_principais[i].cartas[k]);
+  }
+}
+
+// verifica se pode mover carta para pilha de saída
+bool pode_mover_para_pilha_saida(jogo_t *j, int n_pilha, carta_t c)
+{
+  if(n_pilha < 0 || n_pilha >= N_PILHAS_SAIDA) return false;
+
+  pilha_t *p = &j->pilhas_saida[n_pilha];
+  if (pilha_vazia(p))
+    return valor_carta(c) == as;
+  return (sobe_na_saida[indice_carta(c)] >> indice_carta(retorna_carta_topo(p))) & 1;
+}
+
+// verifica se pode mover carta para pilha principal
+bool pode_mover_para_pilha_principal(jogo_t *j, int n_pilha, carta_t c)
+{
+  if(n_pilha < 0 || n_pilha >= N_PILHAS_PRINCIPAIS) return false;
+
+  return pode_empilhar_na_pilha(c,&j->pilhas_principais[n_pilha]);
+}
+
+// verifica se pode mover cartas de uma pilha, só pode mover cartas abertas
+bool pode_mover_cartas_pilha(jogo_t *j, int n_pilha, int n_cartas_a_mover)
+{
+  if (n_pilha < 0 || n_pilha >= N_PILHAS_PRINCIPAIS) return false;
+
+  int n_cartas_abertas = numero_cartas_abertas_pilha(&j->pilhas_principais[n_pilha]);
+
+  if (n_cartas_a_mover <= n_cartas_abertas)
+    return true;
+  else
+    return false;
+
+}
+
+// verifica se venceu o jogo
+bool venceu_jogo(jogo_t *j)
+{
+  return j->derivados.cartas_saida == N_MAX_CARTAS;
+}
+
+// move a carta do topo do monte para o topo do descarte aberta
+bool abre_carta(jogo_t *j)
+{
+  if (!pilha_vazia(&j->monte)) {
+    empilha_carta(&j->descarte,remove_carta_topo(&j->monte));
+    pilha_alterada(j,PILHA_DESCARTE,numero_cartas_pilha(&j->descarte) - 1);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// move todas as cartas do descarte para o monte
+bool recicla_descarte(jogo_t *j)
+{
+  if (pilha_vazia(&j->monte) && !pilha_vazia(&j->descarte)) {
+    int num_cartas_descarte = numero_cartas_pilha(&j->descarte);
+    for (int i = 0; i < num_cartas_descarte; i++) {
+      empilha_carta(&j->monte,remove_carta_topo(&j->descarte));
+    }
+    fecha_todas_cartas_pilha(&j->monte);
+    pilha_alterada(j,PILHA_MONTE,0);
+    pilha_alterada(j,PILHA_DESCARTE,0);
+    // reciclagem do descarte zera os pontos
+    j->pontos = 0;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// move carta do descarte para saida
+bool move_carta_descarte_para_saida(jogo_t *j, int n_pilha)
+{
+  if (!pilha_vazia(&j->descarte) && pode_mover_para_pilha_saida(j,n_pilha,retorna_carta_topo(&j->descarte))) {
+    carta_t c = remove_carta_topo(&j->descarte);
+    empilha_carta(&j->pilhas_saida[n_pilha],c);
+    conta_carta_saida(j,c,1);
+    pilha_alterada(j,PILHA_SAIDA + n_pilha,numero_cartas_pilha(&j->pilhas_saida[n_pilha]) - 1);
+    // carta colocada na pilha de saida da 15 pontos;
+    j->pontos += 15;
+    j->tempo_ultima_jogada = relogio_do_jogo(j);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// move carta do descarte para jogo
+bool move_carta_descarte_para_jogo(jogo_t *j, int n_pilha)
+{
+  if (!pilha_vazia(&j->descarte) && pode_mover_para_pilha_principal(j,n_pilha,retorna_carta_topo(&j->descarte))) {
+    empilha_carta(&j->pilhas_principais[n_pilha],remove_carta_topo(&j->descarte));
+    pilha_alterada(j,PILHA_PRINCIPAL + n_pilha,numero_cartas_pilha(&j->pilhas_principais[n_pilha]) - 1);
+    // carta movida do descarte para pilha de jogo dá 10 pontos + bonus
+    j->pontos = j->pontos + 10 + bonus(j,10);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// move carta do jogo para a saida
+bool move_carta_jogo_para_saida(jogo_t *j, int n_pilha_jogo, int n_pilha_saida) 
+{
+  
+  if (n_pilha_jogo < 0 || n_pilha_jogo >= N_PILHAS_PRINCIPAIS) return false;
+
+  if (!pilha_vazia(&j->pilhas_principais[n_pilha_jogo]) &&
+      pode_mover_para_pilha_saida(j,n_pilha_saida,retorna_carta_topo(&j->pilhas_principais[n_pilha_jogo]))) {
+    
+    carta_t c = remove_carta_topo(&j->pilhas_principais[n_pilha_jogo]);
+    empilha_carta(&j->pilhas_saida[n_pilha_saida],c);
+    conta_carta_saida(j,c,1);
+    pilha_alterada(j,PILHA_SAIDA + n_pilha_saida,numero_cartas_pilha(&j->pilhas_saida[n_pilha_saida]) - 1);
+    pilha_alterada(j,PILHA_PRINCIPAL + n_pilha_jogo,numero_cartas_pilha(&j->pilhas_principais[n_pilha_jogo]));
+    // carta colocada na pilha de saida da 15 pontos;
+    j->pontos += 15;
+
+    //abre a carta do topo se ela nao estover aberta
+    if (numero_cartas_pilha(&j->pilhas_principais[n_pilha_jogo]) > 0 && 
+        numero_cartas_fechadas_pilha(&j->pilhas_principais[n_pilha_jogo]) > 0 &&
+        pilha_fechada(&j->pilhas_principais[n_pilha_jogo])) {
+
+      abre_carta_topo_principal(j,n_pilha_jogo);
+      // abertura de carta na pilha de jogo dá 20 pontos + bônus;
+      j->pontos = j->pontos + 20 + bonus(j,20);
+    }
+    
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// move carta da saida para o jogo
+bool move_carta_saida_para_jogo(jogo_t *j, int n_pilha_saida, int n_pilha_jogo) 
+{
+  
+  if (n_pilha_saida < 0 || n_pilha_saida >= N_PILHAS_SAIDA) return false;
+
+  // adicionar verificacao de a pilha nao estar vazia
+  if (!pilha_vazia(&j->pilhas_saida[n_pilha_saida]) &&
+      pode_mover_para_pilha_principal(j,n_pilha_jogo,retorna_carta_topo(&j->pilhas_saida[n_pilha_saida]))) {
+    carta_t c = remove_carta_topo(&j->pilhas_saida[n_pilha_saida]);
+    empilha_carta(&j->pilhas_principais[n_pilha_jogo],c);
+    conta_carta_saida(j,c,-1);
+    pilha_alterada(j,PILHA_PRINCIPAL + n_pilha_jogo,numero_cartas_pilha(&j->pilhas_principais[n_pilha_jogo]) - 1);
+    pilha_alterada(j,PILHA_SAIDA + n_pilha_saida,numero_cartas_pilha(&j->pilhas_saida[n_pilha_saida]));
+    // carta retirada de pilha de saída retira 15 pontos.
+    if (j->pontos - 15 < 0)
+      j->pontos = 0;
+    else
+      j->pontos -= 15;
+    j->tempo_ultima_jogada = relogio_do_jogo(j);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// move tantas cartas de uma pilha do jogo para outra pilha do jogo
+bool move_cartas_entre_pilhas_jogo_com_qtde(jogo_t *j, int n_pilha1, int n_pilha2, int n_cartas_a_mover)
+{
+  if(n_pilha1 < 0 || n_pilha1 >= N_PILHAS_PRINCIPAIS || n_pilha2 < 0 || n_pilha2 >= N_PILHAS_PRINCIPAIS)
+    return false;
+
+  if (pode_mover_cartas_pilha(j,n_pilha1,n_cartas_a_mover) &&
+      pode_mover(&j->pilhas_principais[n_pilha1],&j->pilhas_principais[n_pilha2],n_cartas_a_mover)) {
+    move_cartas_em_ordem(&j->pilhas_principais[n_pilha1],&j->pilhas_principais[n_pilha2],n_cartas_a_mover);
+    pilha_alterada(j,PILHA_PRINCIPAL + n_pilha2,numero_cartas_pilha(&j->pilhas_principais[n_pilha2]) - n_cartas_a_mover);
+    pilha_alterada(j,PILHA_PRINCIPAL + n_pilha1,numero_cartas_pilha(&j->pilhas_principais[n_pilha1]));
+    
+    // esse trecho estava em move cartas em ordem
+    if (numero_cartas_pilha(&j->pilhas_principais[n_pilha1]) > 0 && 
+        numero_cartas_fechadas_pilha(&j->pilhas_principais[n_pilha1]) > 0 && 
+        pilha_fechada(&j->pilhas_principais[n_pilha1])) {
+      abre_carta_topo_principal(j,n_pilha1);
+      j->pontos = j->pontos + 20 + bonus(j,20);
+    }
+
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// quantas cartas da sequência do topo da origem podem ir para o destino (0 se nenhuma).
+// a sequência tem valores consecutivos, então só uma carta dela pode ser a base do movimento
+int cartas_a_mover_entre_pilhas(pilha_t *origem, pilha_t *destino)
+{
+  int tamanho_sequencia = tamanho_sequencia_topo(origem);
+  if (tamanho_sequencia == 0)
+    return 0;
+
+  // valor que a carta da base do movimento precisa ter
+  int valor_base = rei;
+  if (!pilha_vazia(destino))
+    valor_base = valor_carta(retorna_carta_topo(destino)) - 1;
+
+  int n_cartas = valor_base - valor_carta(retorna_carta_topo(origem)) + 1;
+  if (n_cartas < 1 || n_cartas > tamanho_sequencia)
+    return 0;
+  carta_t base = origem->cartas[origem->n_cartas - n_cartas];
+  if (!pilha_vazia(destino) && cor_carta(base) == cor_carta(retorna_carta_topo(destino)))
+    return 0;
+  return n_cartas;
+}
+
+// descobre quantas cartas devem ser movidas de uma pilha para outra
+bool move_cartas_entre_pilhas_jogo(jogo_t *j, int n_pilha1, int n_pilha2)
+{
+  if(n_pilha1 < 0 || n_pilha1 >= N_PILHAS_PRINCIPAIS || n_pilha2 < 0 || n_pilha2 >= N_PILHAS_PRINCIPAIS)
+    return false;
+  
+  int n_cartas_a_mover = cartas_a_mover_entre_pilhas(&j->pilhas_principais[n_pilha1],&j->pilhas_principais[n_pilha2]);
+
+  if (n_cartas_a_mover > 0) {
+    move_cartas_entre_pilhas_jogo_com_qtde(j,n_pilha1,n_pilha2,n_cartas_a_mover);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// verifica qual é a jogada e chama a respectiva funcao que move as cartas
+bool realiza_jogada(jogo_t *j, char *jogada)
+{
+  if (jogada == NULL || jogada[0] == '\0') {
+    return false;
+  }
+
+  char origem_char = jogada[0];
+  char destino_char = '\0';
+  if (jogada[1] == '\0'){
+    if (jogada[0] == 'm')
+      destino_char = 'p';
+    else if (jogada[0] == 'p')
+      destino_char = 'm';
+    else if (jogada[0] == 'f')
+      j->sair = true;
+  } else destino_char = jogada[1];
+
+  origem_char = toupper(origem_char);
+  destino_char = toupper(destino_char);
+
+  int origem = 0, destino = 0;
+  
+  // Mapeia os caracteres para índices numéricos
+  if (origem_char >= 'A' && origem_char <= 'D') {
+    origem = origem_char - 'A';
+  } else if (origem_char >= '1' && origem_char <= '7') {
+    origem = origem_char - '1';
+  } else if (origem_char != 'M' && origem_char != 'P') {
+    return false;
+  }
+
+  if (destino_char >= 'A' && destino_char <= 'D') {
+    destino = destino_char - 'A';
+  } else if (destino_char >= '1' && destino_char <= '7') {
+    destino = destino_char - '1';
+  } else if (destino_char != 'P' && destino_char != 'M') {
+    return false;
+  }
+  
+  //só pode mover da saida para pilha do jogo
+  if (origem_char >= 'A' && origem_char <= 'D') {
+    if (destino_char >= '1' && destino_char <= '7') 
+      return move_carta_saida_para_jogo(j,origem,destino);
+    else 
+      return false;
+  } else if (origem_char >= '1' && origem_char <= '7') { 
+    //só pode mover da pilha do jogo, para outra do jogo ou para saida
+    if (destino_char >= '1' && destino_char <= '7') 
+      return move_cartas_entre_pilhas_jogo(j,origem,destino);
+    else if (destino_char >= 'A' && destino_char <= 'D') 
+      return move_carta_jogo_para_saida(j,origem,destino);
+    else 
+      return false;
+  
+  } else if (origem_char == 'M') {
+    // só pode mover para descarte
+    if (destino_char == 'P')
+      return abre_carta(j);
+    else 
+      return false;
+  
+  } else if (origem_char == 'P') {
+    // pode reciclar descarte, mover para jogo ou saida
+    if (destino_char == 'M') 
+      return recicla_descarte(j);
+    else if (destino_char >= '1' && destino_char <= '7')
+      return move_carta_descarte_para_jogo(j,destino);
+    else if (destino_char >= 'A' && destino_char <= 'D')
+      return move_carta_descarte_para_saida(j,destino);
+    else
+      return false;
+  } else {
+    return false;
+  }
+
+}
+
+// inicializa o gerador, espalhando os bits da semente (splitmix64)
+void inicia_gerador(gerador_t *g, uint64_t semente)
+{
+  uint64_t z = espalha_64(semente + 0x9e3779b97f4a7c15ULL);
+  // o estado do xorshift não pode ser zero
+  g->estado = z != 0 ? z : 0x9e3779b97f4a7c15ULL;
+}
+
+// sorteia um número de 64 bits (xorshift64*)
+uint64_t sorteia_64(gerador_t *g)
+{
+  uint64_t x = g->estado;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  g->estado = x;
+  return x * 0x2545f4914f6cdd1dULL;
+}
+
+// sorteia um número entre 0 e n (exclusivo)
+int sorteia(gerador_t *g, int n)
+{
+  assert(n > 0);
+  return (int)(((sorteia_64(g) >> 32) * (uint64_t)n) >> 32);
+}
+
+// embaralha um vetor de cartas (Fisher-Yates)
+void embaralha_cartas(carta_t *cartas, int n_cartas, gerador_t *g)
+{
+  for (int i = n_cartas - 1; i > 0; i--) {
+    int k = sorteia(g, i + 1);
+    carta_t temp = cartas[i];
+    cartas[i] = cartas[k];
+    cartas[k] = temp;
+  }
+}
+
+// retorna a pilha do jogo de um índice, na ordem em que as pilhas são desenhadas
+pilha_t *pilha_do_jogo(jogo_t *j, int indice)
+{
+  assert(indice >= 0 && indice < N_PILHAS);
+  if (indice == PILHA_MONTE)
+    return &j->monte;
+  else if (indice == PILHA_DESCARTE)
+    return &j->descarte;
+  else if (indice < PILHA_PRINCIPAL)
+    return &j->pilhas_saida[indice - PILHA_SAIDA];
+  else
+    return &j->pilhas_principais[indice - PILHA_PRINCIPAL];
+}
+
+// acrescenta uma jogada ao vetor de jogadas
+static int adiciona_jogada(jogada_t *jogadas, int n_jogadas, int origem, int destino, int n_cartas)
+{
+  assert(n_jogadas < N_MAX_JOGADAS);
+  jogadas[n_jogadas].origem = origem;
+  jogadas[n_jogadas].destino = destino;
+  jogadas[n_jogadas].n_cartas = n_cartas;
+  return n_jogadas + 1;
+}
+
+// acrescenta uma jogada de uma carta para cada destino da máscara, em ordem de índice
+static int adiciona_jogadas_destinos(jogada_t *jogadas, int n_jogadas, int origem, uint16_t destinos)
+{
+  while (destinos != 0) {
+    n_jogadas = adiciona_jogada(jogadas, n_jogadas, origem, __builtin_ctz(destinos), 1);
+    destinos &= destinos - 1;
+  }
+  return n_jogadas;
+}
+
+// gera todas as jogadas válidas, ordenadas por origem e destino
+int gera_jogadas(jogo_t *j, jogada_t *jogadas)
+{
+  int n = 0;
+
+  // monte
+  if (!pilha_vazia(&j->monte))
+    n = adiciona_jogada(jogadas, n, PILHA_MONTE, PILHA_DESCARTE, 1);
+
+  // descarte
+  if (pilha_vazia(&j->monte) && !pilha_vazia(&j->descarte)) {
+    n = adiciona_jogada(jogadas, n, PILHA_DESCARTE, PILHA_MONTE, numero_cartas_pilha(&j->descarte));
+  }
+  if (!pilha_vazia(&j->descarte))
+    n = adiciona_jogadas_destinos(jogadas, n, PILHA_DESCARTE, destinos_carta(j, retorna_carta_topo(&j->descarte)));
+
+  // pilhas de saída
+  for (int i = 0; i < N_PILHAS_SAIDA; i++) {
+    if (pilha_vazia(&j->pilhas_saida[i])) continue;
+    uint16_t destinos = destinos_carta(j, retorna_carta_topo(&j->pilhas_saida[i])) & MASCARA_PRINCIPAIS;
+    n = adiciona_jogadas_destinos(jogadas, n, PILHA_SAIDA + i, destinos);
+  }
+
+  // pilhas principais
+  for (int i = 0; i < N_PILHAS_PRINCIPAIS; i++) {
+    pilha_t *origem = &j->pilhas_principais[i];
+    if (pilha_vazia(origem)) continue;
+    uint16_t destinos = destinos_carta(j, retorna_carta_topo(origem)) & MASCARA_SAIDA;
+    n = adiciona_jogadas_destinos(jogadas, n, PILHA_PRINCIPAL + i, destinos);
+    for (int k = 0; k < N_PILHAS_PRINCIPAIS; k++) {
+      if (k == i) continue;
+      int n_cartas = cartas_a_mover_entre_pilhas(origem, &j->pilhas_principais[k]);
+      if (n_cartas > 0)
+        n = adiciona_jogada(jogadas, n, PILHA_PRINCIPAL + i, PILHA_PRINCIPAL + k, n_cartas);
+    }
+  }
+
+  return n;
+}
+
+// realiza a jogada chamando a respectiva funcao que move as cartas
+bool aplica_jogada(jogo_t *j, jogada_t jg)
+{
+  int origem = jg.origem;
+  int destino = jg.destino;
+
+  if (origem == PILHA_MONTE) {
+    return destino == PILHA_DESCARTE && abre_carta(j);
+  } else if (origem == PILHA_DESCARTE) {
+    if (destino == PILHA_MONTE)
+      return recicla_descarte(j);
+    else if (destino >= PILHA_PRINCIPAL)
+      return move_carta_descarte_para_jogo(j, destino - PILHA_PRINCIPAL);
+    else if (destino >= PILHA_SAIDA)
+      return move_carta_descarte_para_saida(j, destino - PILHA_SAIDA);
+    else
+      return false;
+  } else if (origem < PILHA_PRINCIPAL) {
+    if (destino >= PILHA_PRINCIPAL)
+      return move_carta_saida_para_jogo(j, origem - PILHA_SAIDA, destino - PILHA_PRINCIPAL);
+    else
+      return false;
+  } else {
+    if (destino >= PILHA_PRINCIPAL)
+      return move_cartas_entre_pilhas_jogo_com_qtde(j, origem - PILHA_PRINCIPAL, destino - PILHA_PRINCIPAL, jg.n_cartas);
+    else if (destino >= PILHA_SAIDA)
+      return move_carta_jogo_para_saida(j, origem - PILHA_PRINCIPAL, destino - PILHA_SAIDA);
+    else
+      return false;
+  }
+}
+
+// realiza a jogada, guardando o que for preciso para desfazê-la
+bool faz_jogada(jogo_t *j, jogada_t jg, desfazer_t *d)
+{
+  pilha_t *origem = pilha_do_jogo(j, jg.origem);
+  int n_fechadas = numero_cartas_fechadas_pilha(origem);
+
+  d->pontos = j->pontos;
+  d->bonus_total = j->bonus_total;
+  d->tempo_ultima_jogada = j->tempo_ultima_jogada;
+  if (!aplica_jogada(j, jg))
+    return false;
+  // só as pilhas principais abrem a carta que fica no topo
+  d->abriu_carta = jg.origem >= PILHA_PRINCIPAL && numero_cartas_fechadas_pilha(origem) < n_fechadas;
+  return true;
+}
+
+// desfaz a jogada, devolvendo as cartas para a origem
+void desfaz_jogada(jogo_t *j, jogada_t jg, desfazer_t *d)
+{
+  pilha_t *origem = pilha_do_jogo(j, jg.origem);
+  pilha_t *destino = pilha_do_jogo(j, jg.destino);
+  int n_cartas_origem = numero_cartas_pilha(origem);
+
+  if (jg.origem == PILHA_MONTE) {
+    // a carta volta fechada para o monte, que está todo fechado
+    empilha_carta(origem, remove_carta_topo(destino));
+    fecha_todas_cartas_pilha(origem);
+  } else if (jg.origem == PILHA_DESCARTE && jg.destino == PILHA_MONTE) {
+    // a reciclagem inverteu a ordem das cartas, que voltam abertas ao descarte
+    while (!pilha_vazia(destino))
+      empilha_carta(origem, remove_carta_topo(destino));
+  } else {
+    if (d->abriu_carta) {
+      fecha_todas_cartas_pilha(origem);
+      j->derivados.cartas_fechadas++;
+    }
+    if (jg.destino < PILHA_PRINCIPAL)
+      conta_carta_saida(j, retorna_carta_topo(destino), -1);
+    else if (jg.origem < PILHA_PRINCIPAL && jg.origem >= PILHA_SAIDA)
+      conta_carta_saida(j, retorna_carta_topo(destino), 1);
+    move_cartas_em_ordem(destino, origem, jg.n_cartas);
+  }
+  // as cartas que voltaram e a carta do topo, que pode ter sido fechada de novo
+  pilha_alterada(j, jg.origem, n_cartas_origem - 1);
+  pilha_alterada(j, jg.destino, numero_cartas_pilha(destino));
+
+  j->pontos = d->pontos;
+  j->bonus_total = d->bonus_total;
+  j->tempo_ultima_jogada = d->tempo_ultima_jogada;
+}
+
+// caractere usado no comando de teclado para cada pilha
+static char caractere_pilha(int indice)
+{
+  if (indice == PILHA_MONTE)
+    return 'm';
+  else if (indice == PILHA_DESCARTE)
+    return 'p';
+  else if (indice < PILHA_PRINCIPAL)
+    return 'a' + indice - PILHA_SAIDA;
+  else
+    return '1' + indice - PILHA_PRINCIPAL;
+}
+
+// gera o comando que realiza_jogada entende para uma jogada
+void descricao_jogada(jogada_t jg, char *comando)
+{
+  comando[0] = caractere_pilha(jg.origem);
+  comando[1] = caractere_pilha(jg.destino);
+  comando[2] = '\0';
+}
+
+// dá uma nota para a jogada, quanto maior melhor (0 para jogadas que não interessam)
+static int nota_jogada(jogo_t *j, jogada_t jg, int reciclagens_restantes)
+{
+  if (jg.destino >= PILHA_SAIDA && jg.destino < PILHA_PRINCIPAL) {
+    // mover para a saída é sempre bom, melhor ainda se abrir uma carta
+    if (jg.origem >= PILHA_PRINCIPAL) {
+      pilha_t *p = pilha_do_jogo(j, jg.origem);
+      if (p->n_cartas - 1 == p->n_cartas_fechadas && p->n_cartas_fechadas > 0)
+        return 120;
+    }
+    return 100;
+  }
+
+  if (jg.origem >= PILHA_PRINCIPAL) {
+    if (jg.destino < PILHA_PRINCIPAL) return 0;
+    pilha_t *origem = pilha_do_jogo(j, jg.origem);
+    int restantes = origem->n_cartas - jg.n_cartas;
+    // abre uma carta fechada, preferindo as pilhas com mais cartas fechadas
+    if (restantes == origem->n_cartas_fechadas && restantes > 0)
+      return 80 + origem->n_cartas_fechadas;
+    // esvazia uma pilha, abrindo espaço para um rei
+    if (restantes == 0 && !pilha_vazia(pilha_do_jogo(j, jg.destino)))
+      return 30;
+    return 0;
+  }
+
+  if (jg.origem == PILHA_DESCARTE) {
+    if (jg.destino >= PILHA_PRINCIPAL) {
+      // rei para pilha vazia
+      if (pilha_vazia(pilha_do_jogo(j, jg.destino)))
+        return 60;
+      return 50;
+    }
+    if (jg.destino == PILHA_MONTE && reciclagens_restantes > 0)
+      return 5;
+    return 0;
+  }
+
+  if (jg.origem == PILHA_MONTE)
+    return 10;
+
+  // tirar cartas da saída não é feito pela heurística
+  return 0;
+}
+
+// escolhe a jogada de maior nota, sorteando entre as empatadas
+int escolhe_jogada_gulosa(jogo_t *j, jogada_t *jogadas, int n_jogadas, int reciclagens_restantes, gerador_t *g)
+{
+  int escolhida = -1;
+  int melhor_nota = 0;
+  int n_empatadas = 0;
+
+  for (int i = 0; i < n_jogadas; i++) {
+    int nota = nota_jogada(j, jogadas[i], reciclagens_restantes);
+    if (nota > melhor_nota) {
+      melhor_nota = nota;
+      escolhida = i;
+      n_empatadas = 1;
+    } else if (nota == melhor_nota && nota > 0) {
+      // sorteio uniforme entre as empatadas sem guardar todas
+      n_empatadas++;
+      if (sorteia(g, n_empatadas) == 0)
+        escolhida = i;
+    }
+  }
+
+  return escolhida;
+}
+
+// ordena as jogadas pela nota, da maior para a menor, mantendo a ordem das empatadas
+void ordena_jogadas(jogo_t *j, jogada_t *jogadas, int n_jogadas, int reciclagens_restantes)
+{
+  int notas[N_MAX_JOGADAS];
+  for (int i = 0; i < n_jogadas; i++) {
+    jogada_t jogada = jogadas[i];
+    int nota = nota_jogada(j, jogada, reciclagens_restantes);
+    int k = i;
+    for (; k > 0 && notas[k-1] < nota; k--) {
+      notas[k] = notas[k-1];
+      jogadas[k] = jogadas[k-1];
+    }
+    notas[k] = nota;
+    jogadas[k] = jogada;
+  }
+}
+
+// joga uma partida inteira com a heurística gulosa
+int partida_gulosa(jogo_t *j, int max_jogadas, int max_reciclagens, gerador_t *g)
+{
+  jogada_t jogadas[N_MAX_JOGADAS];
+  int n_realizadas = 0;
+  int n_reciclagens = 0;
+
+  while (n_realizadas < max_jogadas && !venceu_jogo(j)) {
+    int n_jogadas = gera_jogadas(j, jogadas);
+    int i = escolhe_jogada_gulosa(j, jogadas, n_jogadas, max_reciclagens - n_reciclagens, g);
+    if (i < 0) break;
+    if (jogadas[i].origem == PILHA_DESCARTE && jogadas[i].destino == PILHA_MONTE)
+      n_reciclagens++;
+    aplica_jogada(j, jogadas[i]);
+    n_realizadas++;
+  }
+
+  return n_realizadas;
+}
+
+// constantes que diferenciam cada tipo de pilha na chave do jogo
+#define SAL_PILHA 0x632be59bd9b4e019ULL
+#define SAL_SAIDA 0x8cb92ba72f3d8dd7ULL
+#define SAL_PRINCIPAL 0xd6e8feb86659fd93ULL
+
+// chave do jogo, combinando as chaves das pilhas com a posição de cada uma
+uint64_t chave_jogo(jogo_t *j)
+{
+  uint64_t chave = 0;
+  for (int i = 0; i < N_PILHAS; i++)
+    chave ^= espalha_64(pilha_do_jogo(j, i)->chave + SAL_PILHA * (i + 1));
+  return chave;
+}
+
+// chave que não muda com a ordem das pilhas principais nem com a das pilhas de saída
+uint64_t chave_canonica_jogo(jogo_t *j)
+{
+  uint64_t chave = espalha_64(j->monte.chave + SAL_PILHA) ^ espalha_64(j->descarte.chave + 2 * SAL_PILHA);
+
+  // as cartas de saída já ficam na posição do seu valor, basta juntar as pilhas
+  uint64_t saida = 0;
+  for (int i = 0; i < N_PILHAS_SAIDA; i++)
+    saida ^= j->pilhas_saida[i].chave;
+  chave ^= espalha_64(saida + SAL_SAIDA);
+
+  // soma é comutativa, e o espalhamento de cada pilha não deixa as cartas de pilhas diferentes se misturarem
+  uint64_t principais = 0;
+  for (int i = 0; i < N_PILHAS_PRINCIPAIS; i++)
+    principais += espalha_64(j->pilhas_principais[i].chave + SAL_PRINCIPAL);
+  return chave ^ espalha_64(principais);
+}
+
+// confere as chaves incrementais de todas as pilhas recalculando-as do zero
+bool confere_chaves_jogo(jogo_t *j)
+{
+  for (int i = 0; i < N_PILHAS; i++) {
+    pilha_t *p = pilha_do_jogo(j, i);
+    if (p->chave != calcula_chave_pilha(p))
+      return false;
+  }
+  return true;
+}
+
+// sem cartas fechadas, no monte ou no descarte, o jogo está ganho
+bool vitoria_garantida(jogo_t *j)
+{
+  return pilha_vazia(&j->monte) && pilha_vazia(&j->descarte) && j->derivados.cartas_fechadas == 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file reproducao.c
+ *
+ * @brief Reprodução de partidas gravadas, com quadros-chave para ir a qualquer jogada.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "reproducao.h"
+
+// guarda o jogo atual como quadro-chave
+static void guarda_quadro(reproducao_t *r, int indice)
+{
+  compacta_jogo(r->jogo, &r->quadros[indice].estado);
+  r->quadros[indice].pontos = r->jogo->pontos;
+  r->quadros[indice].bonus_total = r->jogo->bonus_total;
+  r->quadros[indice].tempo_ultima_jogada = r->jogo->tempo_ultima_jogada;
+}
+
+// volta o jogo para um quadro-chave
+static void restaura_quadro(reproducao_t *r, int indice)
+{
+  expande_jogo(&r->quadros[indice].estado, r->jogo);
+  r->jogo->pontos = r->quadros[indice].pontos;
+  r->jogo->bonus_total = r->quadros[indice].bonus_total;
+  r->jogo->tempo_ultima_jogada = r->quadros[indice].tempo_ultima_jogada;
+  r->posicao = indice * INTERVALO_QUADROS_CHAVE;
+}
+
+bool inicia_reproducao(reproducao_t *r, jogo_t *inicial, const jogada_t *jogadas, int n_jogadas)
+{
+  r->n_jogadas = n_jogadas;
+  r->n_quadros = n_jogadas / INTERVALO_QUADROS_CHAVE + 1;
+  r->jogadas = malloc((n_jogadas + 1) * sizeof(jogada_t));
+  r->quadros = malloc(r->n_quadros * sizeof(quadro_chave_t));
+  r->jogo = malloc(sizeof(jogo_t));
+  assert(r->jogadas != NULL && r->quadros != NULL && r->jogo != NULL);
+  memcpy(r->jogadas, jogadas, n_jogadas * sizeof(jogada_t));
+
+  // joga a partida uma vez, guardando os quadros-chave pelo caminho
+  *r->jogo = *inicial;
+  r->jogo->relogio = NULL;
+  guarda_quadro(r, 0);
+  jogada_t possiveis[N_MAX_JOGADAS];
+  for (int k = 0; k < n_jogadas; k++) {
+    int n = gera_jogadas(r->jogo, possiveis);
+    int i = 0;
+    while (i < n && (possiveis[i].origem != jogadas[k].origem || possiveis[i].destino != jogadas[k].destino
+                     || possiveis[i].n_cartas != jogadas[k].n_cartas))
+      i++;
+    if (i == n) {
+      termina_reproducao(r);
+      return false;
+    }
+    aplica_jogada(r->jogo, jogadas[k]);
+    if ((k + 1) % INTERVALO_QUADROS_CHAVE == 0)
+      guarda_quadro(r, (k + 1) / INTERVALO_QUADROS_CHAVE);
+  }
+
+  // os campos que não estão no estado compacto (coordenadas, comando, relógio) vêm do jogo inicial
+  *r->jogo = *inicial;
+  r->jogo->relogio = NULL;
+  restaura_quadro(r, 0);
+  return true;
+}
+
+void vai_para_jogada(reproducao_t *r, int posicao)
+{
+  if (posicao < 0) posicao = 0;
+  if (posicao > r->n_jogadas) posicao = r->n_jogadas;
+
+  // só anda a partir da posição atual se ela estiver no mesmo intervalo, antes do destino
+  int quadro = posicao / INTERVALO_QUADROS_CHAVE;
+  if (posicao < r->posicao || r->posicao < quadro * INTERVALO_QUADROS_CHAVE)
+    restaura_quadro(r, quadro);
+  while (r->posicao < posicao)
+    aplica_jogada(r->jogo, r->jogadas[r->posicao++]);
+}
+
+void termina_reproducao(reproducao_t *r)
+{
+  free(r->jogadas);
+  free(r->quadros);
+  free(r->jogo);
+  memset(r, 0, sizeof(*r));
+}
@@ -0,0 +1,72 @@
+#ifndef REPRODUCAO_H
+#define REPRODUCAO_H
+
+/**
+ * @file reproducao.h
+ *
+ * @brief Reprodução de partidas gravadas, com quadros-chave para ir a qualquer jogada.
+ *
+ * A cada INTERVALO_QUADROS_CHAVE jogadas é guardado o estado compacto das pilhas
+ * e a pontuação. Para ir a uma jogada, a reprodução parte do quadro-chave anterior
+ * (ou da posição atual, se estiver no caminho) e aplica no máximo
+ * INTERVALO_QUADROS_CHAVE - 1 jogadas, então andar para trás custa o mesmo que
+ * andar para a frente, em qualquer ponto de uma partida longa.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+
+// jogadas entre dois quadros-chave
+#define INTERVALO_QUADROS_CHAVE 32
+
+// estado guardado a cada INTERVALO_QUADROS_CHAVE jogadas
+typedef struct {
+  jogo_compacto_t estado;
+  // o que o jogo compacto não guarda e entra na pontuação das jogadas seguintes
+  double pontos;
+  double bonus_total;
+  double tempo_ultima_jogada;
+} quadro_chave_t;
+
+// partida em reprodução
+typedef struct {
+  jogada_t *jogadas;
+  int n_jogadas;
+  quadro_chave_t *quadros;
+  int n_quadros;
+  // jogada em que o jogo está: 0 é a distribuição, n_jogadas é o fim da partida
+  int posicao;
+  // o jogo na posição atual, pronto para ser desenhado
+  jogo_t *jogo;
+} reproducao_t;
+
+/**
+ * @brief Prepara a reprodução de uma partida, calculando os quadros-chave.
+ *
+ * As jogadas são copiadas; o jogo inicial não é alterado.
+ *
+ * @param r Ponteiro para a reprodução.
+ * @param inicial Ponteiro para o jogo na distribuição inicial.
+ * @param jogadas As jogadas da partida, em ordem.
+ * @param n_jogadas Número de jogadas.
+ * @return true se todas as jogadas são possíveis, false caso contrário.
+ */
+bool inicia_reproducao(reproducao_t *r, jogo_t *inicial, const jogada_t *jogadas, int n_jogadas);
+
+/**
+ * @brief Leva o jogo da reprodução até depois da jogada dada.
+ *
+ * @param r Ponteiro para a reprodução.
+ * @param posicao Número de jogadas já feitas (limitado a 0..n_jogadas).
+ */
+void vai_para_jogada(reproducao_t *r, int posicao);
+
+/**
+ * @brief Libera a memória da reprodução.
+ *
+ * @param r Ponteiro para a reprodução.
+ */
+void termina_reproducao(reproducao_t *r);
+
+#endif // REPRODUCAO_H
@@ -0,0 +1,205 @@
+/**
+ * @file resolve.c
+ *
+ * @brief Resolve distribuições de klondike sem janela.
+ *
+ * Por padrão usa a busca em feixe: para cada distribuição informa se achou
+ * solução, o número de jogadas, os estados expandidos e os estados por segundo;
+ * no fim mostra um resumo.
+ *
+ * Com -d usa a busca em disco, que é exaustiva: decide se a distribuição tem
+ * solução guardando os estados no diretório dado, e pode ser interrompida e
+ * retomada (basta rodar de novo com o mesmo diretório). Nesse modo também
+ * informa a vazão de leitura e escrita em disco.
+ *
+ * Com -p usa a busca em profundidade exaustiva, com a árvore de uma distribuição
+ * dividida entre as threads dadas; com -e repete a busca com 1, 2, 4, 8 e 16
+ * threads, mostra a eficiência de cada uma e confere se a decisão é a mesma.
+ *
+ * Uso: ./resolve [-n distribuições] [-s semente] [-l largura] [-m MiB] [-t segundos] [-j]
+ *                [-d diretório] [-p threads] [-e] [-r reciclagens]
+ *   -j mostra as jogadas de cada solução como comandos de texto.
+ *   -r limita as reciclagens do descarte nas buscas exaustivas (negativo para não limitar).
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "resolvedor.h"
+#include <unistd.h>
+
+// mostra as jogadas de uma solução como comandos de texto
+static void mostra_solucao(resultado_busca_t *res)
+{
+  char comando[MAX_CHAR_CMD+1];
+  for (int k = 0; k < res->n_jogadas; k++) {
+    descricao_jogada(res->jogadas[k], comando);
+    printf("%s%c", comando, (k + 1) % 20 == 0 || k + 1 == res->n_jogadas ? '\n' : ' ');
+  }
+}
+
+// decide uma distribuição com a busca em disco e mostra as estatísticas
+static bool resolve_em_disco(jogo_t *j, parametros_disco_t *par, resultado_busca_t *res, bool mostra_jogadas)
+{
+  estatisticas_disco_t est;
+  busca_em_disco(j, par, res, &est);
+  const char *situacao = res->resolvido ? "resolvida" : est.decidida ? "sem solução" : "interrompida";
+  double mib_lidos = est.bytes_lidos / (1024.0 * 1024.0);
+  double mib_escritos = est.bytes_escritos / (1024.0 * 1024.0);
+
+  printf("situação:          %s%s\n", situacao, est.retomada ? " (retomada)" : "");
+  if (res->resolvido)
+    printf("jogadas:           %d\n", res->n_jogadas);
+  printf("profundidade:      %d\n", est.profundidade);
+  printf("estados:           %ld expandidos, %ld gerados\n", res->estados_expandidos, est.estados_gerados);
+  printf("corridas:          %ld\n", est.corridas);
+  printf("disco:             %.1f MiB lidos, %.1f MiB escritos\n", mib_lidos, mib_escritos);
+  printf("tempo:             %.3f s\n", res->tempo);
+  if (res->tempo > 0) {
+    printf("E/S:               %.1f MiB/s\n", (mib_lidos + mib_escritos) / res->tempo);
+    printf("estados/s:         %.0f\n", res->estados_expandidos / res->tempo);
+  }
+  if (mostra_jogadas && res->resolvido)
+    mostra_solucao(res);
+  return res->resolvido;
+}
+
+// decide uma distribuição com a busca em profundidade e mostra as estatísticas
+static bool resolve_em_profundidade(jogo_t *j, parametros_profundidade_t *par, resultado_busca_t *res, bool mostra_jogadas)
+{
+  estatisticas_profundidade_t est;
+  busca_em_profundidade(j, par, res, &est);
+  const char *situacao = res->resolvido ? "resolvida" : est.decidida ? "sem solução" : "interrompida";
+
+  printf("situação:          %s%s\n", situacao, est.incompleta && !res->resolvido ? " (ramos cortados)" : "");
+  if (res->resolvido)
+    printf("jogadas:           %d\n", res->n_jogadas);
+  printf("threads:           %d (%ld roubos)\n", par->n_threads, est.roubos);
+  printf("estados:           %ld\n", res->estados_expandidos);
+  printf("tempo:             %.3f s\n", res->tempo);
+  if (res->tempo > 0)
+    printf("estados/s:         %.0f\n", res->estados_expandidos / res->tempo);
+  if (mostra_jogadas && res->resolvido)
+    mostra_solucao(res);
+  return res->resolvido;
+}
+
+// repete a busca em profundidade com 1, 2, 4, 8 e 16 threads e mostra a eficiência
+static void mede_escalabilidade(jogo_t *j, parametros_profundidade_t *par, resultado_busca_t *res)
+{
+  estatisticas_profundidade_t est;
+  double tempo_1 = 0;
+  bool resolvida_1 = false, decidida_1 = false;
+  long estados_1 = 0;
+
+  printf("threads   tempo (s)   estados/s   aceleração  eficiência  resultado\n");
+  for (int n = 1; n <= 16; n *= 2) {
+    par->n_threads = n;
+    busca_em_profundidade(j, par, res, &est);
+    if (n == 1) {
+      tempo_1 = res->tempo;
+      resolvida_1 = res->resolvido;
+      decidida_1 = est.decidida;
+      estados_1 = res->estados_expandidos;
+    }
+    // sem solução, todos os estados alcançáveis são visitados: a contagem também tem que bater
+    bool igual = res->resolvido == resolvida_1 && est.decidida == decidida_1
+              && (res->resolvido || !est.decidida || res->estados_expandidos == estados_1);
+    printf("%7d %11.3f %11.0f %11.2fx %10.0f%%  %s%s\n", n, res->tempo,
+           res->estados_expandidos / res->tempo, tempo_1 / res->tempo,
+           100 * tempo_1 / res->tempo / n,
+           res->resolvido ? "resolvida" : est.decidida ? "sem solução" : "interrompida",
+           igual ? "" : " (DIFERENTE)");
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int n_distribuicoes = 10;
+  uint64_t semente = 1;
+  bool mostra_jogadas = false;
+  parametros_feixe_t par;
+  parametros_feixe_padrao(&par);
+  parametros_disco_t par_disco;
+  parametros_disco_padrao(&par_disco, NULL);
+  parametros_profundidade_t par_prof;
+  parametros_profundidade_padrao(&par_prof);
+  bool profundidade = false, escalabilidade = false;
+  int opcao;
+
+  while ((opcao = getopt(argc, argv, "n:s:l:m:t:jd:p:er:")) != -1) {
+    switch (opcao) {
+      case 'n': n_distribuicoes = atoi(optarg); break;
+      case 's': semente = strtoull(optarg, NULL, 10); break;
+      case 'l': par.largura = atoi(optarg); break;
+      case 'm': par.limite_memoria = par_disco.limite_memoria = par_prof.limite_memoria = (size_t)atol(optarg) << 20; break;
+      case 't': par.limite_tempo = par_disco.limite_tempo = par_prof.limite_tempo = atof(optarg); break;
+      case 'j': mostra_jogadas = true; break;
+      case 'd': par_disco.diretorio = optarg; break;
+      case 'p': profundidade = true; par_prof.n_threads = atoi(optarg); break;
+      case 'e': escalabilidade = true; break;
+      case 'r': par_disco.max_reciclagens = par_prof.max_reciclagens = atoi(optarg); break;
+      default:
+        fprintf(stderr, "uso: %s [-n distribuições] [-s semente] [-l largura] [-m MiB] [-t segundos] [-j] [-d diretório] [-p threads] [-e] [-r reciclagens]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  jogo_t *j = malloc(sizeof(jogo_t));
+  resultado_busca_t *res = malloc(sizeof(resultado_busca_t));
+  assert(j != NULL && res != NULL);
+  j->relogio = NULL;
+
+  if (par_disco.diretorio != NULL) {
+    // a busca em disco decide uma distribuição por vez
+    inicia_pilhas_jogo_com_semente(j, semente);
+    bool resolvida = resolve_em_disco(j, &par_disco, res, mostra_jogadas);
+    free(res);
+    free(j);
+    return resolvida ? 0 : 2;
+  }
+
+  if (profundidade || escalabilidade) {
+    // a busca em profundidade também decide uma distribuição por vez
+    inicia_pilhas_jogo_com_semente(j, semente);
+    bool resolvida = false;
+    if (escalabilidade)
+      mede_escalabilidade(j, &par_prof, res);
+    else
+      resolvida = resolve_em_profundidade(j, &par_prof, res, mostra_jogadas);
+    free(res);
+    free(j);
+    return resolvida || escalabilidade ? 0 : 2;
+  }
+
+  int resolvidas = 0;
+  long total_jogadas = 0;
+  long total_estados = 0;
+  double total_tempo = 0;
+
+  for (int i = 0; i < n_distribuicoes; i++) {
+    inicia_pilhas_jogo_com_semente(j, semente + i);
+    busca_em_feixe(j, &par, res);
+    total_estados += res->estados_expandidos;
+    total_tempo += res->tempo;
+    if (res->resolvido) {
+      resolvidas++;
+      total_jogadas += res->n_jogadas;
+    }
+    printf("semente %-8llu %-13s jogadas %4d  estados %9ld  %7.3f s  %9.0f estados/s\n",
+           (unsigned long long)(semente + i), res->resolvido ? "resolvida" : "não resolvida",
+           res->n_jogadas, res->estados_expandidos, res->tempo,
+           res->tempo > 0 ? res->estados_expandidos / res->tempo : 0);
+    if (mostra_jogadas && res->resolvido)
+      mostra_solucao(res);
+  }
+
+  printf("resolvidas:        %d de %d (%.2f%%)\n", resolvidas, n_distribuicoes, 100.0 * resolvidas / n_distribuicoes);
+  if (resolvidas > 0)
+    printf("jogadas/solução:   %.1f\n", (double)total_jogadas / resolvidas);
+  printf("tempo:             %.3f s\n", total_tempo);
+  printf("estados/s:         %.0f\n", total_tempo > 0 ? total_estados / total_tempo : 0);
+
+  free(res);
+  free(j);
+  return 0;
+}
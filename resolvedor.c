@@ -0,0 +1,1207 @@
+/**
+ * @file resolvedor.c
+ *
+ * @brief Resolvedores do jogo klondike.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "resolvedor.h"
+#include <sys/stat.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+// jogada que levou a um estado, e o índice do passo que levou ao estado anterior
+typedef struct {
+  uint32_t pai;
+  jogada_t jogada;
+} passo_t;
+
+// estado guardado no feixe
+typedef struct {
+  jogo_compacto_t estado;
+  // chave canônica do estado, marcada nos visitados enquanto ele está no feixe ou nos candidatos
+  uint64_t chave;
+  int32_t avaliacao;
+  uint32_t pai;
+  jogada_t jogada;
+  uint8_t reciclagens;
+} no_feixe_t;
+
+// o passo da raiz não tem pai
+#define SEM_PAI UINT32_MAX
+
+// memória e contadores de uma busca em feixe
+typedef struct {
+  no_feixe_t *feixe;
+  int n_feixe;
+  // os melhores candidatos da próxima profundidade, em um heap com o pior no topo
+  no_feixe_t *candidatos;
+  int n_candidatos;
+  int largura;
+  uint64_t *visitados;
+  long capacidade_visitados;
+  long n_visitados;
+  passo_t *passos;
+  long capacidade_passos;
+  long n_passos;
+} busca_feixe_t;
+
+// relógio monotônico, em segundos
+static double agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// quanto maior, melhor o estado
+int avalia_estado(jogo_t *j, int reciclagens)
+{
+  derivados_t *d = &j->derivados;
+  int vazias = __builtin_popcount(d->pilhas_vazias & MASCARA_PRINCIPAIS);
+  int no_monte = numero_cartas_pilha(&j->monte) + numero_cartas_pilha(&j->descarte);
+  return 100 * d->cartas_saida - 60 * d->cartas_fechadas + 20 * vazias - 5 * no_monte - 30 * reciclagens;
+}
+
+void parametros_feixe_padrao(parametros_feixe_t *par)
+{
+  par->largura = 2000;
+  par->limite_memoria = 64 << 20;
+  par->limite_tempo = 5.0;
+  par->parar = NULL;
+}
+
+// marca a chave como visitada; retorna false se já estava marcada.
+// com o conjunto cheio, deixa de marcar e aceita tudo
+static bool marca_visitado(busca_feixe_t *b, uint64_t chave)
+{
+  if (chave == 0) chave = 1; // zero marca posição livre
+  long mascara = b->capacidade_visitados - 1;
+  long i = chave & mascara;
+  while (b->visitados[i] != 0) {
+    if (b->visitados[i] == chave) return false;
+    i = (i + 1) & mascara;
+  }
+  // mantém o conjunto no máximo 3/4 cheio
+  if (4 * (b->n_visitados + 1) > 3 * b->capacidade_visitados) return true;
+  b->visitados[i] = chave;
+  b->n_visitados++;
+  return true;
+}
+
+// tira a chave dos visitados, se estiver lá; as chaves seguintes da mesma sequência
+// voltam para o buraco, para as buscas por elas não pararem antes de achá-las
+static void desmarca_visitado(busca_feixe_t *b, uint64_t chave)
+{
+  if (chave == 0) chave = 1;
+  long mascara = b->capacidade_visitados - 1;
+  long i = chave & mascara;
+  while (b->visitados[i] != chave) {
+    if (b->visitados[i] == 0) return;
+    i = (i + 1) & mascara;
+  }
+  long k = i;
+  while (true) {
+    k = (k + 1) & mascara;
+    if (b->visitados[k] == 0) break;
+    // a chave em k fica onde está se a sua posição de origem está entre o buraco e k
+    long origem = b->visitados[k] & mascara;
+    bool fica = i <= k ? (i < origem && origem <= k) : (i < origem || origem <= k);
+    if (fica) continue;
+    b->visitados[i] = b->visitados[k];
+    i = k;
+  }
+  b->visitados[i] = 0;
+  b->n_visitados--;
+}
+
+// troca dois nós do heap
+static void troca_nos(no_feixe_t *a, no_feixe_t *b)
+{
+  no_feixe_t temp = *a;
+  *a = *b;
+  *b = temp;
+}
+
+// desce um nó do heap até a posição correta
+static void desce_no(no_feixe_t *heap, int n, int i)
+{
+  while (true) {
+    int menor = i;
+    int esq = 2 * i + 1, dir = 2 * i + 2;
+    if (esq < n && heap[esq].avaliacao < heap[menor].avaliacao) menor = esq;
+    if (dir < n && heap[dir].avaliacao < heap[menor].avaliacao) menor = dir;
+    if (menor == i) return;
+    troca_nos(&heap[i], &heap[menor]);
+    i = menor;
+  }
+}
+
+// indica se um candidato com essa avaliação entraria no heap
+static bool cabe_no_heap(busca_feixe_t *b, int avaliacao)
+{
+  return b->n_candidatos < b->largura || avaliacao > b->candidatos[0].avaliacao;
+}
+
+// coloca um candidato no heap, tirando o pior se estiver cheio; o que sai deixa de
+// ser visitado, para poder voltar se for alcançado de novo por outro caminho
+static void insere_candidato(busca_feixe_t *b, no_feixe_t *no)
+{
+  if (b->n_candidatos < b->largura) {
+    int i = b->n_candidatos++;
+    b->candidatos[i] = *no;
+    while (i > 0 && b->candidatos[(i - 1) / 2].avaliacao > b->candidatos[i].avaliacao) {
+      troca_nos(&b->candidatos[i], &b->candidatos[(i - 1) / 2]);
+      i = (i - 1) / 2;
+    }
+  } else {
+    desmarca_visitado(b, b->candidatos[0].chave);
+    b->candidatos[0] = *no;
+    desce_no(b->candidatos, b->n_candidatos, 0);
+  }
+}
+
+// escreve no resultado a linha que termina no passo dado
+static void reconstroi_linha(busca_feixe_t *b, uint32_t passo, resultado_busca_t *res)
+{
+  int n = 0;
+  for (uint32_t p = passo; p != SEM_PAI && b->passos[p].pai != SEM_PAI; p = b->passos[p].pai)
+    n++;
+  res->n_jogadas = n;
+  for (uint32_t p = passo; n > 0; p = b->passos[p].pai)
+    res->jogadas[--n] = b->passos[p].jogada;
+}
+
+// leva todas as cartas para as pilhas de saída; sempre há uma carta de topo que pode ir
+void completa_vitoria(jogo_t *j, resultado_busca_t *res)
+{
+  jogada_t jogadas[N_MAX_JOGADAS];
+  while (!venceu_jogo(j) && res->n_jogadas < MAX_JOGADAS_SOLUCAO) {
+    int n_jogadas = gera_jogadas(j, jogadas);
+    int i;
+    for (i = 0; i < n_jogadas; i++) {
+      if (jogadas[i].destino >= PILHA_SAIDA && jogadas[i].destino < PILHA_PRINCIPAL)
+        break;
+    }
+    assert(i < n_jogadas);
+    aplica_jogada(j, jogadas[i]);
+    res->jogadas[res->n_jogadas++] = jogadas[i];
+  }
+}
+
+// reparte a memória permitida entre o feixe, os visitados e o histórico
+static bool reserva_busca(busca_feixe_t *b, parametros_feixe_t *par)
+{
+  memset(b, 0, sizeof(*b));
+  size_t limite = par->limite_memoria;
+
+  // o feixe atual e os candidatos usam no máximo metade da memória
+  b->largura = par->largura;
+  if (2 * b->largura * sizeof(no_feixe_t) > limite / 2)
+    b->largura = limite / 4 / sizeof(no_feixe_t);
+  if (b->largura < 1) return false;
+  size_t resto = limite - 2 * b->largura * sizeof(no_feixe_t);
+
+  // um quarto do resto para os visitados (potência de 2), o que sobrar para o histórico
+  b->capacidade_visitados = 1;
+  while (b->capacidade_visitados * 2 * sizeof(uint64_t) <= resto / 4)
+    b->capacidade_visitados *= 2;
+  resto -= b->capacidade_visitados * sizeof(uint64_t);
+  b->capacidade_passos = resto / sizeof(passo_t);
+  if (b->capacidade_passos > SEM_PAI) b->capacidade_passos = SEM_PAI;
+
+  b->feixe = malloc(b->largura * sizeof(no_feixe_t));
+  b->candidatos = malloc(b->largura * sizeof(no_feixe_t));
+  b->visitados = calloc(b->capacidade_visitados, sizeof(uint64_t));
+  b->passos = malloc(b->capacidade_passos * sizeof(passo_t));
+  return b->feixe != NULL && b->candidatos != NULL && b->visitados != NULL && b->passos != NULL;
+}
+
+static void libera_busca(busca_feixe_t *b)
+{
+  free(b->feixe);
+  free(b->candidatos);
+  free(b->visitados);
+  free(b->passos);
+}
+
+// busca em feixe, profundidade por profundidade
+bool busca_em_feixe(jogo_t *j, parametros_feixe_t *par, resultado_busca_t *res)
+{
+  double inicio = agora();
+  busca_feixe_t b;
+  res->resolvido = false;
+  res->n_jogadas = 0;
+  res->estados_expandidos = 0;
+
+  jogo_t *atual = malloc(sizeof(jogo_t));
+  assert(atual != NULL);
+  *atual = *j;
+  atual->relogio = NULL;
+  res->avaliacao = avalia_estado(atual, 0);
+
+  if (!reserva_busca(&b, par)) {
+    libera_busca(&b);
+    free(atual);
+    res->tempo = agora() - inicio;
+    return false;
+  }
+
+  // a raiz
+  b.passos[0].pai = SEM_PAI;
+  b.n_passos = 1;
+  compacta_jogo(atual, &b.feixe[0].estado);
+  b.feixe[0].reciclagens = 0;
+  b.feixe[0].avaliacao = res->avaliacao;
+  b.feixe[0].pai = 0;
+  b.feixe[0].chave = chave_canonica_jogo(atual);
+  b.n_feixe = 1;
+  marca_visitado(&b, b.feixe[0].chave);
+  bool terminou = vitoria_garantida(atual);
+  uint32_t passo_solucao = 0;
+
+  for (int profundidade = 0; !terminou && b.n_feixe > 0 && profundidade < MAX_JOGADAS_SOLUCAO; profundidade++) {
+    b.n_candidatos = 0;
+    bool interrompida = false;
+
+    for (int k = 0; k < b.n_feixe && !terminou; k++) {
+      if ((par->parar != NULL && *par->parar) || agora() - inicio > par->limite_tempo) {
+        interrompida = true;
+        break;
+      }
+      no_feixe_t *no = &b.feixe[k];
+      expande_jogo(&no->estado, atual);
+      res->estados_expandidos++;
+
+      jogada_t jogadas[N_MAX_JOGADAS];
+      int n_jogadas = gera_jogadas(atual, jogadas);
+      for (int i = 0; i < n_jogadas; i++) {
+        bool recicla = jogadas[i].origem == PILHA_DESCARTE && jogadas[i].destino == PILHA_MONTE;
+        int reciclagens = no->reciclagens + recicla;
+        if (reciclagens > MAX_RECICLAGENS_BUSCA) continue;
+
+        desfazer_t d;
+        faz_jogada(atual, jogadas[i], &d);
+        int avaliacao = avalia_estado(atual, reciclagens);
+        if (vitoria_garantida(atual) && b.n_passos < b.capacidade_passos) {
+          // achou: guarda o passo e termina
+          b.passos[b.n_passos].pai = no->pai;
+          b.passos[b.n_passos].jogada = jogadas[i];
+          passo_solucao = b.n_passos++;
+          terminou = true;
+          desfaz_jogada(atual, jogadas[i], &d);
+          break;
+        }
+        uint64_t chave = chave_canonica_jogo(atual);
+        if (cabe_no_heap(&b, avaliacao) && marca_visitado(&b, chave)) {
+          no_feixe_t candidato;
+          compacta_jogo(atual, &candidato.estado);
+          candidato.chave = chave;
+          candidato.avaliacao = avaliacao;
+          candidato.pai = no->pai;
+          candidato.jogada = jogadas[i];
+          candidato.reciclagens = reciclagens;
+          insere_candidato(&b, &candidato);
+        }
+        desfaz_jogada(atual, jogadas[i], &d);
+      }
+    }
+    if (terminou || interrompida) break;
+
+    // os candidatos viram o novo feixe, cada um com seu passo no histórico
+    if (b.n_passos + b.n_candidatos > b.capacidade_passos) break;
+    int melhor = -1;
+    for (int k = 0; k < b.n_candidatos; k++) {
+      no_feixe_t *no = &b.candidatos[k];
+      b.passos[b.n_passos].pai = no->pai;
+      b.passos[b.n_passos].jogada = no->jogada;
+      no->pai = b.n_passos++;
+      if (melhor < 0 || no->avaliacao > b.candidatos[melhor].avaliacao)
+        melhor = k;
+    }
+    no_feixe_t *temp = b.feixe;
+    b.feixe = b.candidatos;
+    b.candidatos = temp;
+    b.n_feixe = b.n_candidatos;
+
+    // guarda a melhor linha até aqui, para poder parar a qualquer momento
+    if (melhor >= 0 && b.feixe[melhor].avaliacao > res->avaliacao) {
+      res->avaliacao = b.feixe[melhor].avaliacao;
+      reconstroi_linha(&b, b.feixe[melhor].pai, res);
+    }
+  }
+
+  if (terminou) {
+    reconstroi_linha(&b, passo_solucao, res);
+    // refaz a linha e leva as cartas restantes para a saída
+    *atual = *j;
+    atual->relogio = NULL;
+    for (int i = 0; i < res->n_jogadas; i++)
+      aplica_jogada(atual, res->jogadas[i]);
+    completa_vitoria(atual, res);
+    res->resolvido = venceu_jogo(atual);
+    res->avaliacao = avalia_estado(atual, 0);
+  }
+
+  libera_busca(&b);
+  free(atual);
+  res->tempo = agora() - inicio;
+  return res->resolvido;
+}
+
+// estado guardado nos arquivos da busca em disco
+typedef struct {
+  uint64_t chave;
+  uint64_t chave_pai;
+  jogo_compacto_t estado;
+  jogada_t jogada;
+  uint8_t reciclagens;
+} registro_disco_t;
+
+// ponto de retomada, gravado depois de cada camada
+typedef struct {
+  uint32_t marca;
+  jogo_compacto_t raiz;
+  int32_t max_reciclagens;
+  int32_t profundidade;
+} ponto_disco_t;
+
+#define MARCA_PONTO_DISCO 0x4b4c4431
+// máximo de corridas intercaladas de uma vez; acima disso a intercalação é feita em passadas
+#define MAX_CORRIDAS_INTERCALACAO 64
+#define SAL_RECICLAGENS 0x9fb21c651e98df25ULL
+
+// leitor de um arquivo de registros na intercalação
+typedef struct {
+  FILE *arq;
+  registro_disco_t atual;
+} leitor_disco_t;
+
+// estado de uma busca em disco
+typedef struct {
+  parametros_disco_t *par;
+  estatisticas_disco_t *est;
+  registro_disco_t *buffer;
+  long capacidade_buffer;
+  long n_buffer;
+  int n_corridas;
+  int proxima_corrida;
+} busca_disco_t;
+
+void parametros_disco_padrao(parametros_disco_t *par, const char *diretorio)
+{
+  par->diretorio = diretorio;
+  par->limite_memoria = 256 << 20;
+  par->limite_tempo = 3600;
+  par->max_reciclagens = 3;
+  par->parar = NULL;
+}
+
+// chave do estado; com reciclagens limitadas, o mesmo jogo com reciclagens diferentes é outro estado
+static uint64_t chave_disco(jogo_t *j, int reciclagens, int max_reciclagens)
+{
+  uint64_t chave = chave_canonica_jogo(j);
+  if (max_reciclagens >= 0)
+    chave ^= espalha_64(SAL_RECICLAGENS + reciclagens);
+  return chave;
+}
+
+// monta o nome de um arquivo da busca
+static void nome_arquivo(busca_disco_t *b, char *nome, const char *tipo, int numero)
+{
+  snprintf(nome, 512, "%s/%s_%06d.bin", b->par->diretorio, tipo, numero);
+}
+
+static FILE *abre_arquivo(busca_disco_t *b, const char *tipo, int numero, const char *modo)
+{
+  char nome[512];
+  nome_arquivo(b, nome, tipo, numero);
+  FILE *arq = fopen(nome, modo);
+  if (arq != NULL) setvbuf(arq, NULL, _IOFBF, 1 << 16);
+  return arq;
+}
+
+static void remove_arquivo(busca_disco_t *b, const char *tipo, int numero)
+{
+  char nome[512];
+  nome_arquivo(b, nome, tipo, numero);
+  remove(nome);
+}
+
+// lê um bloco de um arquivo, contando os bytes; retorna false no fim do arquivo
+static bool le_disco(busca_disco_t *b, void *dados, size_t tamanho, FILE *arq)
+{
+  if (fread(dados, tamanho, 1, arq) != 1) return false;
+  b->est->bytes_lidos += tamanho;
+  return true;
+}
+
+static bool escreve_disco(busca_disco_t *b, const void *dados, size_t tamanho, FILE *arq)
+{
+  if (fwrite(dados, tamanho, 1, arq) != 1) return false;
+  b->est->bytes_escritos += tamanho;
+  return true;
+}
+
+static int compara_registros(const void *a, const void *b)
+{
+  uint64_t ca = ((const registro_disco_t *)a)->chave;
+  uint64_t cb = ((const registro_disco_t *)b)->chave;
+  return (ca > cb) - (ca < cb);
+}
+
+// ordena o buffer e grava uma corrida sem chaves repetidas
+static bool grava_corrida(busca_disco_t *b)
+{
+  if (b->n_buffer == 0) return true;
+  qsort(b->buffer, b->n_buffer, sizeof(registro_disco_t), compara_registros);
+  FILE *arq = abre_arquivo(b, "corrida", b->proxima_corrida, "wb");
+  if (arq == NULL) return false;
+  bool ok = true;
+  for (long i = 0; i < b->n_buffer && ok; i++) {
+    if (i > 0 && b->buffer[i].chave == b->buffer[i-1].chave) continue;
+    ok = escreve_disco(b, &b->buffer[i], sizeof(registro_disco_t), arq);
+  }
+  ok = (fclose(arq) == 0) && ok;
+  b->proxima_corrida++;
+  b->n_corridas++;
+  b->est->corridas++;
+  b->n_buffer = 0;
+  return ok;
+}
+
+// desce um leitor no heap da intercalação (menor chave no topo)
+static void desce_leitor(leitor_disco_t *heap, int n, int i)
+{
+  while (true) {
+    int menor = i;
+    int esq = 2 * i + 1, dir = 2 * i + 2;
+    if (esq < n && heap[esq].atual.chave < heap[menor].atual.chave) menor = esq;
+    if (dir < n && heap[dir].atual.chave < heap[menor].atual.chave) menor = dir;
+    if (menor == i) return;
+    leitor_disco_t temp = heap[i];
+    heap[i] = heap[menor];
+    heap[menor] = temp;
+    i = menor;
+  }
+}
+
+// intercala as corridas [primeira, primeira+n) em saida, sem chaves repetidas.
+// se visitados não for NULL, descarta também as chaves visitadas e grava em novos_visitados
+// a união dos visitados com as chaves que saíram; retorna o número de registros gravados ou -1
+static long intercala_corridas(busca_disco_t *b, int primeira, int n, FILE *saida, FILE *visitados, FILE *novos_visitados)
+{
+  leitor_disco_t *heap = malloc(n * sizeof(leitor_disco_t));
+  if (heap == NULL) return -1;
+  int n_heap = 0;
+  for (int i = 0; i < n; i++) {
+    FILE *arq = abre_arquivo(b, "corrida", primeira + i, "rb");
+    if (arq == NULL) continue;
+    heap[n_heap].arq = arq;
+    if (le_disco(b, &heap[n_heap].atual, sizeof(registro_disco_t), arq))
+      n_heap++;
+    else
+      fclose(arq);
+  }
+  for (int i = n_heap / 2 - 1; i >= 0; i--)
+    desce_leitor(heap, n_heap, i);
+
+  uint64_t visitado = 0;
+  bool tem_visitado = visitados != NULL && le_disco(b, &visitado, sizeof(visitado), visitados);
+  bool primeiro = true;
+  uint64_t ultima = 0;
+  long gravados = 0;
+  bool ok = true;
+
+  while (n_heap > 0 && ok) {
+    registro_disco_t reg = heap[0].atual;
+    if (!le_disco(b, &heap[0].atual, sizeof(registro_disco_t), heap[0].arq)) {
+      fclose(heap[0].arq);
+      heap[0] = heap[--n_heap];
+    }
+    desce_leitor(heap, n_heap, 0);
+
+    if (!primeiro && reg.chave == ultima) continue;
+    primeiro = false;
+    ultima = reg.chave;
+
+    if (visitados != NULL) {
+      while (tem_visitado && visitado < reg.chave && ok) {
+        ok = escreve_disco(b, &visitado, sizeof(visitado), novos_visitados);
+        tem_visitado = le_disco(b, &visitado, sizeof(visitado), visitados);
+      }
+      if (tem_visitado && visitado == reg.chave) continue;
+      ok = ok && escreve_disco(b, &reg.chave, sizeof(reg.chave), novos_visitados);
+    }
+    ok = ok && escreve_disco(b, &reg, sizeof(reg), saida);
+    gravados++;
+  }
+  while (visitados != NULL && tem_visitado && ok) {
+    ok = escreve_disco(b, &visitado, sizeof(visitado), novos_visitados);
+    tem_visitado = le_disco(b, &visitado, sizeof(visitado), visitados);
+  }
+
+  for (int i = 0; i < n_heap; i++)
+    fclose(heap[i].arq);
+  free(heap);
+  for (int i = 0; i < n; i++)
+    remove_arquivo(b, "corrida", primeira + i);
+  return ok ? gravados : -1;
+}
+
+// junta as corridas em passadas até sobrarem no máximo MAX_CORRIDAS_INTERCALACAO
+static bool reduz_corridas(busca_disco_t *b)
+{
+  while (b->n_corridas > MAX_CORRIDAS_INTERCALACAO) {
+    int primeira = b->proxima_corrida - b->n_corridas;
+    int restantes = b->n_corridas;
+    b->n_corridas = 0;
+    while (restantes > 0) {
+      int n = restantes < MAX_CORRIDAS_INTERCALACAO ? restantes : MAX_CORRIDAS_INTERCALACAO;
+      FILE *saida = abre_arquivo(b, "corrida", b->proxima_corrida, "wb");
+      if (saida == NULL) return false;
+      long gravados = intercala_corridas(b, primeira, n, saida, NULL, NULL);
+      if (fclose(saida) != 0 || gravados < 0) return false;
+      b->proxima_corrida++;
+      b->n_corridas++;
+      primeira += n;
+      restantes -= n;
+    }
+  }
+  return true;
+}
+
+// procura por busca binária o registro com a chave dada em uma camada
+static bool procura_registro(busca_disco_t *b, int camada, uint64_t chave, registro_disco_t *reg)
+{
+  FILE *arq = abre_arquivo(b, "camada", camada, "rb");
+  if (arq == NULL) return false;
+  fseek(arq, 0, SEEK_END);
+  long ini = 0, fim = ftell(arq) / sizeof(registro_disco_t);
+  bool achou = false;
+  while (ini < fim && !achou) {
+    long meio = (ini + fim) / 2;
+    fseek(arq, meio * sizeof(registro_disco_t), SEEK_SET);
+    if (!le_disco(b, reg, sizeof(registro_disco_t), arq)) break;
+    if (reg->chave == chave) achou = true;
+    else if (reg->chave < chave) ini = meio + 1;
+    else fim = meio;
+  }
+  fclose(arq);
+  return achou;
+}
+
+// refaz a linha da raiz até o estado pai, seguindo as chaves dos pais pelas camadas
+static bool reconstroi_linha_disco(busca_disco_t *b, int camada, registro_disco_t *pai, jogada_t ultima, resultado_busca_t *res)
+{
+  int n = camada + 1;
+  if (n > MAX_JOGADAS_SOLUCAO) return false;
+  res->n_jogadas = n;
+  res->jogadas[--n] = ultima;
+  registro_disco_t reg = *pai;
+  for (int c = camada; c > 0; c--) {
+    res->jogadas[--n] = reg.jogada;
+    if (!procura_registro(b, c - 1, reg.chave_pai, &reg)) return false;
+  }
+  return true;
+}
+
+// grava o ponto de retomada em um arquivo temporário e troca pelo anterior
+static bool grava_ponto(busca_disco_t *b, ponto_disco_t *ponto)
+{
+  char nome[512], temporario[512];
+  snprintf(nome, sizeof(nome), "%s/ponto.bin", b->par->diretorio);
+  snprintf(temporario, sizeof(temporario), "%s/ponto.tmp", b->par->diretorio);
+  FILE *arq = fopen(temporario, "wb");
+  if (arq == NULL) return false;
+  bool ok = fwrite(ponto, sizeof(*ponto), 1, arq) == 1;
+  ok = (fclose(arq) == 0) && ok;
+  return ok && rename(temporario, nome) == 0;
+}
+
+// lê o ponto de retomada, se for da mesma distribuição e com os mesmos parâmetros
+static bool le_ponto(busca_disco_t *b, ponto_disco_t *ponto, jogo_compacto_t *raiz)
+{
+  char nome[512];
+  snprintf(nome, sizeof(nome), "%s/ponto.bin", b->par->diretorio);
+  FILE *arq = fopen(nome, "rb");
+  if (arq == NULL) return false;
+  bool ok = fread(ponto, sizeof(*ponto), 1, arq) == 1;
+  fclose(arq);
+  return ok && ponto->marca == MARCA_PONTO_DISCO
+      && memcmp(&ponto->raiz, raiz, sizeof(*raiz)) == 0
+      && ponto->max_reciclagens == b->par->max_reciclagens;
+}
+
+// grava a camada 0 (só a raiz) e os primeiros visitados
+static bool inicia_camadas(busca_disco_t *b, jogo_t *j, ponto_disco_t *ponto)
+{
+  registro_disco_t raiz;
+  memset(&raiz, 0, sizeof(raiz));
+  raiz.chave = chave_disco(j, 0, b->par->max_reciclagens);
+  compacta_jogo(j, &raiz.estado);
+  FILE *camada = abre_arquivo(b, "camada", 0, "wb");
+  FILE *visitados = abre_arquivo(b, "visitados", 0, "wb");
+  bool ok = camada != NULL && visitados != NULL
+         && escreve_disco(b, &raiz, sizeof(raiz), camada)
+         && escreve_disco(b, &raiz.chave, sizeof(raiz.chave), visitados);
+  if (camada != NULL) ok = (fclose(camada) == 0) && ok;
+  if (visitados != NULL) ok = (fclose(visitados) == 0) && ok;
+  return ok && grava_ponto(b, ponto);
+}
+
+// apaga os arquivos de uma busca que terminou
+static void limpa_diretorio(busca_disco_t *b, int ultima_camada)
+{
+  char nome[512];
+  for (int i = 0; i <= ultima_camada; i++) {
+    remove_arquivo(b, "camada", i);
+    remove_arquivo(b, "visitados", i);
+  }
+  snprintf(nome, sizeof(nome), "%s/ponto.bin", b->par->diretorio);
+  remove(nome);
+}
+
+// busca em largura com as camadas em disco
+bool busca_em_disco(jogo_t *j, parametros_disco_t *par, resultado_busca_t *res, estatisticas_disco_t *est)
+{
+  double inicio = agora();
+  busca_disco_t b;
+  memset(&b, 0, sizeof(b));
+  b.par = par;
+  b.est = est;
+  memset(est, 0, sizeof(*est));
+  res->resolvido = false;
+  res->n_jogadas = 0;
+  res->estados_expandidos = 0;
+
+  jogo_t *atual = malloc(sizeof(jogo_t));
+  assert(atual != NULL);
+  *atual = *j;
+  atual->relogio = NULL;
+  res->avaliacao = avalia_estado(atual, 0);
+
+  if (vitoria_garantida(atual)) {
+    completa_vitoria(atual, res);
+    res->resolvido = est->decidida = true;
+    free(atual);
+    res->tempo = agora() - inicio;
+    return true;
+  }
+
+  mkdir(par->diretorio, 0755);
+  ponto_disco_t ponto;
+  jogo_compacto_t raiz;
+  compacta_jogo(atual, &raiz);
+  if (le_ponto(&b, &ponto, &raiz)) {
+    est->retomada = true;
+  } else {
+    memset(&ponto, 0, sizeof(ponto));
+    ponto.marca = MARCA_PONTO_DISCO;
+    ponto.raiz = raiz;
+    ponto.max_reciclagens = par->max_reciclagens;
+    if (!inicia_camadas(&b, atual, &ponto)) {
+      free(atual);
+      res->tempo = agora() - inicio;
+      return false;
+    }
+  }
+
+  b.capacidade_buffer = par->limite_memoria / sizeof(registro_disco_t);
+  if (b.capacidade_buffer < 1) b.capacidade_buffer = 1;
+  b.buffer = malloc(b.capacidade_buffer * sizeof(registro_disco_t));
+  assert(b.buffer != NULL);
+
+  bool ok = true;
+  bool interrompida = false;
+  int camada = ponto.profundidade;
+
+  while (ok && !est->decidida && !interrompida) {
+    FILE *entrada = abre_arquivo(&b, "camada", camada, "rb");
+    if (entrada == NULL) { ok = false; break; }
+    b.n_buffer = 0;
+    b.n_corridas = 0;
+    b.proxima_corrida = 0;
+
+    // expande a camada, juntando os filhos em corridas ordenadas
+    registro_disco_t reg;
+    while (ok && !est->decidida && le_disco(&b, &reg, sizeof(reg), entrada)) {
+      if ((res->estados_expandidos & 1023) == 0
+          && ((par->parar != NULL && *par->parar) || agora() - inicio > par->limite_tempo)) {
+        interrompida = true;
+        break;
+      }
+      expande_jogo(&reg.estado, atual);
+      res->estados_expandidos++;
+
+      jogada_t jogadas[N_MAX_JOGADAS];
+      int n_jogadas = gera_jogadas(atual, jogadas);
+      for (int i = 0; i < n_jogadas && ok; i++) {
+        bool recicla = jogadas[i].origem == PILHA_DESCARTE && jogadas[i].destino == PILHA_MONTE;
+        int reciclagens = reg.reciclagens + recicla;
+        if (par->max_reciclagens >= 0 && reciclagens > par->max_reciclagens) continue;
+
+        desfazer_t d;
+        faz_jogada(atual, jogadas[i], &d);
+        if (vitoria_garantida(atual)) {
+          est->decidida = true;
+          ok = reconstroi_linha_disco(&b, camada, &reg, jogadas[i], res);
+          desfaz_jogada(atual, jogadas[i], &d);
+          break;
+        }
+        registro_disco_t *filho = &b.buffer[b.n_buffer++];
+        filho->chave = chave_disco(atual, reciclagens, par->max_reciclagens);
+        filho->chave_pai = reg.chave;
+        compacta_jogo(atual, &filho->estado);
+        filho->jogada = jogadas[i];
+        filho->reciclagens = reciclagens;
+        est->estados_gerados++;
+        desfaz_jogada(atual, jogadas[i], &d);
+        if (b.n_buffer == b.capacidade_buffer)
+          ok = grava_corrida(&b);
+      }
+    }
+    fclose(entrada);
+
+    if (est->decidida || interrompida || !ok) {
+      // as corridas de uma camada incompleta não servem para a retomada
+      for (int i = 0; i < b.proxima_corrida; i++)
+        remove_arquivo(&b, "corrida", i);
+      break;
+    }
+
+    // intercala as corridas, descartando os estados já visitados
+    ok = grava_corrida(&b) && reduz_corridas(&b);
+    FILE *saida = abre_arquivo(&b, "camada", camada + 1, "wb");
+    FILE *visitados = abre_arquivo(&b, "visitados", camada, "rb");
+    FILE *novos_visitados = abre_arquivo(&b, "visitados", camada + 1, "wb");
+    long n_novos = -1;
+    if (ok && saida != NULL && visitados != NULL && novos_visitados != NULL)
+      n_novos = intercala_corridas(&b, b.proxima_corrida - b.n_corridas, b.n_corridas, saida, visitados, novos_visitados);
+    if (saida != NULL && fclose(saida) != 0) n_novos = -1;
+    if (visitados != NULL) fclose(visitados);
+    if (novos_visitados != NULL && fclose(novos_visitados) != 0) n_novos = -1;
+    if (n_novos < 0) { ok = false; break; }
+
+    camada++;
+    est->profundidade = camada;
+    // sem estados novos, não há solução
+    if (n_novos == 0) est->decidida = true;
+
+    ponto.profundidade = camada;
+    ok = grava_ponto(&b, &ponto);
+    remove_arquivo(&b, "visitados", camada - 1);
+  }
+
+  if (est->decidida && ok && res->n_jogadas > 0) {
+    // refaz a linha e leva as cartas restantes para a saída
+    *atual = *j;
+    atual->relogio = NULL;
+    for (int i = 0; i < res->n_jogadas; i++)
+      aplica_jogada(atual, res->jogadas[i]);
+    completa_vitoria(atual, res);
+    res->resolvido = venceu_jogo(atual);
+    res->avaliacao = avalia_estado(atual, 0);
+  }
+  if (!ok) est->decidida = false;
+  est->profundidade = camada;
+  if (est->decidida) limpa_diretorio(&b, camada);
+
+  free(b.buffer);
+  free(atual);
+  res->tempo = agora() - inicio;
+  return res->resolvido;
+}
+
+// subárvore a percorrer: um estado, a linha até ele e as jogadas a tentar a partir dele
+typedef struct {
+  jogo_compacto_t estado;
+  uint8_t reciclagens;
+  int n_caminho;
+  jogada_t caminho[MAX_JOGADAS_SOLUCAO];
+  int n_jogadas;
+  jogada_t jogadas[N_MAX_JOGADAS];
+} tarefa_busca_t;
+
+// um nível da pilha da busca em profundidade
+typedef struct {
+  jogada_t jogadas[N_MAX_JOGADAS];
+  int n_jogadas;
+  int proxima;
+  uint8_t reciclagens;
+  desfazer_t desfazer;
+} quadro_busca_t;
+
+// fila de tarefas de uma thread: a dona tira do fim, as outras roubam do início
+typedef struct {
+  pthread_mutex_t trava;
+  tarefa_busca_t **tarefas;
+  int inicio;
+  int fim;
+  int capacidade;
+} fila_tarefas_t;
+
+struct busca_paralela;
+
+// uma thread da busca em profundidade
+typedef struct {
+  struct busca_paralela *busca;
+  int indice;
+  fila_tarefas_t fila;
+  jogo_t jogo;
+  jogo_t rascunho;
+  quadro_busca_t quadros[MAX_JOGADAS_SOLUCAO];
+  long estados;
+  long roubos;
+  bool incompleta;
+} trabalhador_t;
+
+// estado compartilhado da busca em profundidade
+typedef struct busca_paralela {
+  parametros_profundidade_t *par;
+  double inicio;
+  _Atomic uint64_t *tabela;
+  long capacidade_tabela;
+  trabalhador_t *trabalhadores;
+  int n_trabalhadores;
+  atomic_int ociosos;
+  atomic_int trabalhando;
+  atomic_int pendentes;
+  atomic_bool encerrada;
+  atomic_bool achou;
+  resultado_busca_t *res;
+} busca_paralela_t;
+
+// número máximo de posições examinadas ao marcar uma chave; acima disso a tabela é considerada cheia
+#define MAX_SONDAGENS 64
+// reciclagens que ainda podem ser feitas, para a ordenação das jogadas
+#define RECICLAGENS_RESTANTES(par, reciclagens) ((par)->max_reciclagens < 0 ? 1 : (par)->max_reciclagens - (reciclagens))
+
+void parametros_profundidade_padrao(parametros_profundidade_t *par)
+{
+  par->limite_memoria = 256 << 20;
+  par->limite_tempo = 60;
+  par->max_reciclagens = 3;
+  par->n_threads = 1;
+  par->parar = NULL;
+}
+
+// marca a chave na tabela compartilhada, sem travas; retorna false se já estava marcada.
+// com a vizinhança da chave cheia, deixa de marcar e aceita
+static bool marca_transposicao(busca_paralela_t *b, uint64_t chave, bool *cheia)
+{
+  if (chave == 0) chave = 1; // zero marca posição livre
+  long mascara = b->capacidade_tabela - 1;
+  long i = chave & mascara;
+  for (int k = 0; k < MAX_SONDAGENS; k++) {
+    uint64_t atual = atomic_load_explicit(&b->tabela[i], memory_order_relaxed);
+    if (atual == chave) return false;
+    if (atual == 0) {
+      uint64_t livre = 0;
+      if (atomic_compare_exchange_strong(&b->tabela[i], &livre, chave)) return true;
+      // outra thread ocupou a posição: pode ter sido com a mesma chave
+      if (livre == chave) return false;
+    }
+    i = (i + 1) & mascara;
+  }
+  *cheia = true;
+  return true;
+}
+
+// coloca uma tarefa no fim da fila
+static void empilha_tarefa(busca_paralela_t *b, fila_tarefas_t *f, tarefa_busca_t *t)
+{
+  atomic_fetch_add(&b->pendentes, 1);
+  pthread_mutex_lock(&f->trava);
+  if (f->fim == f->capacidade) {
+    // reaproveita o espaço do início antes de crescer
+    int n = f->fim - f->inicio;
+    memmove(f->tarefas, f->tarefas + f->inicio, n * sizeof(tarefa_busca_t *));
+    f->inicio = 0;
+    f->fim = n;
+    if (f->fim == f->capacidade) {
+      f->capacidade = f->capacidade * 2 + 8;
+      f->tarefas = realloc(f->tarefas, f->capacidade * sizeof(tarefa_busca_t *));
+      assert(f->tarefas != NULL);
+    }
+  }
+  f->tarefas[f->fim++] = t;
+  pthread_mutex_unlock(&f->trava);
+}
+
+// tira uma tarefa da fila: do fim, se for a dona, ou do início, se for roubo
+static tarefa_busca_t *retira_tarefa(busca_paralela_t *b, fila_tarefas_t *f, bool roubo)
+{
+  tarefa_busca_t *t = NULL;
+  pthread_mutex_lock(&f->trava);
+  if (f->inicio < f->fim) {
+    t = roubo ? f->tarefas[f->inicio++] : f->tarefas[--f->fim];
+    // conta como trabalhando antes de sair das pendentes, para ninguém achar que a busca acabou
+    atomic_fetch_add(&b->trabalhando, 1);
+    atomic_fetch_sub(&b->pendentes, 1);
+  }
+  pthread_mutex_unlock(&f->trava);
+  return t;
+}
+
+// se a fila está vazia; o início muda nos roubos, então é lido com a trava
+static bool fila_vazia(fila_tarefas_t *f)
+{
+  pthread_mutex_lock(&f->trava);
+  bool vazia = f->inicio == f->fim;
+  pthread_mutex_unlock(&f->trava);
+  return vazia;
+}
+
+// pega uma tarefa da própria fila ou rouba de outra thread
+static tarefa_busca_t *procura_tarefa(trabalhador_t *w)
+{
+  busca_paralela_t *b = w->busca;
+  tarefa_busca_t *t = retira_tarefa(b, &w->fila, false);
+  for (int k = 1; t == NULL && k < b->n_trabalhadores; k++) {
+    t = retira_tarefa(b, &b->trabalhadores[(w->indice + k) % b->n_trabalhadores].fila, true);
+    if (t != NULL) w->roubos++;
+  }
+  return t;
+}
+
+// doa as jogadas ainda não tentadas do nível mais raso da pilha, como uma nova tarefa
+static void doa_subarvore(trabalhador_t *w, tarefa_busca_t *t, int topo)
+{
+  int k = 0;
+  while (k <= topo && w->quadros[k].proxima >= w->quadros[k].n_jogadas)
+    k++;
+  if (k > topo) return;
+
+  // refaz o estado do nível k a partir do estado da tarefa
+  tarefa_busca_t *nova = malloc(sizeof(tarefa_busca_t));
+  assert(nova != NULL);
+  expande_jogo(&t->estado, &w->rascunho);
+  memcpy(nova->caminho, t->caminho, t->n_caminho * sizeof(jogada_t));
+  nova->n_caminho = t->n_caminho;
+  for (int i = 0; i < k; i++) {
+    jogada_t jogada = w->quadros[i].jogadas[w->quadros[i].proxima - 1];
+    aplica_jogada(&w->rascunho, jogada);
+    nova->caminho[nova->n_caminho++] = jogada;
+  }
+  compacta_jogo(&w->rascunho, &nova->estado);
+  nova->reciclagens = w->quadros[k].reciclagens;
+
+  quadro_busca_t *q = &w->quadros[k];
+  nova->n_jogadas = q->n_jogadas - q->proxima;
+  memcpy(nova->jogadas, q->jogadas + q->proxima, nova->n_jogadas * sizeof(jogada_t));
+  q->n_jogadas = q->proxima;
+  empilha_tarefa(w->busca, &w->fila, nova);
+}
+
+// guarda a linha da solução, se nenhuma outra thread achou antes
+static void registra_solucao(trabalhador_t *w, tarefa_busca_t *t, int topo)
+{
+  busca_paralela_t *b = w->busca;
+  bool falso = false;
+  if (!atomic_compare_exchange_strong(&b->achou, &falso, true)) return;
+  resultado_busca_t *res = b->res;
+  memcpy(res->jogadas, t->caminho, t->n_caminho * sizeof(jogada_t));
+  res->n_jogadas = t->n_caminho;
+  for (int i = 0; i <= topo; i++)
+    res->jogadas[res->n_jogadas++] = w->quadros[i].jogadas[w->quadros[i].proxima - 1];
+  atomic_store(&b->encerrada, true);
+}
+
+// busca em profundidade na subárvore de uma tarefa
+static void percorre_subarvore(trabalhador_t *w, tarefa_busca_t *t)
+{
+  busca_paralela_t *b = w->busca;
+  parametros_profundidade_t *par = b->par;
+  jogo_t *j = &w->jogo;
+  long nos = 0;
+
+  expande_jogo(&t->estado, j);
+  quadro_busca_t *q = &w->quadros[0];
+  memcpy(q->jogadas, t->jogadas, t->n_jogadas * sizeof(jogada_t));
+  q->n_jogadas = t->n_jogadas;
+  q->proxima = 0;
+  q->reciclagens = t->reciclagens;
+  int topo = 0;
+
+  while (topo >= 0) {
+    if ((++nos & 1023) == 0) {
+      if ((par->parar != NULL && *par->parar) || agora() - b->inicio > par->limite_tempo)
+        atomic_store(&b->encerrada, true);
+      if (atomic_load(&b->encerrada)) return;
+    }
+    // há threads sem trabalho e a fila desta está vazia: doa uma subárvore
+    if ((nos & 63) == 0 && atomic_load_explicit(&b->ociosos, memory_order_relaxed) > 0
+        && fila_vazia(&w->fila))
+      doa_subarvore(w, t, topo);
+
+    q = &w->quadros[topo];
+    if (q->proxima >= q->n_jogadas) {
+      // acabaram as jogadas deste nível: volta para o anterior
+      if (--topo >= 0)
+        desfaz_jogada(j, w->quadros[topo].jogadas[w->quadros[topo].proxima - 1], &w->quadros[topo].desfazer);
+      continue;
+    }
+
+    jogada_t jogada = q->jogadas[q->proxima++];
+    bool recicla = jogada.origem == PILHA_DESCARTE && jogada.destino == PILHA_MONTE;
+    int reciclagens = q->reciclagens + recicla;
+    if (par->max_reciclagens >= 0 && reciclagens > par->max_reciclagens) continue;
+
+    faz_jogada(j, jogada, &q->desfazer);
+    if (vitoria_garantida(j)) {
+      registra_solucao(w, t, topo);
+      return;
+    }
+    // a linha precisa caber no resultado, com as jogadas que levam as cartas para a saída
+    bool cabe = t->n_caminho + topo + 1 < MAX_JOGADAS_SOLUCAO - N_MAX_CARTAS;
+    if (!cabe)
+      w->incompleta = true;
+    if (!cabe || !marca_transposicao(b, chave_disco(j, reciclagens, par->max_reciclagens), &w->incompleta)) {
+      desfaz_jogada(j, jogada, &q->desfazer);
+      continue;
+    }
+    w->estados++;
+
+    quadro_busca_t *novo = &w->quadros[++topo];
+    novo->n_jogadas = gera_jogadas(j, novo->jogadas);
+    ordena_jogadas(j, novo->jogadas, novo->n_jogadas, RECICLAGENS_RESTANTES(par, reciclagens));
+    novo->proxima = 0;
+    novo->reciclagens = reciclagens;
+  }
+}
+
+// laço de uma thread: percorre as próprias tarefas e rouba das outras até a busca acabar
+static void *executa_trabalhador(void *arg)
+{
+  trabalhador_t *w = arg;
+  busca_paralela_t *b = w->busca;
+
+  while (!atomic_load(&b->encerrada)) {
+    tarefa_busca_t *t = procura_tarefa(w);
+    if (t != NULL) {
+      percorre_subarvore(w, t);
+      free(t);
+      atomic_fetch_sub(&b->trabalhando, 1);
+      continue;
+    }
+    // sem tarefa: espera alguém doar, ou que todos fiquem sem trabalho
+    atomic_fetch_add(&b->ociosos, 1);
+    while (t == NULL && !atomic_load(&b->encerrada)) {
+      if (atomic_load(&b->trabalhando) == 0 && atomic_load(&b->pendentes) == 0)
+        break;
+      sched_yield();
+      t = procura_tarefa(w);
+    }
+    atomic_fetch_sub(&b->ociosos, 1);
+    if (t == NULL) break;
+    percorre_subarvore(w, t);
+    free(t);
+    atomic_fetch_sub(&b->trabalhando, 1);
+  }
+
+  // descarta o que sobrou na fila se a busca foi encerrada antes
+  tarefa_busca_t *t;
+  while ((t = retira_tarefa(b, &w->fila, false)) != NULL) {
+    free(t);
+    atomic_fetch_sub(&b->trabalhando, 1);
+  }
+  return NULL;
+}
+
+// busca em profundidade exaustiva, dividida entre as threads
+bool busca_em_profundidade(jogo_t *j, parametros_profundidade_t *par, resultado_busca_t *res, estatisticas_profundidade_t *est)
+{
+  busca_paralela_t b;
+  memset(&b, 0, sizeof(b));
+  memset(est, 0, sizeof(*est));
+  b.par = par;
+  b.res = res;
+  b.inicio = agora();
+  res->resolvido = false;
+  res->n_jogadas = 0;
+  res->estados_expandidos = 0;
+
+  jogo_t *atual = malloc(sizeof(jogo_t));
+  assert(atual != NULL);
+  *atual = *j;
+  atual->relogio = NULL;
+  res->avaliacao = avalia_estado(atual, 0);
+
+  // a tabela de transposição ocupa a maior potência de 2 que cabe na memória
+  b.capacidade_tabela = 1;
+  while (b.capacidade_tabela * 2 * sizeof(uint64_t) <= par->limite_memoria)
+    b.capacidade_tabela *= 2;
+  b.tabela = calloc(b.capacidade_tabela, sizeof(uint64_t));
+  b.n_trabalhadores = par->n_threads < 1 ? 1 : par->n_threads;
+  b.trabalhadores = calloc(b.n_trabalhadores, sizeof(trabalhador_t));
+  assert(b.tabela != NULL && b.trabalhadores != NULL);
+  atomic_init(&b.ociosos, 0);
+  atomic_init(&b.trabalhando, 0);
+  atomic_init(&b.pendentes, 0);
+  atomic_init(&b.encerrada, false);
+  atomic_init(&b.achou, vitoria_garantida(atual));
+
+  for (int i = 0; i < b.n_trabalhadores; i++) {
+    trabalhador_t *w = &b.trabalhadores[i];
+    w->busca = &b;
+    w->indice = i;
+    pthread_mutex_init(&w->fila.trava, NULL);
+    w->jogo.relogio = NULL;
+    w->rascunho.relogio = NULL;
+  }
+
+  if (!atomic_load(&b.achou)) {
+    // a primeira tarefa é a raiz inteira, na fila da thread 0
+    bool cheia = false;
+    marca_transposicao(&b, chave_disco(atual, 0, par->max_reciclagens), &cheia);
+    b.trabalhadores[0].estados = 1;
+    tarefa_busca_t *raiz = malloc(sizeof(tarefa_busca_t));
+    assert(raiz != NULL);
+    compacta_jogo(atual, &raiz->estado);
+    raiz->reciclagens = 0;
+    raiz->n_caminho = 0;
+    raiz->n_jogadas = gera_jogadas(atual, raiz->jogadas);
+    ordena_jogadas(atual, raiz->jogadas, raiz->n_jogadas, RECICLAGENS_RESTANTES(par, 0));
+    empilha_tarefa(&b, &b.trabalhadores[0].fila, raiz);
+
+    // a thread atual também trabalha, como a thread 0
+    pthread_t *threads = malloc(b.n_trabalhadores * sizeof(pthread_t));
+    assert(threads != NULL);
+    for (int i = 1; i < b.n_trabalhadores; i++)
+      pthread_create(&threads[i], NULL, executa_trabalhador, &b.trabalhadores[i]);
+    executa_trabalhador(&b.trabalhadores[0]);
+    for (int i = 1; i < b.n_trabalhadores; i++)
+      pthread_join(threads[i], NULL);
+    free(threads);
+  }
+
+  bool interrompida = !atomic_load(&b.achou) && atomic_load(&b.encerrada);
+  for (int i = 0; i < b.n_trabalhadores; i++) {
+    trabalhador_t *w = &b.trabalhadores[i];
+    res->estados_expandidos += w->estados;
+    est->roubos += w->roubos;
+    est->incompleta = est->incompleta || w->incompleta;
+    pthread_mutex_destroy(&w->fila.trava);
+    free(w->fila.tarefas);
+  }
+
+  if (atomic_load(&b.achou)) {
+    // refaz a linha e leva as cartas restantes para a saída
+    for (int i = 0; i < res->n_jogadas; i++)
+      aplica_jogada(atual, res->jogadas[i]);
+    completa_vitoria(atual, res);
+    res->resolvido = venceu_jogo(atual);
+    res->avaliacao = avalia_estado(atual, 0);
+  }
+  // sem solução, a resposta só vale se nenhum ramo foi cortado
+  est->decidida = res->resolvido || (!interrompida && !est->incompleta);
+
+  free(b.trabalhadores);
+  free(b.tabela);
+  free(atual);
+  res->tempo = agora() - b.inicio;
+  return res->resolvido;
+}
@@ -0,0 +1,194 @@
+#ifndef RESOLVEDOR_H
+#define RESOLVEDOR_H
+
+/**
+ * @file resolvedor.h
+ *
+ * @brief Resolvedores do jogo klondike, que procuram uma sequência de jogadas até a vitória.
+ *
+ * A busca em feixe avança uma jogada por vez, guardando só os melhores estados de
+ * cada profundidade segundo uma função de avaliação. Não garante achar a solução,
+ * mas respeita um limite estrito de memória e de tempo e, a qualquer momento,
+ * tem a melhor linha de jogadas encontrada até ali.
+ *
+ * A busca em disco é exaustiva: decide se a distribuição tem solução usando pouca
+ * memória, guardando a fronteira e os estados visitados em arquivos ordenados.
+ * A busca em profundidade também é exaustiva e divide a árvore de uma só
+ * distribuição entre várias threads.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+
+// número máximo de jogadas de uma solução
+#define MAX_JOGADAS_SOLUCAO 1000
+// número máximo de reciclagens do descarte em uma linha
+#define MAX_RECICLAGENS_BUSCA 8
+
+// limites da busca usada para dar dicas durante o jogo
+#define LARGURA_DICA 500
+#define MEMORIA_DICA (32 << 20)
+#define TEMPO_DICA 0.5
+
+// parâmetros da busca em feixe
+typedef struct {
+  int largura;
+  size_t limite_memoria;
+  double limite_tempo;
+  // se apontar para um valor que se torne true, a busca para e fica com a melhor linha até ali
+  volatile bool *parar;
+} parametros_feixe_t;
+
+// resultado de uma busca
+typedef struct {
+  bool resolvido;
+  int n_jogadas;
+  jogada_t jogadas[MAX_JOGADAS_SOLUCAO];
+  int avaliacao;
+  long estados_expandidos;
+  double tempo;
+} resultado_busca_t;
+
+// parâmetros da busca em disco
+typedef struct {
+  // diretório onde ficam as camadas, os visitados e o ponto de retomada
+  const char *diretorio;
+  // memória para juntar estados antes de ordená-los e gravá-los em uma corrida
+  size_t limite_memoria;
+  double limite_tempo;
+  // máximo de reciclagens do descarte; negativo para não limitar
+  int max_reciclagens;
+  volatile bool *parar;
+} parametros_disco_t;
+
+// estatísticas de uma execução da busca em disco
+typedef struct {
+  // true se a busca terminou: achou a solução ou esgotou os estados
+  bool decidida;
+  bool retomada;
+  int profundidade;
+  long estados_gerados;
+  long corridas;
+  uint64_t bytes_lidos;
+  uint64_t bytes_escritos;
+} estatisticas_disco_t;
+
+// parâmetros da busca em profundidade
+typedef struct {
+  // memória da tabela de transposição, compartilhada pelas threads
+  size_t limite_memoria;
+  double limite_tempo;
+  // máximo de reciclagens do descarte; negativo para não limitar
+  int max_reciclagens;
+  int n_threads;
+  volatile bool *parar;
+} parametros_profundidade_t;
+
+// estatísticas da busca em profundidade
+typedef struct {
+  // true se a busca terminou: achou a solução ou visitou todos os estados alcançáveis
+  bool decidida;
+  // true se algum ramo foi cortado pelo tamanho máximo da linha ou pela tabela cheia
+  bool incompleta;
+  long roubos;
+} estatisticas_profundidade_t;
+
+/**
+ * @brief Avalia um estado do jogo, quanto maior melhor.
+ *
+ * Considera as cartas nas pilhas de saída, as cartas fechadas, as pilhas principais
+ * vazias, as cartas que restam no monte e no descarte e quantas vezes o descarte
+ * foi reciclado.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param reciclagens Número de reciclagens do descarte até chegar ao estado.
+ * @return A avaliação do estado.
+ */
+int avalia_estado(jogo_t *j, int reciclagens);
+
+/**
+ * @brief Preenche parâmetros padrão para a busca em feixe.
+ *
+ * @param par Ponteiro para os parâmetros.
+ */
+void parametros_feixe_padrao(parametros_feixe_t *par);
+
+/**
+ * @brief Procura uma solução com busca em feixe.
+ *
+ * Toda a memória da busca (feixe, estados visitados e histórico de jogadas) é
+ * reservada no início a partir de par->limite_memoria; quando o histórico enche,
+ * o tempo acaba ou *par->parar fica true, a busca termina com a melhor linha
+ * encontrada. O jogo não é alterado.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param par Parâmetros da busca.
+ * @param res Ponteiro para o resultado: a solução, ou a linha até o melhor estado avaliado.
+ * @return true se achou uma solução, false caso contrário.
+ */
+bool busca_em_feixe(jogo_t *j, parametros_feixe_t *par, resultado_busca_t *res);
+
+/**
+ * @brief Preenche parâmetros padrão para a busca em disco.
+ *
+ * @param par Ponteiro para os parâmetros.
+ * @param diretorio Diretório de trabalho da busca.
+ */
+void parametros_disco_padrao(parametros_disco_t *par, const char *diretorio);
+
+/**
+ * @brief Decide se uma distribuição tem solução com uma busca em largura que guarda os estados em disco.
+ *
+ * Cada profundidade é uma camada de estados únicos ordenados pela chave canônica.
+ * Os filhos de uma camada são juntados na memória até par->limite_memoria,
+ * ordenados e gravados em corridas; no fim da camada as corridas são intercaladas e
+ * os repetidos, inclusive os já visitados em camadas anteriores, são descartados
+ * (detecção atrasada de duplicatas). Depois de cada camada é gravado um ponto de
+ * retomada: chamando a função de novo com o mesmo diretório e o mesmo jogo, a busca
+ * continua de onde parou. Quando a busca é decidida, os arquivos são apagados.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param par Parâmetros da busca.
+ * @param res Ponteiro para o resultado: a solução, se houver.
+ * @param est Ponteiro para as estatísticas da busca.
+ * @return true se achou uma solução, false caso contrário (veja est->decidida).
+ */
+bool busca_em_disco(jogo_t *j, parametros_disco_t *par, resultado_busca_t *res, estatisticas_disco_t *est);
+
+/**
+ * @brief Preenche parâmetros padrão para a busca em profundidade.
+ *
+ * @param par Ponteiro para os parâmetros.
+ */
+void parametros_profundidade_padrao(parametros_profundidade_t *par);
+
+/**
+ * @brief Decide se uma distribuição tem solução com uma busca em profundidade exaustiva.
+ *
+ * Cada estado é visitado uma vez só, marcado em uma tabela de transposição sem travas
+ * compartilhada pelas threads. Cada thread percorre uma subárvore; quando há threads
+ * ociosas, a que está trabalhando doa as jogadas ainda não tentadas do nível mais raso
+ * da sua pilha, que as ociosas roubam. Como todos os estados alcançáveis são visitados
+ * uma vez, a decisão (e, sem solução, o número de estados) não depende do número de
+ * threads; com solução, a linha encontrada pode variar, mas é sempre válida.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo.
+ * @param par Parâmetros da busca.
+ * @param res Ponteiro para o resultado: a solução, se houver.
+ * @param est Ponteiro para as estatísticas da busca.
+ * @return true se achou uma solução, false caso contrário (veja est->decidida).
+ */
+bool busca_em_profundidade(jogo_t *j, parametros_profundidade_t *par, resultado_busca_t *res, estatisticas_profundidade_t *est);
+
+/**
+ * @brief Completa uma linha em um jogo garantidamente ganho.
+ *
+ * Leva todas as cartas para as pilhas de saída, acrescentando as jogadas à linha.
+ *
+ * @param j Ponteiro para a estrutura de dados do jogo (é alterado).
+ * @param res Ponteiro para o resultado onde as jogadas são acrescentadas.
+ */
+void completa_vitoria(jogo_t *j, resultado_busca_t *res);
+
+#endif // RESOLVEDOR_H
@@ -0,0 +1,630 @@
+/**
+ * @file servidor.c
+ *
+ * @brief Servidor sem janela de partidas para robôs, em um socket Unix.
+ *
+ * Cada conexão é uma sessão com uma partida. O protocolo é de linhas de texto,
+ * com uma resposta de uma linha para cada pedido:
+ *
+ *   novo [semente]   distribui as cartas           ok <semente>
+ *   jogada <cmd>     cmd como em realiza_jogada()  ok <pontos> <venceu>
+ *   estado           pilhas da partida             estado <pontos> <venceu> m:<n> p:<cartas> a:... 1:...
+ *   sai              fecha a conexão               ok
+ *
+ * Erros são respondidos com "erro <motivo>". Nas pilhas, as cartas vão do fundo
+ * para o topo, separadas por vírgula, cada uma com o valor (A23456789TJQK) e o
+ * naipe (o, c, e, p); "##" é uma carta fechada e "-" uma pilha vazia.
+ *
+ * Uma só thread atende todas as conexões com epoll. As sessões ficam em um vetor
+ * alocado no início, com uma lista de posições livres, e guardam a partida no
+ * registro compacto (jogo_compacto_t); cada pedido expande a partida em um
+ * jogo_t de trabalho, o único do servidor, e compacta de volta. Clientes que não
+ * leem as respostas, deixando o socket cheio, são desconectados.
+ *
+ * Com -c o programa é o gerador de carga: abre as conexões, joga em cada uma
+ * partidas com jogadas sorteadas entre as possíveis (e de vez em quando pede o
+ * estado, conferido com uma cópia local da partida) e mostra os pedidos por
+ * segundo e a latência, do envio do pedido até a chegada da resposta.
+ *
+ * Uso: ./servidor [-u socket] [-n sessões]
+ *      ./servidor -c conexões [-u socket] [-t segundos] [-s semente]
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+// accept4()
+#define _GNU_SOURCE
+#include "funcoes.h"
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SOCKET_PADRAO "/tmp/klondike.sock"
+// maior linha de pedido aceita, com o '\n'
+#define TAM_PEDIDO 64
+// maior linha de resposta (a de estado tem no máximo umas 230 letras)
+#define TAM_RESPOSTA 512
+// respostas juntadas antes de escrever no socket
+#define TAM_SAIDA (64 << 10)
+#define MAX_EVENTOS 256
+// marca do socket de escuta nos eventos do epoll
+#define ESCUTA UINT32_MAX
+// no gerador de carga: jogadas por partida, antes de pedir uma nova
+#define MAX_JOGADAS_CARGA 300
+// no gerador de carga: um pedido de estado a cada tantos pedidos
+#define PEDIDOS_POR_ESTADO 8
+
+static const char valores[] = "?A23456789TJQK";
+static const char naipes[] = "ocep";
+
+// uma sessão do servidor: a partida compactada e a linha de pedido pela metade
+typedef struct {
+  double pontos;
+  double bonus_total;
+  double tempo_ultima_jogada;
+  uint64_t semente;
+  int fd;
+  uint32_t jogadas;
+  jogo_compacto_t jogo;
+  bool em_jogo;
+  uint8_t n_entrada;
+  char entrada[TAM_PEDIDO];
+} sessao_t;
+
+// sessões do servidor, todas alocadas no início
+typedef struct {
+  sessao_t *sessoes;
+  uint32_t *livres;
+  uint32_t n_livres;
+  uint32_t max_sessoes;
+  // jogo de trabalho, onde a partida de uma sessão é expandida para cada pedido
+  jogo_t *jogo;
+  uint64_t proxima_semente;
+  uint64_t conexoes;
+  uint64_t pedidos;
+  uint64_t recusadas;
+} servidor_t;
+
+// uma conexão do gerador de carga, com a cópia local da partida
+typedef struct {
+  jogo_t *jogo;
+  double enviado;
+  int fd;
+  int jogadas;
+  int n_entrada;
+  bool em_jogo;
+  // pedido à espera de resposta: 'n'ovo, 'j'ogada ou 'e'stado
+  char pedido;
+  char entrada[TAM_RESPOSTA];
+} cliente_t;
+
+static volatile sig_atomic_t parar = 0;
+
+static void trata_sinal(int sinal)
+{
+  (void)sinal;
+  parar = 1;
+}
+
+// relógio monotônico, em segundos
+static double agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// sobe o limite de arquivos abertos até o máximo permitido, para caberem milhares de conexões
+static void aumenta_limite_arquivos(void)
+{
+  struct rlimit r;
+  if (getrlimit(RLIMIT_NOFILE, &r) == 0 && r.rlim_cur < r.rlim_max) {
+    r.rlim_cur = r.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &r);
+  }
+}
+
+// escreve uma pilha do registro compacto, a partir da carta k; retorna o número de letras
+static int escreve_pilha(char *s, jogo_compacto_t *c, int indice, int k)
+{
+  int n = 0;
+  int n_cartas = c->n_cartas[indice];
+  if (n_cartas == 0) {
+    s[n++] = '-';
+    return n;
+  }
+  for (int i = 0; i < n_cartas; i++) {
+    if (i > 0) s[n++] = ',';
+    if (i < c->n_cartas_fechadas[indice]) {
+      s[n++] = '#';
+      s[n++] = '#';
+    } else {
+      carta_t carta = carta_do_indice(c->cartas[k + i]);
+      s[n++] = valores[carta.valor];
+      s[n++] = naipes[carta.naipe];
+    }
+  }
+  return n;
+}
+
+// a partida está vencida quando as pilhas de saída têm todas as cartas
+static bool compacto_vencido(jogo_compacto_t *c)
+{
+  int n = 0;
+  for (int i = PILHA_SAIDA; i < PILHA_PRINCIPAL; i++)
+    n += c->n_cartas[i];
+  return n == N_MAX_CARTAS;
+}
+
+// escreve a linha de estado, direto do registro compacto; retorna o número de letras, sem o '\n'
+static int escreve_estado(char *s, jogo_compacto_t *c, double pontos)
+{
+  static const char nomes[N_PILHAS] = { 'm', 'p', 'a', 'b', 'c', 'd', '1', '2', '3', '4', '5', '6', '7' };
+  int n = sprintf(s, "estado %.2f %d m:%d", pontos, compacto_vencido(c), c->n_cartas[PILHA_MONTE]);
+  int k = c->n_cartas[PILHA_MONTE];
+  for (int i = PILHA_DESCARTE; i < N_PILHAS; i++) {
+    s[n++] = ' ';
+    s[n++] = nomes[i];
+    s[n++] = ':';
+    n += escreve_pilha(s + n, c, i, k);
+    k += c->n_cartas[i];
+  }
+  s[n] = '\0';
+  return n;
+}
+
+// expande a partida da sessão no jogo de trabalho
+static void carrega_sessao(sessao_t *s, jogo_t *j)
+{
+  expande_jogo(&s->jogo, j);
+  j->pontos = s->pontos;
+  j->bonus_total = s->bonus_total;
+  j->tempo_ultima_jogada = s->tempo_ultima_jogada;
+  j->sair = false;
+}
+
+// guarda o jogo de trabalho na sessão
+static void guarda_sessao(sessao_t *s, jogo_t *j)
+{
+  compacta_jogo(j, &s->jogo);
+  s->pontos = j->pontos;
+  s->bonus_total = j->bonus_total;
+  s->tempo_ultima_jogada = j->tempo_ultima_jogada;
+}
+
+// atende um pedido, escrevendo a resposta em r; retorna false se a conexão deve ser fechada
+static bool atende_pedido(servidor_t *sv, sessao_t *s, char *linha, char *r)
+{
+  char *args = strchr(linha, ' ');
+  if (args != NULL) *args++ = '\0';
+  else args = "";
+  jogo_t *j = sv->jogo;
+
+  if (strcmp(linha, "novo") == 0) {
+    uint64_t semente;
+    if (*args != '\0') {
+      char *fim;
+      semente = strtoull(args, &fim, 10);
+      if (*fim != '\0') {
+        strcpy(r, "erro semente inválida\n");
+        return true;
+      }
+    } else {
+      semente = espalha_64(sv->proxima_semente++);
+    }
+    inicia_pilhas_jogo_com_semente(j, semente);
+    guarda_sessao(s, j);
+    s->semente = semente;
+    s->jogadas = 0;
+    s->em_jogo = true;
+    sprintf(r, "ok %llu\n", (unsigned long long)semente);
+  } else if (strcmp(linha, "jogada") == 0) {
+    if (!s->em_jogo) {
+      strcpy(r, "erro sem partida\n");
+    } else if (strlen(args) > MAX_CHAR_CMD) {
+      strcpy(r, "erro jogada inválida\n");
+    } else {
+      carrega_sessao(s, j);
+      if (!realiza_jogada(j, args) && !j->sair) {
+        strcpy(r, "erro jogada inválida\n");
+        return true;
+      }
+      // como no jogo, "f" desiste da partida
+      if (j->sair) {
+        s->em_jogo = false;
+        sprintf(r, "ok %.2f 0\n", j->pontos);
+        return true;
+      }
+      guarda_sessao(s, j);
+      s->jogadas++;
+      sprintf(r, "ok %.2f %d\n", j->pontos, venceu_jogo(j));
+    }
+  } else if (strcmp(linha, "estado") == 0) {
+    if (!s->em_jogo) {
+      strcpy(r, "erro sem partida\n");
+    } else {
+      int n = escreve_estado(r, &s->jogo, s->pontos);
+      strcpy(r + n, "\n");
+    }
+  } else if (strcmp(linha, "sai") == 0) {
+    strcpy(r, "ok\n");
+    return false;
+  } else {
+    strcpy(r, "erro pedido desconhecido\n");
+  }
+  return true;
+}
+
+// escreve tudo no socket; retorna false se o socket está cheio ou com erro
+static bool escreve_tudo(int fd, const char *buf, size_t n)
+{
+  while (n > 0) {
+    ssize_t escrito = send(fd, buf, n, MSG_NOSIGNAL);
+    if (escrito < 0 && errno == EINTR) continue;
+    if (escrito <= 0) return false;
+    buf += escrito;
+    n -= escrito;
+  }
+  return true;
+}
+
+static void fecha_sessao(servidor_t *sv, uint32_t id)
+{
+  close(sv->sessoes[id].fd);
+  sv->sessoes[id].fd = -1;
+  sv->livres[sv->n_livres++] = id;
+}
+
+// lê os pedidos que chegaram em uma sessão e responde a todos de uma vez
+static void atende_sessao(servidor_t *sv, uint32_t id)
+{
+  static char saida[TAM_SAIDA];
+  sessao_t *s = &sv->sessoes[id];
+  size_t n_saida = 0;
+  bool aberta = true;
+
+  // evento atrasado de uma sessão fechada antes, no mesmo lote de eventos
+  if (s->fd < 0) return;
+
+  while (aberta) {
+    ssize_t lido = recv(s->fd, s->entrada + s->n_entrada, TAM_PEDIDO - s->n_entrada, 0);
+    if (lido < 0 && errno == EINTR) continue;
+    if (lido < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (lido <= 0) {
+      aberta = false;
+      break;
+    }
+    s->n_entrada += lido;
+
+    char *linha = s->entrada, *fim = s->entrada + s->n_entrada;
+    char *nl;
+    while (aberta && (nl = memchr(linha, '\n', fim - linha)) != NULL) {
+      *nl = '\0';
+      if (nl > linha && nl[-1] == '\r') nl[-1] = '\0';
+      if (n_saida + TAM_RESPOSTA > TAM_SAIDA) {
+        if (!escreve_tudo(s->fd, saida, n_saida)) aberta = false;
+        n_saida = 0;
+      }
+      aberta = aberta && atende_pedido(sv, s, linha, saida + n_saida);
+      n_saida += strlen(saida + n_saida);
+      sv->pedidos++;
+      linha = nl + 1;
+    }
+    s->n_entrada = fim - linha;
+    memmove(s->entrada, linha, s->n_entrada);
+    if (s->n_entrada == TAM_PEDIDO) {
+      strcpy(saida + n_saida, "erro pedido longo demais\n");
+      n_saida += strlen(saida + n_saida);
+      aberta = false;
+    }
+  }
+
+  if (n_saida > 0 && !escreve_tudo(s->fd, saida, n_saida))
+    aberta = false;
+  if (!aberta)
+    fecha_sessao(sv, id);
+}
+
+// aceita as conexões pendentes, dando a cada uma uma sessão livre
+static void aceita_conexoes(servidor_t *sv, int escuta, int ep)
+{
+  int fd;
+  while ((fd = accept4(escuta, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+    if (sv->n_livres == 0) {
+      escreve_tudo(fd, "erro servidor cheio\n", strlen("erro servidor cheio\n"));
+      close(fd);
+      sv->recusadas++;
+      continue;
+    }
+    uint32_t id = sv->livres[--sv->n_livres];
+    sessao_t *s = &sv->sessoes[id];
+    s->fd = fd;
+    s->n_entrada = 0;
+    s->em_jogo = false;
+    struct epoll_event e = { .events = EPOLLIN, .data.u32 = id };
+    epoll_ctl(ep, EPOLL_CTL_ADD, fd, &e);
+    sv->conexoes++;
+  }
+}
+
+// cria o socket Unix no caminho dado, escutando ou conectando; retorna -1 se não conseguiu
+static int abre_socket(const char *caminho, bool escuta)
+{
+  struct sockaddr_un end = { .sun_family = AF_UNIX };
+  if (strlen(caminho) >= sizeof(end.sun_path)) {
+    fprintf(stderr, "caminho do socket longo demais: %s\n", caminho);
+    return -1;
+  }
+  strcpy(end.sun_path, caminho);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+  if (escuta) {
+    unlink(caminho);
+    if (bind(fd, (struct sockaddr *)&end, sizeof(end)) < 0 || listen(fd, SOMAXCONN) < 0) {
+      close(fd);
+      return -1;
+    }
+  } else if (connect(fd, (struct sockaddr *)&end, sizeof(end)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int servidor(const char *caminho, uint32_t max_sessoes)
+{
+  servidor_t sv = { .max_sessoes = max_sessoes, .proxima_semente = (uint64_t)time(NULL) };
+  sv.sessoes = calloc(max_sessoes, sizeof(sessao_t));
+  sv.livres = malloc(max_sessoes * sizeof(uint32_t));
+  sv.jogo = malloc(sizeof(jogo_t));
+  assert(sv.sessoes != NULL && sv.livres != NULL && sv.jogo != NULL);
+  sv.jogo->relogio = agora;
+  // a primeira sessão livre é a 0
+  for (uint32_t i = 0; i < max_sessoes; i++) {
+    sv.sessoes[i].fd = -1;
+    sv.livres[i] = max_sessoes - 1 - i;
+  }
+  sv.n_livres = max_sessoes;
+
+  int escuta = abre_socket(caminho, true);
+  if (escuta < 0) {
+    fprintf(stderr, "não foi possível escutar em %s\n", caminho);
+    return 1;
+  }
+  fcntl(escuta, F_SETFL, fcntl(escuta, F_GETFL) | O_NONBLOCK);
+  int ep = epoll_create1(EPOLL_CLOEXEC);
+  struct epoll_event e = { .events = EPOLLIN, .data.u32 = ESCUTA };
+  epoll_ctl(ep, EPOLL_CTL_ADD, escuta, &e);
+  printf("escutando em %s, até %u sessões de %zu bytes\n", caminho, max_sessoes, sizeof(sessao_t));
+  fflush(stdout);
+
+  struct epoll_event eventos[MAX_EVENTOS];
+  double inicio = agora();
+  while (!parar) {
+    int n = epoll_wait(ep, eventos, MAX_EVENTOS, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      perror("epoll_wait");
+      break;
+    }
+    for (int i = 0; i < n; i++) {
+      if (eventos[i].data.u32 == ESCUTA)
+        aceita_conexoes(&sv, escuta, ep);
+      else
+        atende_sessao(&sv, eventos[i].data.u32);
+    }
+  }
+  double duracao = agora() - inicio;
+
+  for (uint32_t i = 0; i < max_sessoes; i++)
+    if (sv.sessoes[i].fd >= 0) close(sv.sessoes[i].fd);
+  close(ep);
+  close(escuta);
+  unlink(caminho);
+  printf("conexões:   %llu (%llu recusadas)\n", (unsigned long long)sv.conexoes, (unsigned long long)sv.recusadas);
+  printf("pedidos:    %llu (%.0f/s)\n", (unsigned long long)sv.pedidos, sv.pedidos / duracao);
+  free(sv.jogo);
+  free(sv.livres);
+  free(sv.sessoes);
+  return 0;
+}
+
+// escolhe e envia o próximo pedido de uma conexão do gerador de carga, aplicando as jogadas na cópia local
+static bool envia_pedido(cliente_t *c, gerador_t *g, uint64_t *proxima_semente, uint64_t n_pedidos)
+{
+  char pedido[TAM_PEDIDO];
+  jogada_t jogadas[N_MAX_JOGADAS];
+  int n_jogadas = c->em_jogo ? gera_jogadas(c->jogo, jogadas) : 0;
+
+  if (!c->em_jogo || n_jogadas == 0 || c->jogadas >= MAX_JOGADAS_CARGA || venceu_jogo(c->jogo)) {
+    uint64_t semente = (*proxima_semente)++;
+    inicia_pilhas_jogo_com_semente(c->jogo, semente);
+    c->em_jogo = true;
+    c->jogadas = 0;
+    c->pedido = 'n';
+    sprintf(pedido, "novo %llu\n", (unsigned long long)semente);
+  } else if (n_pedidos % PEDIDOS_POR_ESTADO == 0) {
+    c->pedido = 'e';
+    strcpy(pedido, "estado\n");
+  } else {
+    jogada_t jg = jogadas[sorteia(g, n_jogadas)];
+    char comando[MAX_CHAR_CMD + 1];
+    descricao_jogada(jg, comando);
+    aplica_jogada(c->jogo, jg);
+    c->jogadas++;
+    c->pedido = 'j';
+    sprintf(pedido, "jogada %s\n", comando);
+  }
+  c->enviado = agora();
+  return escreve_tudo(c->fd, pedido, strlen(pedido));
+}
+
+// confere a resposta com a cópia local da partida; os pontos não são conferidos, já que o bônus depende do relógio
+static bool confere_resposta(cliente_t *c, char *resposta)
+{
+  if (c->pedido != 'e')
+    return strncmp(resposta, "ok ", 3) == 0;
+
+  char esperado[TAM_RESPOSTA];
+  jogo_compacto_t compacto;
+  compacta_jogo(c->jogo, &compacto);
+  escreve_estado(esperado, &compacto, 0.0);
+  // pula "estado <pontos>" nas duas linhas
+  char *a = strchr(resposta, ' '), *b = strchr(esperado, ' ');
+  a = a != NULL ? strchr(a + 1, ' ') : NULL;
+  b = strchr(b + 1, ' ');
+  return strncmp(resposta, "estado ", 7) == 0 && a != NULL && strcmp(a, b) == 0;
+}
+
+static int compara_float(const void *a, const void *b)
+{
+  float x = *(const float *)a, y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+
+static int carga(const char *caminho, int n_conexoes, double limite_tempo, uint64_t semente)
+{
+  cliente_t *clientes = calloc(n_conexoes, sizeof(cliente_t));
+  size_t n_latencias = 0, cap_latencias = 1 << 20;
+  float *latencias = malloc(cap_latencias * sizeof(float));
+  assert(clientes != NULL && latencias != NULL);
+  gerador_t g;
+  inicia_gerador(&g, semente);
+  uint64_t proxima_semente = semente;
+  uint64_t partidas = 0, divergencias = 0;
+
+  int ep = epoll_create1(EPOLL_CLOEXEC);
+  for (int i = 0; i < n_conexoes; i++) {
+    cliente_t *c = &clientes[i];
+    c->fd = abre_socket(caminho, false);
+    if (c->fd < 0) {
+      fprintf(stderr, "não foi possível conectar em %s (conexão %d): %s\n", caminho, i, strerror(errno));
+      return 1;
+    }
+    fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL) | O_NONBLOCK);
+    c->jogo = malloc(sizeof(jogo_t));
+    assert(c->jogo != NULL);
+    c->jogo->relogio = NULL;
+    struct epoll_event e = { .events = EPOLLIN, .data.u32 = i };
+    epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &e);
+  }
+
+  double inicio = agora(), fim = inicio + limite_tempo;
+  for (int i = 0; i < n_conexoes; i++) {
+    envia_pedido(&clientes[i], &g, &proxima_semente, n_latencias + i);
+    partidas++;
+  }
+
+  struct epoll_event eventos[MAX_EVENTOS];
+  int pendentes = n_conexoes;
+  while (pendentes > 0) {
+    int n = epoll_wait(ep, eventos, MAX_EVENTOS, 1000);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    double chegada = agora();
+    for (int k = 0; k < n; k++) {
+      cliente_t *c = &clientes[eventos[k].data.u32];
+      ssize_t lido = recv(c->fd, c->entrada + c->n_entrada, TAM_RESPOSTA - c->n_entrada, 0);
+      if (lido <= 0) {
+        if (lido < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        fprintf(stderr, "o servidor fechou uma conexão\n");
+        epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+        pendentes--;
+        continue;
+      }
+      c->n_entrada += lido;
+      char *nl = memchr(c->entrada, '\n', c->n_entrada);
+      if (nl == NULL) continue;
+      *nl = '\0';
+      c->n_entrada = 0;
+
+      if (n_latencias == cap_latencias) {
+        cap_latencias *= 2;
+        latencias = realloc(latencias, cap_latencias * sizeof(float));
+        assert(latencias != NULL);
+      }
+      latencias[n_latencias++] = chegada - c->enviado;
+      if (!confere_resposta(c, c->entrada)) {
+        if (divergencias++ == 0)
+          fprintf(stderr, "resposta inesperada ao pedido '%c': %s\n", c->pedido, c->entrada);
+        // recomeça com uma partida nova para voltar a andar junto com o servidor
+        c->em_jogo = false;
+      }
+
+      if (chegada >= fim || parar) {
+        epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+        pendentes--;
+        continue;
+      }
+      if (!envia_pedido(c, &g, &proxima_semente, n_latencias)) {
+        fprintf(stderr, "não foi possível enviar um pedido\n");
+        epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+        pendentes--;
+        continue;
+      }
+      if (c->pedido == 'n') partidas++;
+    }
+  }
+  double duracao = agora() - inicio;
+
+  for (int i = 0; i < n_conexoes; i++) {
+    escreve_tudo(clientes[i].fd, "sai\n", 4);
+    close(clientes[i].fd);
+    free(clientes[i].jogo);
+  }
+  close(ep);
+
+  qsort(latencias, n_latencias, sizeof(float), compara_float);
+  printf("conexões:      %d\n", n_conexoes);
+  printf("pedidos:       %zu (%.0f/s)\n", n_latencias, n_latencias / duracao);
+  printf("partidas:      %llu\n", (unsigned long long)partidas);
+  printf("divergências:  %llu\n", (unsigned long long)divergencias);
+  if (n_latencias > 0) {
+    printf("latência p50:  %.1f µs\n", latencias[n_latencias / 2] * 1e6);
+    printf("latência p99:  %.1f µs\n", latencias[(size_t)(n_latencias * 0.99)] * 1e6);
+    printf("latência p999: %.1f µs\n", latencias[(size_t)(n_latencias * 0.999)] * 1e6);
+    printf("latência máx:  %.1f µs\n", latencias[n_latencias - 1] * 1e6);
+  }
+  free(latencias);
+  free(clientes);
+  return divergencias == 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *caminho = SOCKET_PADRAO;
+  uint32_t max_sessoes = 16384;
+  int n_conexoes = 0;
+  double limite_tempo = 10;
+  uint64_t semente = 1;
+  int opcao;
+
+  while ((opcao = getopt(argc, argv, "u:n:c:t:s:")) != -1) {
+    switch (opcao) {
+      case 'u': caminho = optarg; break;
+      case 'n': max_sessoes = strtoul(optarg, NULL, 10); break;
+      case 'c': n_conexoes = atoi(optarg); break;
+      case 't': limite_tempo = atof(optarg); break;
+      case 's': semente = strtoull(optarg, NULL, 10); break;
+      default:
+        fprintf(stderr, "uso: %s [-u socket] [-n sessões]\n"
+                        "     %s -c conexões [-u socket] [-t segundos] [-s semente]\n", argv[0], argv[0]);
+        return 1;
+    }
+  }
+  if (max_sessoes == 0) max_sessoes = 1;
+
+  aumenta_limite_arquivos();
+  signal(SIGINT, trata_sinal);
+  signal(SIGTERM, trata_sinal);
+  signal(SIGPIPE, SIG_IGN);
+
+  if (n_conexoes > 0)
+    return carga(caminho, n_conexoes, limite_tempo, semente);
+  return servidor(caminho, max_sessoes);
+}
@@ -1,5 +1,6 @@
 // inclui as definicoes
 #include "telag.h"
+#include "metricas.h"
 #include <stdio.h>
 #include <assert.h>
 
@@ -17,18 +18,38 @@ static void cai_fora(char *msg)
   assert(cai-fora);
 }
 
+// a janela, para voltar a desenhar nela depois de desenhar em uma camada
+static ALLEGRO_DISPLAY *janela = NULL;
+static ALLEGRO_EVENT_QUEUE *eventos_janela = NULL;
+// tamanho novo da janela, ainda não informado por tela_redimensionada()
+static bool redimensionou = false;
+static int nova_largura, nova_altura;
+
+// a janela pode diminuir até o tamanho inicial dividido por isto
+#define TAMANHO_MINIMO_JANELA 4
+
 static void tela_inicializa_janela(float l, float a, char n[])
 {
   // pede para tentar linhas mais suaves (multisampling)
   al_set_new_display_option(ALLEGRO_SAMPLE_BUFFERS, 1, ALLEGRO_SUGGEST);
   al_set_new_display_option(ALLEGRO_SAMPLES, 8, ALLEGRO_SUGGEST);
+  // pede para a troca das imagens esperar o monitor (vsync), para não cortar a imagem
+  al_set_new_display_option(ALLEGRO_VSYNC, 1, ALLEGRO_SUGGEST);
   // cria uma janela
-  ALLEGRO_DISPLAY *janela;
+  // a janela pode mudar de tamanho; o jogo refaz a disposição dos desenhos quando muda
+  al_set_new_display_flags(ALLEGRO_WINDOWED | ALLEGRO_RESIZABLE);
   janela = al_create_display(l, a);
   if (janela == NULL) cai_fora("problema na criação de janela do allegro");
   // esconde o cursor do mouse
   al_hide_mouse_cursor(janela);
   al_set_window_title(janela, n);
+  // não deixa a janela ficar menor que um quarto do tamanho inicial em cada direção
+  al_set_window_constraints(janela, l / TAMANHO_MINIMO_JANELA, a / TAMANHO_MINIMO_JANELA, 0, 0);
+  al_apply_window_constraints(janela, true);
+  // fila para os eventos da janela, tratados em tela_atualiza()
+  eventos_janela = al_create_event_queue();
+  if (eventos_janela == NULL) cai_fora("problema na criação da fila de eventos da janela do allegro");
+  al_register_event_source(eventos_janela, al_get_display_event_source(janela));
 }
 
 // vetor com as cores
@@ -57,6 +78,9 @@ void tela_altera_cor(int cor,
 
 // fila para receber os eventos do teclado
 ALLEGRO_EVENT_QUEUE *tela_eventos_teclado;
+// eventos de tela_acorda(), que chegam na mesma fila do teclado
+#define EVENTO_ACORDA ALLEGRO_GET_EVENT_TYPE('K', 'L', 'N', 'D')
+static ALLEGRO_EVENT_SOURCE fonte_acorda;
 void tela_inicializa_teclado(void)
 {
   if (!al_install_keyboard()) cai_fora("problema na inicialização do teclado do allegro");
@@ -65,6 +89,8 @@ void tela_inicializa_teclado(void)
   if (tela_eventos_teclado == NULL) cai_fora("problema na criação da fila de eventos do teclado do allegro");
   al_register_event_source(tela_eventos_teclado,
                            al_get_keyboard_event_source());
+  al_init_user_event_source(&fonte_acorda);
+  al_register_event_source(tela_eventos_teclado, &fonte_acorda);
 }
 
 void tela_inicio(int largura, int altura, char nome[])
@@ -83,17 +109,68 @@ void tela_inicio(int largura, int altura, char nome[])
 }
 
 
+// fontes já carregadas, uma por tamanho, compartilhadas por todos os desenhos
+#define MAX_TAM_FONTE 512
+static ALLEGRO_FONT *fontes[MAX_TAM_FONTE];
+
+// camadas criadas por tela_cria_camada()
+#define MAX_CAMADAS 16
+static ALLEGRO_BITMAP *camadas[MAX_CAMADAS];
+static int n_camadas = 0;
+
+// descarta as fontes carregadas; as que forem usadas de novo são carregadas outra vez
+static void descarta_fontes(void)
+{
+  for (int i = 0; i < MAX_TAM_FONTE; i++) {
+    if (fontes[i] != NULL) al_destroy_font(fontes[i]);
+    fontes[i] = NULL;
+  }
+}
+
 void tela_fim(void)
 {
+  for (int i = 0; i < n_camadas; i++)
+    al_destroy_bitmap(camadas[i]);
+  n_camadas = 0;
+  descarta_fontes();
+  al_destroy_event_queue(eventos_janela);
+  eventos_janela = NULL;
   // badabum!
   al_uninstall_system();
 }
 
+// chamadas de desenho desde a última atualização da tela, para as métricas
+static int desenhos_no_quadro = 0;
+
+// frequência usada quando o monitor não informa a sua
+#define FREQUENCIA_MONITOR_PADRAO 60
+
+// na frequência do monitor, quanto antes do quadro seguinte o cochilo termina,
+// para a troca das imagens esperar o resto pelo vsync
+#define MARGEM_VSYNC 0.002
+
+// intervalo entre dois quadros
+static double segundos_por_quadro = SEGUNDOS_POR_QUADRO;
+
+double tela_limita_quadros(double quadros_por_segundo)
+{
+  int frequencia = al_get_display_refresh_rate(janela);
+  if (frequencia <= 0) frequencia = FREQUENCIA_MONITOR_PADRAO;
+  if (quadros_por_segundo <= 0 || quadros_por_segundo > frequencia)
+    quadros_por_segundo = frequencia;
+  segundos_por_quadro = 1 / quadros_por_segundo;
+  // o cochilo continua mesmo com vsync: o driver pode ignorá-lo, e aí só o cochilo
+  // impede que o laço do desenho gire sem parar
+  if (quadros_por_segundo == frequencia)
+    segundos_por_quadro -= MARGEM_VSYNC;
+  return quadros_por_segundo;
+}
+
 void tela_atualiza(void)
 {
   static double tempo_ultima_tela = 0;
   double agora = tela_relogio();
-  double quando_mostrar = tempo_ultima_tela + SEGUNDOS_POR_QUADRO;
+  double quando_mostrar = tempo_ultima_tela + segundos_por_quadro;
   double tempo_ate_mostrar = quando_mostrar - agora;
   if (tempo_ate_mostrar > 0) {
     // é muito cedo, dá uma cochilada
@@ -101,15 +178,46 @@ void tela_atualiza(void)
   }
   // troca a tela mostrada pela que foi desenhada em memória
   al_flip_display();
+  double anterior = tempo_ultima_tela;
   tempo_ultima_tela = tela_relogio();
 
+  if (anterior > 0)
+    observa_histograma(&metricas.tempo_quadro, tempo_ultima_tela - anterior);
+  observa_histograma(&metricas.desenhos_quadro, desenhos_no_quadro);
+  conta_metrica(&metricas.quadros);
+  atomic_fetch_add_explicit(&metricas.desenhos, desenhos_no_quadro, memory_order_relaxed);
+  desenhos_no_quadro = 0;
+
+  // a janela mudou de tamanho: o allegro precisa saber que a mudança foi vista, e
+  // as fontes nos tamanhos antigos não servem mais
+  ALLEGRO_EVENT ev;
+  while (al_get_next_event(eventos_janela, &ev)) {
+    if (ev.type == ALLEGRO_EVENT_DISPLAY_RESIZE) {
+      al_acknowledge_resize(janela);
+      nova_largura = al_get_display_width(janela);
+      nova_altura = al_get_display_height(janela);
+      redimensionou = true;
+      descarta_fontes();
+    }
+  }
+
   // limpa todo o canvas em memória, para desenhar a próxima tela
   al_clear_to_color(cores[preto]);
 }
 
+bool tela_redimensionada(int *largura, int *altura)
+{
+  if (!redimensionou) return false;
+  redimensionou = false;
+  *largura = nova_largura;
+  *altura = nova_altura;
+  return true;
+}
+
 
 void tela_circulo(float x, float y, float r, float l, int corl, int corint)
 {
+  desenhos_no_quadro++;
   // preenche
   al_draw_filled_circle(x, y, r, cores[corint]);
   // faz o contorno
@@ -118,12 +226,14 @@ void tela_circulo(float x, float y, float r, float l, int corl, int corint)
 
 void tela_linha(float x1, float y1, float x2, float y2, float l, int corl)
 {
+  desenhos_no_quadro++;
   al_draw_line(x1, y1, x2, y2, cores[corl], l);
 }
 
 void tela_retangulo(float x1, float y1, float x2, float y2, float l,
                     int corl, int corint)
 {
+  desenhos_no_quadro++;
   al_draw_filled_rectangle(x1, y1, x2, y2, cores[corint]);
   al_draw_rectangle(x1, y1, x2, y2, cores[corl], l);
 }
@@ -133,46 +243,83 @@ static ALLEGRO_FONT *fonte = NULL;
 
 static void tela_prepara_fonte(int tam)
 {
-  static int tamanho_das_letras = 0;
-
-  // se se quer o mesmo tamanho que antes, usa a mesma
-  if (tam == tamanho_das_letras) return;
-
-  // se ja tinha uma fonte carregada, livra-se dela antes de carregar outra
-  if (fonte != NULL) {
-    al_destroy_font(fonte);
-  }
-
-  // carrega uma fonte, para poder escrever na tela
-  fonte = al_load_font("DejaVuSans.ttf", tam, 0);
-  if (fonte == NULL) {
-    al_uninstall_system();
-    printf("\n\nERRO FATAL\n");
-    printf("ARQUIVO QUE DEFINE DESENHO DAS LETRAS (DejaVuSans.ttf) NAO ENCONTRADO.\n"
-           "COPIE ESSE ARQUIVO, OU MUDE telag.c PARA USAR UM ARQUIVO QUE EXISTA.\n\n");
-    exit(1);
+  if (tam < 1) tam = 1;
+  if (tam >= MAX_TAM_FONTE) tam = MAX_TAM_FONTE - 1;
+
+  // cada tamanho é carregado uma vez só; trocar de tamanho é só trocar de fonte
+  if (fontes[tam] == NULL) {
+    // carrega uma fonte, para poder escrever na tela
+    fontes[tam] = al_load_font("DejaVuSans.ttf", tam, 0);
+    conta_metrica(&metricas.carregamentos_fonte);
+    if (fontes[tam] == NULL) {
+      al_uninstall_system();
+      printf("\n\nERRO FATAL\n");
+      printf("ARQUIVO QUE DEFINE DESENHO DAS LETRAS (DejaVuSans.ttf) NAO ENCONTRADO.\n"
+             "COPIE ESSE ARQUIVO, OU MUDE telag.c PARA USAR UM ARQUIVO QUE EXISTA.\n\n");
+      exit(1);
+    }
   }
-  tamanho_das_letras = tam;
+  fonte = fontes[tam];
 }
 
 void tela_texto(float x, float y, int tam, int c, char t[])
 {
+  desenhos_no_quadro++;
   tela_prepara_fonte(tam);
   al_draw_text(fonte, cores[c], x, y-tam/2, ALLEGRO_ALIGN_CENTRE, t);
 }
 
 void tela_texto_esq(float x, float y, int tam, int c, char t[])
 {
+  desenhos_no_quadro++;
   tela_prepara_fonte(tam);
   al_draw_text(fonte, cores[c], x, y, ALLEGRO_ALIGN_RIGHT, t);
 }
 
 void tela_texto_dir(float x, float y, int tam, int c, char t[])
 {
+  desenhos_no_quadro++;
   tela_prepara_fonte(tam);
   al_draw_text(fonte, cores[c], x, y, ALLEGRO_ALIGN_LEFT, t);
 }
 
+int tela_cria_camada(int largura, int altura)
+{
+  if (n_camadas == MAX_CAMADAS) cai_fora("camadas demais");
+  ALLEGRO_BITMAP *b = al_create_bitmap(largura, altura);
+  if (b == NULL) cai_fora("problema na criação de uma camada");
+  camadas[n_camadas] = b;
+  return n_camadas++;
+}
+
+void tela_redimensiona_camada(int camada, int largura, int altura)
+{
+  ALLEGRO_BITMAP *b = al_create_bitmap(largura, altura);
+  if (b == NULL) cai_fora("problema na criação de uma camada");
+  al_destroy_bitmap(camadas[camada]);
+  camadas[camada] = b;
+}
+
+void tela_desenha_em_camada(int camada)
+{
+  if (camada < 0)
+    al_set_target_backbuffer(janela);
+  else
+    al_set_target_bitmap(camadas[camada]);
+}
+
+void tela_limpa(void)
+{
+  al_clear_to_color(cores[preto]);
+}
+
+void tela_mostra_camada(int camada, float x, float y, float largura, float altura)
+{
+  desenhos_no_quadro++;
+  ALLEGRO_BITMAP *b = camadas[camada];
+  al_draw_scaled_bitmap(b, 0, 0, al_get_bitmap_width(b), al_get_bitmap_height(b), x, y, largura, altura, 0);
+}
+
 void tela_rato_pos(int *px, int *py)
 {
   ALLEGRO_MOUSE_STATE rato;
@@ -230,6 +377,33 @@ char tela_tecla(void)
 }
 
 
+char tela_espera_tecla(double segundos)
+{
+  ALLEGRO_EVENT ev;
+  double limite = al_get_time() + segundos;
+  double falta;
+
+  while ((falta = limite - al_get_time()) > 0) {
+    if (!al_wait_for_event_timed(tela_eventos_teclado, &ev, falta)) break;
+    if (ev.type == EVENTO_ACORDA) break;
+    if (ev.type == ALLEGRO_EVENT_KEY_CHAR) {
+      switch (ev.keyboard.keycode) {
+        case ALLEGRO_KEY_ENTER:     return '\n';
+        case ALLEGRO_KEY_BACKSPACE: return '\b';
+      }
+      if (ev.keyboard.unichar != 0) return ev.keyboard.unichar;
+    }
+  }
+  return '\0';
+}
+
+void tela_acorda(void)
+{
+  ALLEGRO_EVENT ev;
+  ev.user.type = EVENTO_ACORDA;
+  al_emit_user_event(&fonte_acorda, &ev, NULL);
+}
+
 double tela_relogio(void)
 {
   return al_get_time();
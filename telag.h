@@ -31,10 +31,22 @@ void tela_fim(void);
 // o conteúdo da nova imagem fica só na memória.
 void tela_atualiza(void);
 
-// frequencia de atualizacao da tela
+// retorna se a janela mudou de tamanho desde a última chamada, colocando o novo
+// tamanho em pixels em largura e altura
+// a mudança (o usuário arrastando a borda da janela) é percebida em tela_atualiza(),
+// então tudo o que depende do tamanho pode ser refeito antes de desenhar o próximo quadro
+bool tela_redimensionada(int *largura, int *altura);
+
+// frequencia de atualizacao da tela, até ser mudada por tela_limita_quadros()
 #define QUADROS_POR_SEGUNDO 30.0
 #define SEGUNDOS_POR_QUADRO (1/QUADROS_POR_SEGUNDO)
 
+// muda quantos quadros por segundo tela_atualiza() mostra, no máximo a frequência do
+// monitor; 0 usa a frequência do monitor. a janela pede vsync, e na frequência do
+// monitor a espera termina um pouco antes do quadro e a troca das imagens espera o resto
+// retorna a frequência que vai ser usada
+double tela_limita_quadros(double quadros_por_segundo);
+
 // DESENHO
 
 // desenha um círculo
@@ -70,6 +82,27 @@ void tela_texto_dir(float x, float y, int tam, int c, char t[]);
 
 
 
+// CAMADAS
+
+// uma camada é uma imagem fora da tela, do tamanho dado em pixels, onde se pode
+// desenhar como na tela; ela só precisa ser redesenhada quando o que mostra muda,
+// e é copiada (em qualquer escala) para a tela a cada quadro
+// retorna o número da camada
+int tela_cria_camada(int largura, int altura);
+
+// passa a desenhar na camada dada, ou na tela se a camada for -1
+void tela_desenha_em_camada(int camada);
+
+// pinta de preto todo o lugar onde se está desenhando (tela ou camada)
+void tela_limpa(void);
+
+// muda o tamanho de uma camada; o que estava desenhado nela se perde
+void tela_redimensiona_camada(int camada, int largura, int altura);
+
+// copia a camada para o retângulo da tela com canto superior esquerdo x, y e o tamanho dado
+void tela_mostra_camada(int camada, float x, float y, float largura, float altura);
+
+
 // CORES
 
 // valores para representar cores pré-definidas
@@ -110,6 +143,14 @@ void tela_rato_pos_clique(int *px, int *py);
 // se for digitado backspace, retorna '\b'
 char tela_tecla(void);
 
+// como tela_tecla(), mas espera até segundos por uma tecla antes de retornar '\0'
+// pode ser chamada por outra thread enquanto a principal desenha
+char tela_espera_tecla(double segundos);
+
+// faz uma tela_espera_tecla() em andamento (ou a próxima) retornar '\0' sem esperar
+// pode ser chamada de qualquer thread, para avisar a que espera que há algo a fazer
+void tela_acorda(void);
+
 
 // TEMPO
 
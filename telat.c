@@ -0,0 +1,878 @@
+//
+// telat.c
+// -------
+//
+// as funções de telag.h em um terminal de texto, sem servidor gráfico
+// (por exemplo através de ssh)
+//
+// as coordenadas em pixels são convertidas em linhas e colunas do terminal,
+// e os desenhos são feitos em uma cópia da tela na memória; tela_atualiza()
+// compara essa cópia com o que o terminal já mostra e só escreve, com
+// sequências ANSI, as células que mudaram
+//
+// o mouse vem do próprio terminal (modo SGR do xterm), em células que são
+// convertidas de volta em pixels
+//
+
+// inclui as definicoes
+#include "telag.h"
+#include "metricas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <math.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+
+// tamanho usado se não for possível saber o tamanho do terminal
+#define COLUNAS_PADRAO 80
+#define LINHAS_PADRAO 24
+
+static void cai_fora(char *msg)
+{
+  int cai = 42;
+  int fora = 42;
+  printf("\n\nERRO\n%s\n\n", msg);
+  assert(cai-fora);
+}
+
+// uma célula do terminal: o caractere (em UTF-8) e as cores, em RGB
+typedef struct {
+  char c[4];
+  uint32_t frente;
+  uint32_t fundo;
+} celula_t;
+
+// a grade de células da tela, com o tamanho em pixels que representa
+typedef struct {
+  celula_t *celulas;
+  int colunas;
+  int linhas;
+  float largura;
+  float altura;
+} grade_t;
+
+typedef enum {
+  comando_circulo,
+  comando_linha,
+  comando_retangulo,
+  comando_texto,
+  comando_texto_esq,
+  comando_texto_dir,
+  comando_camada
+} tipo_comando_t;
+
+// um desenho gravado em uma camada, com as coordenadas em pixels da camada
+typedef struct {
+  tipo_comando_t tipo;
+  float v[5];
+  // cores, ou o número da camada mostrada
+  int a;
+  int b;
+  // posição do texto em textos da camada
+  size_t texto;
+} comando_t;
+
+// uma camada guarda os desenhos, e não as células: ela pode aparecer na tela
+// reduzida, e refazer os desenhos no tamanho final mantém os textos legíveis
+typedef struct {
+  comando_t *comandos;
+  int n_comandos;
+  int cap_comandos;
+  char *textos;
+  size_t tam_textos;
+  size_t cap_textos;
+  float largura;
+  float altura;
+} camada_t;
+
+// vetor com as cores, em RGB, e a opacidade de cada uma
+#define NCORES 100 // número máximo de cores diferentes
+static uint32_t cores[NCORES];
+static float opacidades[NCORES];
+
+// a tela sendo desenhada e o que o terminal mostra agora
+static grade_t tela;
+static celula_t *no_terminal = NULL;
+// se o terminal não mostra nada conhecido (início ou mudança de tamanho)
+static bool terminal_desconhecido = true;
+static volatile sig_atomic_t redimensionou = 0;
+
+// camadas criadas por tela_cria_camada()
+#define MAX_CAMADAS 16
+static camada_t camadas[MAX_CAMADAS];
+static int n_camadas = 0;
+// onde se está desenhando: a camada, ou -1 para a tela
+static int alvo = -1;
+
+// texto a escrever no terminal de uma vez, no fim de cada quadro
+static char *saida = NULL;
+static size_t tam_saida = 0;
+static size_t cap_saida = 0;
+
+static struct termios termios_original;
+static bool terminal_preparado = false;
+
+// chamadas de desenho desde a última atualização da tela, para as métricas
+static int desenhos_no_quadro = 0;
+
+// o mouse, atualizado por quem lê o teclado e lido por quem desenha
+static _Atomic int rato_x = -1, rato_y = -1;
+static _Atomic bool rato_botao = false;
+// um aperto ainda não visto por tela_rato_apertado(), para cliques mais curtos que um quadro
+static _Atomic bool rato_apertou = false;
+static _Atomic bool rato_clicou = false;
+static _Atomic int clique_x = -1, clique_y = -1;
+
+// canal de tela_acorda(): escrever nele interrompe a espera por uma tecla
+static int acorda[2] = { -1, -1 };
+
+void tela_altera_cor(int cor,
+                     float vm, float az, float vd, float opacidade)
+{
+  assert(cor >= 0 && cor < NCORES);
+  cores[cor] = (uint32_t)(vm * 255 + 0.5) << 16 | (uint32_t)(az * 255 + 0.5) << 8 | (uint32_t)(vd * 255 + 0.5);
+  opacidades[cor] = opacidade;
+}
+
+static void tela_inicializa_cores(void)
+{
+  tela_altera_cor(transparente, 0, 0, 0, 0);
+  tela_altera_cor(azul, 0, 0, 1, 1);
+  tela_altera_cor(vermelho, 1, 0, 0, 1);
+  tela_altera_cor(verde, 0, 1, 0, 1);
+  tela_altera_cor(amarelo, 1, 1, 0, 1);
+  tela_altera_cor(preto, 0, 0, 0, 1);
+  tela_altera_cor(laranja, 1, 0.65, 0, 1);
+  tela_altera_cor(rosa, 1, 0, 0.5, 1);
+  tela_altera_cor(branco, 1, 1, 1, 1);
+  tela_altera_cor(marrom, 0.58, 0.29, 0, 1);
+}
+
+// cor mais próxima entre as 216 do cubo de cores dos terminais de 256 cores
+static int cor_do_terminal(uint32_t rgb)
+{
+  int r = ((rgb >> 16 & 0xff) * 5 + 127) / 255;
+  int g = ((rgb >> 8 & 0xff) * 5 + 127) / 255;
+  int b = ((rgb & 0xff) * 5 + 127) / 255;
+  return 16 + 36 * r + 6 * g + b;
+}
+
+// mistura a cor c sobre a cor de baixo, com a opacidade dada
+static uint32_t mistura(uint32_t baixo, uint32_t c, float opacidade)
+{
+  uint32_t r = 0;
+  for (int s = 0; s < 24; s += 8) {
+    float v = (baixo >> s & 0xff) * (1 - opacidade) + (c >> s & 0xff) * opacidade;
+    r |= (uint32_t)(v + 0.5) << s;
+  }
+  return r;
+}
+
+static void escreve(const char *s, size_t n)
+{
+  if (tam_saida + n > cap_saida) {
+    cap_saida = 2 * (tam_saida + n);
+    saida = realloc(saida, cap_saida);
+    if (saida == NULL) cai_fora("sem memória para a saída do terminal");
+  }
+  memcpy(saida + tam_saida, s, n);
+  tam_saida += n;
+}
+
+static void escreve_texto(const char *s)
+{
+  escreve(s, strlen(s));
+}
+
+// manda para o terminal tudo o que foi juntado na saída
+static void envia_saida(void)
+{
+  size_t enviado = 0;
+  while (enviado < tam_saida) {
+    ssize_t n = write(STDOUT_FILENO, saida + enviado, tam_saida - enviado);
+    if (n <= 0) break;
+    enviado += n;
+  }
+  atomic_fetch_add_explicit(&metricas.bytes_terminal, enviado, memory_order_relaxed);
+  tam_saida = 0;
+}
+
+static void limpa_grade(grade_t *g)
+{
+  for (int i = 0; i < g->colunas * g->linhas; i++)
+    g->celulas[i] = (celula_t){ " ", cores[preto], cores[preto] };
+}
+
+static void cria_grade(grade_t *g, int colunas, int linhas, float largura, float altura)
+{
+  if (colunas < 1) colunas = 1;
+  if (linhas < 1) linhas = 1;
+  g->celulas = malloc((size_t)colunas * linhas * sizeof(celula_t));
+  if (g->celulas == NULL) cai_fora("sem memória para a tela de texto");
+  g->colunas = colunas;
+  g->linhas = linhas;
+  g->largura = largura;
+  g->altura = altura;
+  limpa_grade(g);
+}
+
+// coluna e linha da borda de célula mais próxima de uma coordenada em pixels (para retângulos)
+static int coluna_de(grade_t *g, float x)
+{
+  return (int)floorf(x * g->colunas / g->largura + 0.5f);
+}
+
+static int linha_de(grade_t *g, float y)
+{
+  return (int)floorf(y * g->linhas / g->altura + 0.5f);
+}
+
+// coluna e linha da célula que contém um ponto em pixels (para textos e círculos)
+static int coluna_do_ponto(grade_t *g, float x)
+{
+  return (int)floorf(x * g->colunas / g->largura);
+}
+
+static int linha_do_ponto(grade_t *g, float y)
+{
+  return (int)floorf(y * g->linhas / g->altura);
+}
+
+static celula_t *celula(grade_t *g, int col, int lin)
+{
+  if (col < 0 || col >= g->colunas || lin < 0 || lin >= g->linhas) return NULL;
+  return &g->celulas[lin * g->colunas + col];
+}
+
+// restaura o terminal como estava antes de tela_inicio()
+static void restaura_terminal(void)
+{
+  if (!terminal_preparado) return;
+  // cores normais, cursor visível, sem mouse, volta para a tela normal do terminal
+  static const char fim[] = "\x1b[0m\x1b[?25h\x1b[?1003l\x1b[?1006l\x1b[?1049l";
+  if (write(STDOUT_FILENO, fim, sizeof(fim) - 1) < 0) { }
+  tcsetattr(STDIN_FILENO, TCSAFLUSH, &termios_original);
+  terminal_preparado = false;
+}
+
+static void sai_por_sinal(int sinal)
+{
+  restaura_terminal();
+  signal(sinal, SIG_DFL);
+  raise(sinal);
+}
+
+static void trata_redimensionamento(int sinal)
+{
+  (void)sinal;
+  redimensionou = 1;
+}
+
+// tamanho do terminal, em colunas e linhas
+static void tamanho_do_terminal(int *colunas, int *linhas)
+{
+  struct winsize w;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0 && w.ws_col > 0 && w.ws_row > 0) {
+    *colunas = w.ws_col;
+    *linhas = w.ws_row;
+  } else {
+    *colunas = COLUNAS_PADRAO;
+    *linhas = LINHAS_PADRAO;
+  }
+}
+
+// refaz a tela com o tamanho atual do terminal; o próximo quadro é escrito inteiro
+static void redimensiona_tela(void)
+{
+  int colunas, linhas;
+  tamanho_do_terminal(&colunas, &linhas);
+  free(tela.celulas);
+  free(no_terminal);
+  cria_grade(&tela, colunas, linhas, tela.largura, tela.altura);
+  no_terminal = malloc((size_t)colunas * linhas * sizeof(celula_t));
+  if (no_terminal == NULL) cai_fora("sem memória para a tela de texto");
+  terminal_desconhecido = true;
+}
+
+void tela_inicio(int largura, int altura, char nome[])
+{
+  if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &termios_original) != 0)
+    cai_fora("a tela de texto precisa de um terminal");
+  // teclas chegam uma a uma, sem eco; ctrl-c continua funcionando
+  struct termios t = termios_original;
+  t.c_lflag &= ~(ICANON | ECHO);
+  t.c_iflag &= ~(ICRNL | IXON);
+  t.c_cc[VMIN] = 0;
+  t.c_cc[VTIME] = 0;
+  tcsetattr(STDIN_FILENO, TCSAFLUSH, &t);
+  terminal_preparado = true;
+  atexit(restaura_terminal);
+  signal(SIGINT, sai_por_sinal);
+  signal(SIGTERM, sai_por_sinal);
+  signal(SIGWINCH, trata_redimensionamento);
+
+  if (acorda[0] < 0) {
+    if (pipe(acorda) != 0) cai_fora("problema na criação do canal para acordar");
+    // com o canal cheio, tela_acorda() não espera: já há um aviso pendente
+    fcntl(acorda[1], F_SETFL, O_NONBLOCK);
+  }
+
+  tela_inicializa_cores();
+  tela.largura = largura;
+  tela.altura = altura;
+  redimensiona_tela();
+
+  // tela alternativa do terminal, cursor escondido, todos os movimentos do mouse
+  // em coordenadas decimais (SGR), título da janela
+  escreve_texto("\x1b[?1049h\x1b[?25l\x1b[?1003h\x1b[?1006h\x1b]0;");
+  escreve_texto(nome);
+  escreve_texto("\x07");
+  envia_saida();
+}
+
+void tela_fim(void)
+{
+  for (int i = 0; i < n_camadas; i++) {
+    free(camadas[i].comandos);
+    free(camadas[i].textos);
+  }
+  n_camadas = 0;
+  alvo = -1;
+  restaura_terminal();
+  free(tela.celulas);
+  free(no_terminal);
+  free(saida);
+  tela.celulas = no_terminal = NULL;
+  saida = NULL;
+  tam_saida = cap_saida = 0;
+}
+
+// escreve no terminal as células que mudaram desde o quadro anterior
+static void escreve_diferencas(void)
+{
+  // o que o terminal tem agora: posição do cursor e cores (-1 se não se sabe)
+  static int cursor_lin = -1, cursor_col = -1;
+  static int cor_frente = -1, cor_fundo = -1;
+  char seq[48];
+
+  if (terminal_desconhecido) {
+    escreve_texto("\x1b[0m\x1b[2J");
+    cursor_lin = cursor_col = cor_frente = cor_fundo = -1;
+  }
+  for (int lin = 0; lin < tela.linhas; lin++) {
+    for (int col = 0; col < tela.colunas; col++) {
+      int i = lin * tela.colunas + col;
+      celula_t *c = &tela.celulas[i];
+      if (!terminal_desconhecido && memcmp(c, &no_terminal[i], sizeof(celula_t)) == 0) continue;
+
+      // na mesma linha, andar para a direita é mais curto que posicionar o cursor
+      if (lin == cursor_lin && col == cursor_col + 1)
+        escreve_texto("\x1b[C");
+      else if (lin == cursor_lin && col > cursor_col && cursor_col >= 0)
+        escreve(seq, sprintf(seq, "\x1b[%dC", col - cursor_col));
+      else if (lin != cursor_lin || col != cursor_col)
+        escreve(seq, sprintf(seq, "\x1b[%d;%dH", lin + 1, col + 1));
+      int frente = cor_do_terminal(c->frente), fundo = cor_do_terminal(c->fundo);
+      if (frente != cor_frente && fundo != cor_fundo)
+        escreve(seq, sprintf(seq, "\x1b[38;5;%d;48;5;%dm", frente, fundo));
+      else if (frente != cor_frente)
+        escreve(seq, sprintf(seq, "\x1b[38;5;%dm", frente));
+      else if (fundo != cor_fundo)
+        escreve(seq, sprintf(seq, "\x1b[48;5;%dm", fundo));
+      cor_frente = frente;
+      cor_fundo = fundo;
+      escreve(c->c, strnlen(c->c, sizeof(c->c)));
+      no_terminal[i] = *c;
+
+      cursor_lin = lin;
+      // depois da última coluna o terminal pode ou não ter passado para a próxima linha
+      cursor_col = col + 1 < tela.colunas ? col + 1 : -1;
+    }
+  }
+  terminal_desconhecido = false;
+}
+
+// dorme pelos segundos dados
+static void cochila(double segundos)
+{
+  struct timespec t;
+  t.tv_sec = (time_t)segundos;
+  t.tv_nsec = (long)((segundos - t.tv_sec) * 1e9);
+  nanosleep(&t, NULL);
+}
+
+// intervalo entre dois quadros
+static double segundos_por_quadro = SEGUNDOS_POR_QUADRO;
+
+// o terminal não informa a frequência do monitor: 0 fica com a frequência padrão
+double tela_limita_quadros(double quadros_por_segundo)
+{
+  if (quadros_por_segundo <= 0)
+    quadros_por_segundo = QUADROS_POR_SEGUNDO;
+  segundos_por_quadro = 1 / quadros_por_segundo;
+  return quadros_por_segundo;
+}
+
+void tela_atualiza(void)
+{
+  static double tempo_ultima_tela = 0;
+  double agora = tela_relogio();
+  double quando_mostrar = tempo_ultima_tela + segundos_por_quadro;
+  double tempo_ate_mostrar = quando_mostrar - agora;
+  if (tempo_ate_mostrar > 0) {
+    // é muito cedo, dá uma cochilada
+    cochila(tempo_ate_mostrar);
+  }
+  // só as diferenças vão para o terminal
+  escreve_diferencas();
+  envia_saida();
+  double anterior = tempo_ultima_tela;
+  tempo_ultima_tela = tela_relogio();
+
+  if (anterior > 0)
+    observa_histograma(&metricas.tempo_quadro, tempo_ultima_tela - anterior);
+  observa_histograma(&metricas.desenhos_quadro, desenhos_no_quadro);
+  conta_metrica(&metricas.quadros);
+  atomic_fetch_add_explicit(&metricas.desenhos, desenhos_no_quadro, memory_order_relaxed);
+  desenhos_no_quadro = 0;
+
+  if (redimensionou) {
+    redimensionou = 0;
+    redimensiona_tela();
+  }
+  // limpa toda a tela em memória, para desenhar a próxima
+  limpa_grade(&tela);
+}
+
+// o tamanho em pixels é sempre o pedido em tela_inicio(): quando o terminal muda de
+// tamanho, muda só a quantidade de pixels que cada célula representa
+bool tela_redimensionada(int *largura, int *altura)
+{
+  (void)largura;
+  (void)altura;
+  return false;
+}
+
+// pinta o fundo da célula com a cor, misturando se ela for translúcida
+static void pinta_fundo(celula_t *c, int cor)
+{
+  float o = opacidades[cor];
+  if (o <= 0) return;
+  if (o >= 1) {
+    memset(c->c, 0, sizeof(c->c));
+    c->c[0] = ' ';
+    c->fundo = cores[cor];
+  } else {
+    c->frente = mistura(c->frente, cores[cor], o);
+    c->fundo = mistura(c->fundo, cores[cor], o);
+  }
+}
+
+// escreve um caractere (em UTF-8) na célula, com a cor dada na frente
+static void escreve_caractere(celula_t *c, const char *car, int n, int cor)
+{
+  if (c == NULL || opacidades[cor] <= 0) return;
+  memset(c->c, 0, sizeof(c->c));
+  memcpy(c->c, car, n);
+  c->frente = cores[cor];
+}
+
+// transformação das coordenadas ao mostrar uma camada: pixels da camada para pixels da tela
+static float escala_x = 1, escala_y = 1, desloc_x = 0, desloc_y = 0;
+
+static float tx(float x)
+{
+  return x * escala_x + desloc_x;
+}
+
+static float ty(float y)
+{
+  return y * escala_y + desloc_y;
+}
+
+// guarda um comando na camada onde se está desenhando; retorna false se o desenho é na tela
+static bool grava_comando(tipo_comando_t tipo, float v0, float v1, float v2, float v3, float v4,
+                          int a, int b, const char *t)
+{
+  if (alvo < 0) return false;
+  camada_t *cm = &camadas[alvo];
+  if (cm->n_comandos == cm->cap_comandos) {
+    cm->cap_comandos = cm->cap_comandos == 0 ? 64 : 2 * cm->cap_comandos;
+    cm->comandos = realloc(cm->comandos, cm->cap_comandos * sizeof(comando_t));
+    if (cm->comandos == NULL) cai_fora("sem memória para uma camada");
+  }
+  comando_t *c = &cm->comandos[cm->n_comandos++];
+  *c = (comando_t){ tipo, { v0, v1, v2, v3, v4 }, a, b, cm->tam_textos };
+  if (t != NULL) {
+    size_t n = strlen(t) + 1;
+    if (cm->tam_textos + n > cm->cap_textos) {
+      cm->cap_textos = 2 * (cm->tam_textos + n);
+      cm->textos = realloc(cm->textos, cm->cap_textos);
+      if (cm->textos == NULL) cai_fora("sem memória para uma camada");
+    }
+    memcpy(cm->textos + cm->tam_textos, t, n);
+    cm->tam_textos += n;
+  }
+  return true;
+}
+
+static void desenha_circulo(float x, float y, float r, int corint)
+{
+  int col = coluna_do_ponto(&tela, tx(x)), lin = linha_do_ponto(&tela, ty(y));
+  int rc = (int)(r * escala_x * tela.colunas / tela.largura);
+  int rl = (int)(r * escala_y * tela.linhas / tela.altura);
+  // um círculo menor que uma célula vira uma bolinha
+  if (rc == 0 || rl == 0) {
+    escreve_caractere(celula(&tela, col, lin), "●", strlen("●"), corint);
+    return;
+  }
+  for (int dl = -rl; dl <= rl; dl++) {
+    for (int dc = -rc; dc <= rc; dc++) {
+      celula_t *c = celula(&tela, col + dc, lin + dl);
+      if (c != NULL && (float)dc * dc / (rc * rc) + (float)dl * dl / (rl * rl) <= 1)
+        pinta_fundo(c, corint);
+    }
+  }
+}
+
+static void desenha_linha(float x1, float y1, float x2, float y2, int corl)
+{
+  int c1 = coluna_do_ponto(&tela, tx(x1)), l1 = linha_do_ponto(&tela, ty(y1));
+  int c2 = coluna_do_ponto(&tela, tx(x2)), l2 = linha_do_ponto(&tela, ty(y2));
+  const char *car = l1 == l2 ? "─" : c1 == c2 ? "│" : "·";
+  int passos = abs(c2 - c1) > abs(l2 - l1) ? abs(c2 - c1) : abs(l2 - l1);
+  for (int i = 0; i <= passos; i++) {
+    int col = passos == 0 ? c1 : c1 + (c2 - c1) * i / passos;
+    int lin = passos == 0 ? l1 : l1 + (l2 - l1) * i / passos;
+    escreve_caractere(celula(&tela, col, lin), car, strlen(car), corl);
+  }
+}
+
+static void desenha_retangulo(float x1, float y1, float x2, float y2, float l, int corl, int corint)
+{
+  int c1 = coluna_de(&tela, tx(x1)), c2 = coluna_de(&tela, tx(x2)) - 1;
+  int l1 = linha_de(&tela, ty(y1)), l2 = linha_de(&tela, ty(y2)) - 1;
+  if (c2 < c1) c2 = c1;
+  if (l2 < l1) l2 = l1;
+
+  for (int lin = l1; lin <= l2; lin++) {
+    for (int col = c1; col <= c2; col++) {
+      celula_t *c = celula(&tela, col, lin);
+      if (c != NULL) pinta_fundo(c, corint);
+    }
+  }
+
+  // o contorno, com os caracteres de desenho de caixas
+  if (l <= 0 || c2 - c1 < 1 || l2 - l1 < 1) return;
+  for (int col = c1 + 1; col < c2; col++) {
+    escreve_caractere(celula(&tela, col, l1), "─", 3, corl);
+    escreve_caractere(celula(&tela, col, l2), "─", 3, corl);
+  }
+  for (int lin = l1 + 1; lin < l2; lin++) {
+    escreve_caractere(celula(&tela, c1, lin), "│", 3, corl);
+    escreve_caractere(celula(&tela, c2, lin), "│", 3, corl);
+  }
+  escreve_caractere(celula(&tela, c1, l1), "┌", 3, corl);
+  escreve_caractere(celula(&tela, c2, l1), "┐", 3, corl);
+  escreve_caractere(celula(&tela, c1, l2), "└", 3, corl);
+  escreve_caractere(celula(&tela, c2, l2), "┘", 3, corl);
+}
+
+// número de caracteres (não de bytes) de um texto em UTF-8
+static int caracteres_utf8(const char *t)
+{
+  int n = 0;
+  for (; *t != '\0'; t++)
+    if ((*t & 0xc0) != 0x80) n++;
+  return n;
+}
+
+// escreve o texto a partir da coluna dada, um caractere por célula
+static void escreve_linha_texto(int col, int lin, int c, const char *t)
+{
+  while (*t != '\0') {
+    int n = 1;
+    while ((t[n] & 0xc0) == 0x80 && n < 4) n++;
+    escreve_caractere(celula(&tela, col++, lin), t, n, c);
+    t += n;
+  }
+}
+
+// o texto não muda de tamanho no terminal; o tamanho da letra só serve para achar a linha do meio do texto
+static void desenha_texto(tipo_comando_t tipo, float x, float y, int tam, int c, const char *t)
+{
+  int col = coluna_do_ponto(&tela, tx(x));
+  if (tipo == comando_texto) {
+    escreve_linha_texto(col - (caracteres_utf8(t) - 1) / 2, linha_do_ponto(&tela, ty(y)), c, t);
+    return;
+  }
+  int lin = linha_do_ponto(&tela, ty(y + tam / 2));
+  if (tipo == comando_texto_esq)
+    escreve_linha_texto(col - caracteres_utf8(t), lin, c, t);
+  else
+    escreve_linha_texto(col, lin, c, t);
+}
+
+static void desenha_camada(int camada, float x, float y, float largura, float altura);
+
+// refaz um comando gravado em uma camada
+static void refaz_comando(camada_t *cm, comando_t *c)
+{
+  float *v = c->v;
+  switch (c->tipo) {
+    case comando_circulo:   desenha_circulo(v[0], v[1], v[2], c->b); break;
+    case comando_linha:     desenha_linha(v[0], v[1], v[2], v[3], c->a); break;
+    case comando_retangulo: desenha_retangulo(v[0], v[1], v[2], v[3], v[4], c->a, c->b); break;
+    case comando_texto:
+    case comando_texto_esq:
+    case comando_texto_dir: desenha_texto(c->tipo, v[0], v[1], (int)v[2], c->a, cm->textos + c->texto); break;
+    case comando_camada:    desenha_camada(c->a, v[0], v[1], v[2], v[3]); break;
+  }
+}
+
+// refaz os comandos da camada com a transformação que leva a camada ao retângulo dado
+static void desenha_camada(int camada, float x, float y, float largura, float altura)
+{
+  camada_t *cm = &camadas[camada];
+  float ex = escala_x, ey = escala_y, dx = desloc_x, dy = desloc_y;
+  desloc_x = tx(x);
+  desloc_y = ty(y);
+  escala_x = ex * largura / cm->largura;
+  escala_y = ey * altura / cm->altura;
+  for (int i = 0; i < cm->n_comandos; i++)
+    refaz_comando(cm, &cm->comandos[i]);
+  escala_x = ex;
+  escala_y = ey;
+  desloc_x = dx;
+  desloc_y = dy;
+}
+
+void tela_circulo(float x, float y, float r, float l, int corl, int corint)
+{
+  desenhos_no_quadro++;
+  if (grava_comando(comando_circulo, x, y, r, l, 0, corl, corint, NULL)) return;
+  desenha_circulo(x, y, r, corint);
+}
+
+void tela_linha(float x1, float y1, float x2, float y2, float l, int corl)
+{
+  desenhos_no_quadro++;
+  if (grava_comando(comando_linha, x1, y1, x2, y2, l, corl, 0, NULL)) return;
+  desenha_linha(x1, y1, x2, y2, corl);
+}
+
+void tela_retangulo(float x1, float y1, float x2, float y2, float l,
+                    int corl, int corint)
+{
+  desenhos_no_quadro++;
+  if (grava_comando(comando_retangulo, x1, y1, x2, y2, l, corl, corint, NULL)) return;
+  desenha_retangulo(x1, y1, x2, y2, l, corl, corint);
+}
+
+void tela_texto(float x, float y, int tam, int c, char t[])
+{
+  desenhos_no_quadro++;
+  if (grava_comando(comando_texto, x, y, tam, 0, 0, c, 0, t)) return;
+  desenha_texto(comando_texto, x, y, tam, c, t);
+}
+
+void tela_texto_esq(float x, float y, int tam, int c, char t[])
+{
+  desenhos_no_quadro++;
+  if (grava_comando(comando_texto_esq, x, y, tam, 0, 0, c, 0, t)) return;
+  desenha_texto(comando_texto_esq, x, y, tam, c, t);
+}
+
+void tela_texto_dir(float x, float y, int tam, int c, char t[])
+{
+  desenhos_no_quadro++;
+  if (grava_comando(comando_texto_dir, x, y, tam, 0, 0, c, 0, t)) return;
+  desenha_texto(comando_texto_dir, x, y, tam, c, t);
+}
+
+int tela_cria_camada(int largura, int altura)
+{
+  if (n_camadas == MAX_CAMADAS) cai_fora("camadas demais");
+  camadas[n_camadas] = (camada_t){ .largura = largura, .altura = altura };
+  return n_camadas++;
+}
+
+void tela_redimensiona_camada(int camada, int largura, int altura)
+{
+  camada_t *cm = &camadas[camada];
+  cm->largura = largura;
+  cm->altura = altura;
+  cm->n_comandos = 0;
+  cm->tam_textos = 0;
+}
+
+void tela_desenha_em_camada(int camada)
+{
+  alvo = camada;
+}
+
+void tela_limpa(void)
+{
+  if (alvo < 0) {
+    limpa_grade(&tela);
+  } else {
+    camadas[alvo].n_comandos = 0;
+    camadas[alvo].tam_textos = 0;
+  }
+}
+
+// a camada é refeita no tamanho em que aparece, então os textos continuam inteiros
+void tela_mostra_camada(int camada, float x, float y, float largura, float altura)
+{
+  desenhos_no_quadro++;
+  if (grava_comando(comando_camada, x, y, largura, altura, 0, camada, 0, NULL)) return;
+  desenha_camada(camada, x, y, largura, altura);
+}
+
+void tela_rato_pos(int *px, int *py)
+{
+  *px = rato_x;
+  *py = rato_y;
+}
+
+bool tela_rato_apertado(void)
+{
+  bool apertou = atomic_exchange(&rato_apertou, false);
+  return rato_botao || apertou;
+}
+
+bool tela_rato_clicado(void)
+{
+  return atomic_exchange(&rato_clicou, false);
+}
+
+void tela_rato_pos_clique(int *px, int *py)
+{
+  *px = clique_x;
+  *py = clique_y;
+}
+
+// lê um byte da entrada, se já tiver chegado
+static bool le_byte(unsigned char *c)
+{
+  struct pollfd p = { .fd = STDIN_FILENO, .events = POLLIN };
+  return poll(&p, 1, 0) > 0 && read(STDIN_FILENO, c, 1) == 1;
+}
+
+// lê um número decimal da entrada; retorna o caractere que vem depois dele
+static unsigned char le_numero(int *n)
+{
+  unsigned char c = '\0';
+  *n = 0;
+  while (le_byte(&c) && c >= '0' && c <= '9')
+    *n = *n * 10 + c - '0';
+  return c;
+}
+
+// trata um evento do mouse no formato SGR ("\x1b[<botão;coluna;linha" e 'M' ou 'm'),
+// já lido até o '<'; só o botão da esquerda e os movimentos interessam
+static void le_rato(void)
+{
+  int b, col, lin;
+  if (le_numero(&b) != ';' || le_numero(&col) != ';') return;
+  unsigned char fim = le_numero(&lin);
+  if (fim != 'M' && fim != 'm') return;
+  // o centro da célula, em pixels
+  rato_x = (col - 0.5f) * tela.largura / tela.colunas;
+  rato_y = (lin - 0.5f) * tela.altura / tela.linhas;
+  // movimentos e rodinha só mudam a posição; dos botões, só o da esquerda interessa
+  if ((b & (32 | 64)) != 0 || (b & 3) != 0) return;
+  if (fim == 'M') {
+    rato_botao = true;
+    rato_apertou = true;
+  } else {
+    if (rato_botao) {
+      clique_x = rato_x;
+      clique_y = rato_y;
+      rato_clicou = true;
+    }
+    rato_botao = false;
+  }
+}
+
+// lê uma tecla, se houver uma em até ms milissegundos (-1 espera para sempre)
+// se acordou não for NULL, também para quando tela_acorda() é chamada, e marca isso nele
+static char le_tecla(int ms, bool *acordou)
+{
+  struct pollfd p[2] = { { .fd = STDIN_FILENO, .events = POLLIN }, { .fd = acorda[0], .events = POLLIN } };
+  unsigned char c;
+  if (poll(p, acordou != NULL ? 2 : 1, ms) <= 0) return '\0';
+  if (acordou != NULL && (p[1].revents & POLLIN)) {
+    char lixo[64];
+    if (read(acorda[0], lixo, sizeof(lixo)) < 0) { }
+    *acordou = true;
+    return '\0';
+  }
+  if (read(STDIN_FILENO, &c, 1) != 1) return '\0';
+  switch (c) {
+    case '\r':
+    case '\n': return '\n';
+    case 127:
+    case '\b': return '\b';
+    case 27: {
+      // mouse, ou outra sequência de escape (setas, teclas de função), que é descartada
+      if (le_byte(&c) && c == '[' && le_byte(&c) && c == '<') {
+        le_rato();
+        return '\0';
+      }
+      while (le_byte(&c)) { }
+      return '\0';
+    }
+  }
+  return c;
+}
+
+// eventos tratados no máximo em uma chamada a tela_tecla(), para um terminal que
+// fechou (sempre pronto para leitura, sem nada para ler) não prender o laço
+#define MAX_EVENTOS_POR_TECLA 1024
+
+// o mouse manda um evento a cada célula por onde passa: todos os que chegaram desde o
+// último quadro são tratados de uma vez, até a primeira tecla, para nada ficar atrasado
+char tela_tecla(void)
+{
+  struct pollfd p = { .fd = STDIN_FILENO, .events = POLLIN };
+  for (int i = 0; i < MAX_EVENTOS_POR_TECLA && poll(&p, 1, 0) > 0 && (p.revents & POLLIN); i++) {
+    char c = le_tecla(0, NULL);
+    if (c != '\0') return c;
+  }
+  return '\0';
+}
+
+char tela_espera_tecla(double segundos)
+{
+  double limite = tela_relogio() + segundos;
+  double falta;
+  bool acordou = false;
+
+  while (!acordou && (falta = limite - tela_relogio()) > 0) {
+    char c = le_tecla((int)(falta * 1000) + 1, &acordou);
+    if (c != '\0') return c;
+  }
+  return '\0';
+}
+
+void tela_acorda(void)
+{
+  if (write(acorda[1], "", 1) < 0) { }
+}
+
+double tela_relogio(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file telemetria.c
+ *
+ * @brief Eventos das partidas (início, jogadas, fim) gravados em um registro binário.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "telemetria.h"
+#include <unistd.h>
+
+// fecha o arquivo atual e abre o próximo, apagando o que sai da janela de arquivos mantidos
+static bool troca_arquivo(telemetria_t *t)
+{
+  char nome[1024];
+  if (t->arq != NULL) {
+    fclose(t->arq);
+    t->n_arquivo++;
+  }
+  if (t->n_arquivo >= N_ARQUIVOS_TELEMETRIA) {
+    snprintf(nome, sizeof(nome), "%s_%06d.bin", t->prefixo, t->n_arquivo - N_ARQUIVOS_TELEMETRIA);
+    remove(nome);
+  }
+  snprintf(nome, sizeof(nome), "%s_%06d.bin", t->prefixo, t->n_arquivo);
+  t->arq = fopen(nome, "wb");
+  if (t->arq == NULL) return false;
+  cabecalho_telemetria_t c = { .versao = VERSAO_TELEMETRIA, .tamanho_evento = sizeof(evento_t) };
+  memcpy(c.marca, MARCA_TELEMETRIA, sizeof(c.marca));
+  t->tam_arq = fwrite(&c, sizeof(c), 1, t->arq) * sizeof(c);
+  return true;
+}
+
+// grava eventos, trocando de arquivo quando passa do tamanho máximo
+static void grava_eventos(telemetria_t *t, const evento_t *eventos, int n)
+{
+  if (t->arq == NULL) return;
+  if (t->tam_arq + (long)(n * sizeof(evento_t)) > TAM_ARQUIVO_TELEMETRIA && !troca_arquivo(t)) return;
+  t->tam_arq += fwrite(eventos, sizeof(evento_t), n, t->arq) * sizeof(evento_t);
+  t->eventos_gravados += n;
+}
+
+// esvazia o anel em lotes; retorna quantos eventos foram gravados
+static int esvazia_anel(telemetria_t *t)
+{
+  evento_t lote[256];
+  int total = 0;
+  uint64_t lidos = atomic_load_explicit(&t->lidos, memory_order_relaxed);
+  uint64_t escritos = atomic_load_explicit(&t->escritos, memory_order_acquire);
+
+  while (lidos < escritos) {
+    int n = 0;
+    while (lidos < escritos && n < 256)
+      lote[n++] = t->anel[lidos++ & (TAM_ANEL_TELEMETRIA - 1)];
+    // devolve as posições ao produtor antes de gravar
+    atomic_store_explicit(&t->lidos, lidos, memory_order_release);
+    grava_eventos(t, lote, n);
+    total += n;
+  }
+
+  // os descartes viram um evento, gravado pela própria thread da telemetria
+  uint64_t descartados = atomic_load_explicit(&t->descartados, memory_order_relaxed);
+  if (descartados != t->descartes_gravados) {
+    uint64_t novos = descartados - t->descartes_gravados;
+    evento_t e = { .tipo = evento_descartes, .partida = novos > UINT32_MAX ? UINT32_MAX : novos };
+    grava_eventos(t, &e, 1);
+    t->descartes_gravados = descartados;
+  }
+  if (total > 0 && t->arq != NULL) fflush(t->arq);
+  return total;
+}
+
+// laço da thread da telemetria
+static void *grava_telemetria(void *arg)
+{
+  telemetria_t *t = arg;
+  struct timespec espera = { 0, INTERVALO_TELEMETRIA * 1e9 };
+  while (!atomic_load(&t->parar)) {
+    esvazia_anel(t);
+    nanosleep(&espera, NULL);
+  }
+  esvazia_anel(t);
+  return NULL;
+}
+
+bool inicia_telemetria(telemetria_t *t, const char *prefixo)
+{
+  memset(t, 0, sizeof(*t));
+  t->prefixo = prefixo;
+  if (!troca_arquivo(t)) return false;
+  if (pthread_create(&t->thread, NULL, grava_telemetria, t) != 0) {
+    fclose(t->arq);
+    t->arq = NULL;
+    return false;
+  }
+  return true;
+}
+
+bool registra_evento(telemetria_t *t, const evento_t *e)
+{
+  uint64_t escritos = atomic_load_explicit(&t->escritos, memory_order_relaxed);
+  if (escritos - atomic_load_explicit(&t->lidos, memory_order_acquire) == TAM_ANEL_TELEMETRIA) {
+    atomic_fetch_add_explicit(&t->descartados, 1, memory_order_relaxed);
+    return false;
+  }
+  t->anel[escritos & (TAM_ANEL_TELEMETRIA - 1)] = *e;
+  atomic_store_explicit(&t->escritos, escritos + 1, memory_order_release);
+  return true;
+}
+
+uint64_t termina_telemetria(telemetria_t *t)
+{
+  atomic_store(&t->parar, true);
+  pthread_join(t->thread, NULL);
+  if (t->arq != NULL) fclose(t->arq);
+  t->arq = NULL;
+  return atomic_load(&t->descartados);
+}
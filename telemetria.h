@@ -0,0 +1,116 @@
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+/**
+ * @file telemetria.h
+ *
+ * @brief Eventos das partidas (início, jogadas, fim) gravados em um registro binário.
+ *
+ * Quem joga só copia o evento para um anel de tamanho fixo, sem travas e sem
+ * acesso a arquivo; uma thread em segundo plano esvazia o anel em lotes e grava
+ * os eventos em arquivos numerados, trocando de arquivo quando ele passa do
+ * tamanho máximo e apagando os mais antigos. Com o anel cheio, o evento é
+ * descartado em vez de esperar, e a contagem de descartados é gravada no registro
+ * como um evento próprio.
+ *
+ * Há um só produtor por vez (a thread que joga) e um só consumidor (a thread da telemetria).
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define MARCA_TELEMETRIA "KLTELEM1"
+#define VERSAO_TELEMETRIA 1
+// eventos no anel (potência de 2)
+#define TAM_ANEL_TELEMETRIA 4096
+// tamanho máximo de cada arquivo e quantos arquivos são mantidos
+#define TAM_ARQUIVO_TELEMETRIA (4 << 20)
+#define N_ARQUIVOS_TELEMETRIA 8
+// intervalo entre duas esvaziadas do anel, em segundos
+#define INTERVALO_TELEMETRIA 0.05
+
+typedef enum {
+  evento_inicio,
+  evento_jogada,
+  evento_fim,
+  // eventos descartados com o anel cheio desde o último evento deste tipo
+  evento_descartes
+} tipo_evento_t;
+
+// um evento (32 bytes)
+typedef struct {
+  // relógio do jogo no momento do evento
+  double instante;
+  // pontos da partida depois do evento
+  float pontos;
+  // pontos ganhos na jogada e a parte deles que veio do bônus
+  float delta_pontos;
+  float bonus;
+  // segundos desde a jogada anterior, de qualquer tipo (ou desde o início da partida)
+  float tempo_pensando;
+  // número da partida desde que a telemetria foi iniciada; em evento_descartes, quantos eventos foram descartados
+  uint32_t partida;
+  uint8_t tipo;
+  // pilhas de origem e destino da jogada (índices de pilha_do_jogo()); no fim, origem é 1 se venceu
+  int8_t origem;
+  int8_t destino;
+  // cartas movidas na jogada
+  uint8_t n_cartas;
+} evento_t;
+
+// cabeçalho de cada arquivo do registro (16 bytes)
+typedef struct {
+  char marca[8];
+  uint32_t versao;
+  uint32_t tamanho_evento;
+} cabecalho_telemetria_t;
+
+typedef struct {
+  evento_t anel[TAM_ANEL_TELEMETRIA];
+  // eventos escritos pelo produtor e lidos pelo consumidor desde o início
+  _Atomic uint64_t escritos;
+  _Atomic uint64_t lidos;
+  _Atomic uint64_t descartados;
+  _Atomic bool parar;
+  // só da thread da telemetria
+  uint64_t descartes_gravados;
+  const char *prefixo;
+  FILE *arq;
+  long tam_arq;
+  int n_arquivo;
+  uint64_t eventos_gravados;
+  pthread_t thread;
+} telemetria_t;
+
+/**
+ * @brief Inicia a telemetria e a thread que grava os eventos.
+ *
+ * Os arquivos se chamam prefixo_000000.bin, prefixo_000001.bin, ...
+ *
+ * @param t Ponteiro para a telemetria.
+ * @param prefixo Início do nome dos arquivos.
+ * @return true se a telemetria foi iniciada, false caso contrário.
+ */
+bool inicia_telemetria(telemetria_t *t, const char *prefixo);
+
+/**
+ * @brief Coloca um evento no anel, sem esperar.
+ *
+ * @param t Ponteiro para a telemetria.
+ * @param e Ponteiro para o evento.
+ * @return true se o evento entrou no anel, false se foi descartado.
+ */
+bool registra_evento(telemetria_t *t, const evento_t *e);
+
+/**
+ * @brief Grava os eventos que ainda estão no anel e termina a thread da telemetria.
+ *
+ * @param t Ponteiro para a telemetria.
+ * @return O número de eventos descartados.
+ */
+uint64_t termina_telemetria(telemetria_t *t);
+
+#endif // TELEMETRIA_H
@@ -0,0 +1,452 @@
+/**
+ * @file verifica.c
+ *
+ * @brief Confere registros de partidas enviados para o placar.
+ *
+ * Cada linha de um registro tem a semente da distribuição, a pontuação e o
+ * resultado declarados e as jogadas, cada uma com o instante (em segundos desde
+ * a distribuição) em que foi digitada:
+ *
+ *   semente pontos vitoria instante:comando instante:comando ...
+ *
+ * As partidas são refeitas pelo motor sem janela, dividido entre as threads, com
+ * o relógio do jogo lendo os instantes registrados, então a pontuação é recalculada
+ * com o mesmo bônus do jogo. Registros malformados, instantes fora de ordem,
+ * jogadas depois do fim e pontuação ou resultado diferentes do recalculado vão
+ * para o relatório, na ordem do arquivo, à medida que os lotes são conferidos.
+ *
+ * Com -g gera registros de partidas gulosas, com instantes sorteados, adulterando
+ * uma fração deles (-f, em porcentagem) para conferir o verificador. Sem opções,
+ * gera e depois confere.
+ *
+ * Uso: ./verifica [-p threads] [-r relatorio] [-a] [registros]
+ *      ./verifica -g partidas [-s semente] [-f fraude] [-o registros]
+ *   -a põe também as partidas corretas no relatório.
+ *
+ * @author Luiz Felipe Cavalheiro
+ */
+
+#include "funcoes.h"
+#include <math.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// limites das partidas gulosas geradas com -g
+#define MAX_JOGADAS_GERADAS 1000
+#define MAX_RECICLAGENS_GERADAS 3
+// diferença de pontuação aceita, já que o registro guarda duas casas decimais
+#define TOLERANCIA_PONTOS 0.01
+// lotes de linhas em conferência ao mesmo tempo e tamanho de cada um
+#define N_LOTES 64
+#define TAM_LOTE (256 << 10)
+
+// lote de linhas do registro e o relatório correspondente
+typedef struct {
+  char *texto;
+  size_t tam_texto;
+  size_t cap_texto;
+  long primeira_linha;
+  char *relatorio;
+  size_t tam_relatorio;
+  size_t cap_relatorio;
+  long partidas;
+  long suspeitas;
+  bool conferido;
+} lote_t;
+
+// fila circular de lotes: main preenche e escreve, as threads conferem
+typedef struct {
+  lote_t lotes[N_LOTES];
+  long cabeca;
+  long proximo;
+  long cauda;
+  bool fim;
+  bool todas;
+  pthread_mutex_t trava;
+  pthread_cond_t tem_lote;
+  pthread_cond_t lote_conferido;
+} verificacao_t;
+
+// instante registrado da jogada em curso, um por thread
+static __thread double instante_registrado;
+
+// relógio do jogo que devolve o instante registrado
+static double relogio_registrado(void)
+{
+  return instante_registrado;
+}
+
+// relógio monotônico, em segundos
+static double agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// acrescenta uma linha formatada ao relatório do lote
+static void relata(lote_t *l, const char *formato, ...)
+{
+  va_list args;
+  while (true) {
+    va_start(args, formato);
+    int n = vsnprintf(l->relatorio + l->tam_relatorio, l->cap_relatorio - l->tam_relatorio, formato, args);
+    va_end(args);
+    if (l->tam_relatorio + n < l->cap_relatorio) {
+      l->tam_relatorio += n;
+      return;
+    }
+    l->cap_relatorio = 2 * l->cap_relatorio + n;
+    l->relatorio = realloc(l->relatorio, l->cap_relatorio);
+    assert(l->relatorio != NULL);
+  }
+}
+
+// refaz a partida de uma linha e relata o que não confere; a linha termina em '\0'
+static void confere_linha(jogo_t *j, char *linha, long numero, lote_t *l, bool todas)
+{
+  char *p = linha, *fim;
+  while (*p == ' ' || *p == '\t') p++;
+  if (*p == '\0' || *p == '#') return;
+  l->partidas++;
+
+  uint64_t semente = strtoull(p, &fim, 10);
+  bool ok = fim != p;
+  double pontos = strtod(p = fim, &fim);
+  ok = ok && fim != p;
+  long vitoria = strtol(p = fim, &fim, 10);
+  ok = ok && fim != p && (vitoria == 0 || vitoria == 1);
+  if (!ok) {
+    l->suspeitas++;
+    relata(l, "linha %ld: registro malformado\n", numero);
+    return;
+  }
+
+  instante_registrado = 0;
+  inicia_pilhas_jogo_com_semente(j, semente);
+  double anterior = 0;
+  int k = 0;
+  for (p = fim; ; k++) {
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == '\0') break;
+    double instante = strtod(p, &fim);
+    if (fim == p || *fim != ':') {
+      l->suspeitas++;
+      relata(l, "linha %ld (semente %llu): jogada %d malformada\n", numero, (unsigned long long)semente, k + 1);
+      return;
+    }
+    p = fim + 1;
+    char comando[MAX_CHAR_CMD+1];
+    int n = 0;
+    while (*p != '\0' && *p != ' ' && *p != '\t') {
+      if (n == MAX_CHAR_CMD) {
+        l->suspeitas++;
+        relata(l, "linha %ld (semente %llu): jogada %d malformada\n", numero, (unsigned long long)semente, k + 1);
+        return;
+      }
+      comando[n++] = *p++;
+    }
+    comando[n] = '\0';
+
+    if (!(instante >= anterior)) {
+      l->suspeitas++;
+      relata(l, "linha %ld (semente %llu): jogada %d volta no tempo (%.3f s depois de %.3f s)\n", numero,
+             (unsigned long long)semente, k + 1, instante, anterior);
+      return;
+    }
+    if (venceu_jogo(j) || j->sair) {
+      l->suspeitas++;
+      relata(l, "linha %ld (semente %llu): jogada %d depois do fim da partida\n", numero,
+             (unsigned long long)semente, k + 1);
+      return;
+    }
+    // como no jogo, comandos inválidos não mudam nada
+    anterior = instante_registrado = instante;
+    realiza_jogada(j, comando);
+  }
+
+  bool venceu = venceu_jogo(j);
+  if (venceu != (vitoria == 1)) {
+    l->suspeitas++;
+    relata(l, "linha %ld (semente %llu): %s declarada, mas a partida %s\n", numero, (unsigned long long)semente,
+           vitoria ? "vitória" : "derrota", venceu ? "foi vencida" : "não foi vencida");
+  } else if (fabs(pontos - j->pontos) > TOLERANCIA_PONTOS) {
+    l->suspeitas++;
+    relata(l, "linha %ld (semente %llu): %.2f pontos declarados, %.2f recalculados\n", numero,
+           (unsigned long long)semente, pontos, j->pontos);
+  } else if (todas) {
+    relata(l, "linha %ld (semente %llu): ok, %.2f pontos em %d jogadas%s\n", numero, (unsigned long long)semente,
+           j->pontos, k, venceu ? ", vitória" : "");
+  }
+}
+
+// confere todas as linhas de um lote
+static void confere_lote(jogo_t *j, lote_t *l, bool todas)
+{
+  l->tam_relatorio = 0;
+  l->partidas = l->suspeitas = 0;
+  long numero = l->primeira_linha;
+  char *linha = l->texto, *fim = l->texto + l->tam_texto;
+  while (linha < fim) {
+    char *nl = memchr(linha, '\n', fim - linha);
+    if (nl == NULL) nl = fim;
+    *nl = '\0';
+    confere_linha(j, linha, numero++, l, todas);
+    linha = nl + 1;
+  }
+}
+
+// laço de uma thread: pega o próximo lote da fila, confere e marca como conferido
+static void *conferente(void *arg)
+{
+  verificacao_t *v = arg;
+  jogo_t *j = malloc(sizeof(jogo_t));
+  assert(j != NULL);
+  j->relogio = relogio_registrado;
+
+  while (true) {
+    pthread_mutex_lock(&v->trava);
+    while (v->proximo == v->cabeca && !v->fim)
+      pthread_cond_wait(&v->tem_lote, &v->trava);
+    if (v->proximo == v->cabeca) {
+      pthread_mutex_unlock(&v->trava);
+      break;
+    }
+    lote_t *l = &v->lotes[v->proximo++ % N_LOTES];
+    pthread_mutex_unlock(&v->trava);
+
+    confere_lote(j, l, v->todas);
+
+    pthread_mutex_lock(&v->trava);
+    l->conferido = true;
+    pthread_cond_broadcast(&v->lote_conferido);
+    pthread_mutex_unlock(&v->trava);
+  }
+
+  free(j);
+  return NULL;
+}
+
+// escreve o lote mais antigo, se já foi conferido (ou esperando por ele); retorna false se não escreveu
+static bool escreve_lote(verificacao_t *v, FILE *relatorio, bool espera, long *partidas, long *suspeitas)
+{
+  pthread_mutex_lock(&v->trava);
+  lote_t *l = &v->lotes[v->cauda % N_LOTES];
+  while (v->cauda < v->cabeca && !l->conferido && espera)
+    pthread_cond_wait(&v->lote_conferido, &v->trava);
+  bool pronto = v->cauda < v->cabeca && l->conferido;
+  pthread_mutex_unlock(&v->trava);
+  if (!pronto) return false;
+
+  fwrite(l->relatorio, 1, l->tam_relatorio, relatorio);
+  fflush(relatorio);
+  *partidas += l->partidas;
+  *suspeitas += l->suspeitas;
+
+  pthread_mutex_lock(&v->trava);
+  v->cauda++;
+  pthread_mutex_unlock(&v->trava);
+  return true;
+}
+
+// lê linhas do registro até encher o lote; retorna o número de linhas lidas
+static long preenche_lote(lote_t *l, FILE *arq, char **linha, size_t *cap_linha)
+{
+  long n = 0;
+  ssize_t tam;
+  l->tam_texto = 0;
+  while (l->tam_texto < TAM_LOTE && (tam = getline(linha, cap_linha, arq)) > 0) {
+    if (l->tam_texto + tam + 1 > l->cap_texto) {
+      l->cap_texto = 2 * (l->tam_texto + tam + 1);
+      l->texto = realloc(l->texto, l->cap_texto);
+      assert(l->texto != NULL);
+    }
+    memcpy(l->texto + l->tam_texto, *linha, tam);
+    l->tam_texto += tam;
+    if ((*linha)[tam - 1] != '\n') l->texto[l->tam_texto++] = '\n';
+    n++;
+  }
+  return n;
+}
+
+// confere um arquivo de registros, escrevendo o relatório em ordem
+static bool verifica(const char *nome, const char *nome_relatorio, int n_threads, bool todas)
+{
+  FILE *arq = fopen(nome, "r");
+  if (arq == NULL) {
+    fprintf(stderr, "não foi possível abrir %s\n", nome);
+    return false;
+  }
+  FILE *relatorio = nome_relatorio != NULL ? fopen(nome_relatorio, "w") : stdout;
+  if (relatorio == NULL) {
+    fprintf(stderr, "não foi possível criar %s\n", nome_relatorio);
+    fclose(arq);
+    return false;
+  }
+
+  verificacao_t *v = calloc(1, sizeof(verificacao_t));
+  assert(v != NULL);
+  v->todas = todas;
+  pthread_mutex_init(&v->trava, NULL);
+  pthread_cond_init(&v->tem_lote, NULL);
+  pthread_cond_init(&v->lote_conferido, NULL);
+  pthread_t threads[n_threads];
+  for (int i = 0; i < n_threads; i++)
+    pthread_create(&threads[i], NULL, conferente, v);
+
+  char *linha = NULL;
+  size_t cap_linha = 0;
+  long linhas = 1, partidas = 0, suspeitas = 0;
+  double inicio = agora();
+  while (true) {
+    // escreve os lotes já conferidos e, com a fila cheia, espera o mais antigo
+    while (escreve_lote(v, relatorio, v->cabeca - v->cauda == N_LOTES, &partidas, &suspeitas))
+      ;
+    lote_t *l = &v->lotes[v->cabeca % N_LOTES];
+    l->primeira_linha = linhas;
+    l->conferido = false;
+    long n = preenche_lote(l, arq, &linha, &cap_linha);
+    if (n == 0) break;
+    linhas += n;
+    pthread_mutex_lock(&v->trava);
+    v->cabeca++;
+    pthread_cond_signal(&v->tem_lote);
+    pthread_mutex_unlock(&v->trava);
+  }
+  pthread_mutex_lock(&v->trava);
+  v->fim = true;
+  pthread_cond_broadcast(&v->tem_lote);
+  pthread_mutex_unlock(&v->trava);
+  while (escreve_lote(v, relatorio, true, &partidas, &suspeitas))
+    ;
+  for (int i = 0; i < n_threads; i++)
+    pthread_join(threads[i], NULL);
+  double duracao = agora() - inicio;
+
+  bool ok = !ferror(arq);
+  fclose(arq);
+  if (relatorio != stdout) ok = fclose(relatorio) == 0 && ok;
+  printf("partidas conferidas: %ld (%d threads)\n", partidas, n_threads);
+  printf("suspeitas:           %ld\n", suspeitas);
+  printf("conferência:         %.3f s (%.0f partidas/min)\n", duracao, partidas / duracao * 60);
+
+  for (int i = 0; i < N_LOTES; i++) {
+    free(v->lotes[i].texto);
+    free(v->lotes[i].relatorio);
+  }
+  pthread_mutex_destroy(&v->trava);
+  pthread_cond_destroy(&v->tem_lote);
+  pthread_cond_destroy(&v->lote_conferido);
+  free(v);
+  free(linha);
+  return ok;
+}
+
+// gera registros de partidas gulosas, adulterando uma fração deles
+static bool gera(const char *nome, long n_partidas, uint64_t semente, double fraude)
+{
+  FILE *arq = fopen(nome, "w");
+  if (arq == NULL) {
+    fprintf(stderr, "não foi possível criar %s\n", nome);
+    return false;
+  }
+  jogo_t *j = malloc(sizeof(jogo_t));
+  assert(j != NULL);
+  j->relogio = relogio_registrado;
+  gerador_t g;
+  inicia_gerador(&g, semente);
+  jogada_t possiveis[N_MAX_JOGADAS];
+  double instantes[MAX_JOGADAS_GERADAS];
+  char comandos[MAX_JOGADAS_GERADAS][MAX_CHAR_CMD+1];
+  long adulteradas = 0;
+
+  for (long k = 0; k < n_partidas; k++) {
+    long milissegundos = 0;
+    instante_registrado = 0;
+    inicia_pilhas_jogo_com_semente(j, semente + k);
+    int n = 0, reciclagens = 0;
+    while (n < MAX_JOGADAS_GERADAS && !venceu_jogo(j)) {
+      int n_possiveis = gera_jogadas(j, possiveis);
+      int i = escolhe_jogada_gulosa(j, possiveis, n_possiveis, MAX_RECICLAGENS_GERADAS - reciclagens, &g);
+      if (i < 0) break;
+      if (possiveis[i].origem == PILHA_DESCARTE && possiveis[i].destino == PILHA_MONTE)
+        reciclagens++;
+      // entre meio segundo e dez segundos por jogada, em milissegundos como no registro
+      milissegundos += 500 + sorteia_64(&g) % 9500;
+      instante_registrado = milissegundos / 1000.0;
+      instantes[n] = instante_registrado;
+      descricao_jogada(possiveis[i], comandos[n]);
+      aplica_jogada(j, possiveis[i]);
+      n++;
+    }
+
+    double pontos = j->pontos;
+    int vitoria = venceu_jogo(j);
+    if (sorteia_64(&g) % 1000000 < fraude * 10000) {
+      adulteradas++;
+      // aumenta a pontuação, declara uma vitória que não houve ou troca dois instantes
+      switch (sorteia_64(&g) % 3) {
+        case 0: pontos += pontos * 0.05 + 1; break;
+        case 1: if (!vitoria) vitoria = 1; else pontos += 1; break;
+        case 2:
+          if (n > 1) {
+            int i = sorteia_64(&g) % (n - 1);
+            double t = instantes[i];
+            instantes[i] = instantes[i + 1];
+            instantes[i + 1] = t;
+          } else {
+            pontos += 1;
+          }
+          break;
+      }
+    }
+
+    fprintf(arq, "%llu %.2f %d", (unsigned long long)(semente + k), pontos, vitoria);
+    for (int i = 0; i < n; i++)
+      fprintf(arq, " %.3f:%s", instantes[i], comandos[i]);
+    fputc('\n', arq);
+  }
+
+  bool ok = fclose(arq) == 0;
+  printf("partidas geradas:    %ld\n", n_partidas);
+  printf("adulteradas:         %ld\n", adulteradas);
+  free(j);
+  return ok;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *nome = "registros.log";
+  const char *nome_relatorio = NULL;
+  long n_partidas = 0;
+  uint64_t semente = 1;
+  double fraude = 1;
+  int n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  bool todas = false;
+  int opcao;
+
+  while ((opcao = getopt(argc, argv, "g:s:f:o:p:r:a")) != -1) {
+    switch (opcao) {
+      case 'g': n_partidas = atol(optarg); break;
+      case 's': semente = strtoull(optarg, NULL, 10); break;
+      case 'f': fraude = atof(optarg); break;
+      case 'o': nome = optarg; break;
+      case 'p': n_threads = atoi(optarg); break;
+      case 'r': nome_relatorio = optarg; break;
+      case 'a': todas = true; break;
+      default:
+        fprintf(stderr, "uso: %s [-p threads] [-r relatorio] [-a] [registros]\n"
+                        "     %s -g partidas [-s semente] [-f fraude] [-o registros]\n", argv[0], argv[0]);
+        return 1;
+    }
+  }
+  if (n_threads < 1) n_threads = 1;
+
+  if (optind < argc)
+    return verifica(argv[optind], nome_relatorio, n_threads, todas) ? 0 : 1;
+  if (n_partidas > 0)
+    return gera(nome, n_partidas, semente, fraude) ? 0 : 1;
+  bool ok = gera(nome, 200000, semente, fraude);
+  return ok && verifica(nome, nome_relatorio, n_threads, todas) ? 0 : 1;
+}